@@ -9,132 +9,71 @@ if [ -z ${YANNKINS_HOME} ]; then
     export YANNKINS_HOME=${DEFAULT_DIR}
 fi
 
-# Where projects are defined
-PROJECTS_HOME="${YANNKINS_HOME}/projects"
+# Analysis program
+YANNKINS_RUN="yannkins-run"
 
-# Where are the repos local copy
-REPOS_HOME="${YANNKINS_HOME}/repos"
-
-#SVN command
-SVN="svn"
-
-#Task execution program
-TACHE="tache"
-
-# crossing projects
-for p in ${PROJECTS_HOME}/*; do
-    if [ $p != "${PROJECTS_HOME}/*" ]; then
-
-        #Reinit
-        PROJECT_NAME=""
-        SVN_DEPOT=""
-        SVN_USER=""
-        SVN_PASSWD=""
-        GIT_DEPOT=""
-
-        . $p
-
-        if [ ${PROJECT_NAME}_ == _ ]; then
-            printf "File %s : Project name missing\n" "$p"
-            continue
-        fi
-
-        printf "Analysis of project %s\n" "${PROJECT_NAME}"
-
-        # Versionning System : NONE, GIT, or SVN
-        VS="NONE"
-        if [ ${SVN_DEPOT}_ != _ ]; then
-            VS="SVN"
-        else
-            if [ ${GIT_DEPOT}_ != _ ]; then
-                VS="GIT"
-            fi
-        fi
-
-        # Checkout/clone of the project
-
-        if [ ${VS} == "NONE" ]; then
-            printf "Project %s : Repository not specified\n" "$PROJECT_NAME"
-            continue
-        fi
+# Number of tasks run at the same time (default : number of processors)
+RUN_OPTS=""
+if [ ${YANNKINS_JOBS}_ != _ ]; then
+    RUN_OPTS="-j ${YANNKINS_JOBS}"
+fi
 
-        PRES=0
-        if [ ${VS} == "SVN" ]; then
-            SVN="svn"
-            if [ ${SVN_USER}_ != _ ]; then
-                SVN="${SVN} --username '${SVN_USER}'"
-            fi
+# Tasks executed at the same time by resource pool, like "fetch=4,build=2,test=2"
+if [ ${YANNKINS_POOLS}_ != _ ]; then
+    RUN_OPTS="${RUN_OPTS} --pools ${YANNKINS_POOLS}"
+fi
 
-            if [ ${SVN_PASSWD}_ != _ ]; then
-                SVN="${SVN} --password '${SVN_PASSWD}'"
-            fi
+# Tokens of the make jobserver shared by all the tasks (default : number of processors)
+if [ ${YANNKINS_MAKE_JOBS}_ != _ ]; then
+    RUN_OPTS="${RUN_OPTS} -m ${YANNKINS_MAKE_JOBS}"
+fi
 
-            if [ ! -d ${REPOS_HOME}/${PROJECT_NAME} ]; then
-                MSG="Checkout of repository\n"
-                COMMAND="${SVN} co ${SVN_DEPOT} ${PROJECT_NAME}"
-            else
-                PRES=1
-                MSG="Udpate repository\n"
-                COMMAND="${SVN} update"
-            fi
-        fi
+# Default wall clock limit of a task, in seconds
+if [ ${YANNKINS_TIMEOUT}_ != _ ]; then
+    RUN_OPTS="${RUN_OPTS} -t ${YANNKINS_TIMEOUT}"
+fi
 
-        if [ ${VS} == "GIT" ]; then
-            if [ ! -d ${REPOS_HOME}/${PROJECT_NAME} ]; then
-                MSG="Clone of repository\n"
-                COMMAND="git clone --recursive ${GIT_DEPOT} ${PROJECT_NAME}"
-            else
-                PRES=1
-                MSG="Pull repository\n"
-                COMMAND="git pull && git submodule update"
-            fi
-        fi
+# Console outputs : bytes kept at the beginning and the end, compression
+if [ ${YANNKINS_CONSOLE_HEAD}_ != _ ]; then
+    RUN_OPTS="${RUN_OPTS} --head ${YANNKINS_CONSOLE_HEAD}"
+fi
+if [ ${YANNKINS_CONSOLE_TAIL}_ != _ ]; then
+    RUN_OPTS="${RUN_OPTS} --tail ${YANNKINS_CONSOLE_TAIL}"
+fi
+if [ ${YANNKINS_CONSOLE_COMPRESS}_ == yes_ ]; then
+    RUN_OPTS="${RUN_OPTS} --compress"
+fi
 
-        printf "${MSG}"
-        [ ! -d ${REPOS_HOME} ] && mkdir -p ${REPOS_HOME}
-        cd ${REPOS_HOME}
-        if [ $PRES -eq 1 ]; then
-            cd ${PROJECT_NAME}
-        fi
-        printf "%s\n" "${COMMAND}"
-        ${TACHE} "SVN_CHECKOUT_${PROJECT_NAME}" "${COMMAND}"
-        cd ${YANNKINS_HOME}
+# Memory for the expected peaks of the running tasks
+if [ ${YANNKINS_MEMORY}_ != _ ]; then
+    RUN_OPTS="${RUN_OPTS} --memory ${YANNKINS_MEMORY}"
+fi
 
-        # Compiling project
-        printf "Compilation\n"
-        COMP=$(echo -n ${COMPIL} | wc -c)
-        if [ ${COMP} -gt 0 ]; then
-            cd ${REPOS_HOME}/${PROJECT_NAME}
-            ${TACHE} COMPILATION_${PROJECT_NAME} "${COMPIL}"
-            cd -
-        fi
+# Run the compilation and the tests even if the sources did not change
+if [ ${YANNKINS_FORCE}_ == yes_ ]; then
+    RUN_OPTS="${RUN_OPTS} --force"
+fi
 
-        # tests
-        printf "Tests\n"
-        TESTS=$(echo -n ${TESTS_UNI} | wc -c)
-        if [ ${TESTS} -gt 0 ]; then
-            cd ${REPOS_HOME}/${PROJECT_NAME}
-            ${TACHE} TESTS_${PROJECT_NAME} "${TESTS_UNI}"
-            cd -
-        fi
+# Clone the git projects from shared local mirrors
+if [ ${YANNKINS_GIT_MIRRORS}_ == yes_ ]; then
+    RUN_OPTS="${RUN_OPTS} --git-mirrors"
+fi
 
-        # Logs SVN
-        printf "Checking repository logs\n"
+# Find the state of the tests of each new commit of the git projects
+if [ ${YANNKINS_SPLIT_BATCHES}_ == yes_ ]; then
+    RUN_OPTS="${RUN_OPTS} --split-batches"
+fi
 
-        if [ ${VS} == "SVN" ]; then
-            eval "${SVN} log -l 10 --xml ${SVN_DEPOT} > svnlogl10.xml"
-            convert_log -i svnlogl10.xml -o ${YANNKINS_HOME}/log/SVNLOG_${PROJECT_NAME}
-        fi
+# Send the tasks waiting for a worker to the agents connected on this address
+if [ -n "${YANNKINS_AGENTS}" ]; then
+    RUN_OPTS="${RUN_OPTS} --agents ${YANNKINS_AGENTS}"
+fi
 
-        if [ ${VS} == "GIT" ]; then
-            cd ${REPOS_HOME}/${PROJECT_NAME}
-            printf "#;author;date;commentaries\n" > ${YANNKINS_HOME}/log/GITLOG_${PROJECT_NAME}
-            git log -n 10 --pretty=format:"%h;%an;%ci;%s" >> ${YANNKINS_HOME}/log/GITLOG_${PROJECT_NAME}
-            cd -
-        fi
-    fi
-done
+# The file of the secret the agents must give to connect on a TCP address
+if [ -n "${YANNKINS_AGENTS_SECRET}" ]; then
+    RUN_OPTS="${RUN_OPTS} --agents-secret ${YANNKINS_AGENTS_SECRET}"
+fi
 
-# make report
-printf "Creating projects' pages\n"
-cree_page
+# Run the tasks of all the projects, then create the projects' pages
+cd ${YANNKINS_HOME}
+exec ${YANNKINS_RUN} ${RUN_OPTS}
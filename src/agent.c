@@ -0,0 +1,738 @@
+/**
+ * \file agent.c
+ * \brief Execute the tasks sent by a Yannkins scheduler.
+ *
+ * The agent connects to a scheduler ("yannkins-run --agents ADDRESS" or
+ * "tache --agents ADDRESS"), where ADDRESS is the path of a Unix socket
+ * or "HOST:PORT", and runs up to "-j N" tasks at the same time. The
+ * command of a task is executed in a shell, in the working directory of
+ * the task, which must have the same path as on the scheduler's machine.
+ * The console output is sent back while the task runs, then its exit
+ * status and the resources it used : the scheduler writes them in the
+ * same files as for its own tasks. The wall clock and CPU time limits of
+ * the tasks are checked here : the process group of a task exceeding one
+ * of them is killed, and its result is TIMEOUT.
+ *
+ * The agent gives the scheduler its memory for the tasks ("--memory", the
+ * memory of the machine by default) : a task is only sent to the agent if
+ * the peaks of memory expected for its running tasks fit in it. The tasks
+ * share a make jobserver of "-m N" tokens, the number of processors by
+ * default, as the tasks of the scheduler share its own : a task holds a
+ * token while it runs, if one is free.
+ *
+ * With "--secret FILE", the first line of FILE is given to the scheduler,
+ * which requires it on TCP.
+ *
+ * When the scheduler is not listening, or goes away, the agent tries to
+ * connect again every RETRY_DELAY seconds, until it receives SIGTERM or
+ * SIGINT.
+ */
+
+
+#define IC "Yannkins"
+
+/** \brief seconds between two connection attempts */
+#define RETRY_DELAY 5
+
+/** \brief seconds between two checks of the tasks' limits */
+#define TICK 1
+
+/** \brief bytes of console output sent at once */
+#define OUTPUT_SIZE 65536
+
+/** \brief a token of the make jobserver */
+#define TOKEN '+'
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include "logger.h"
+#include "agents.h"
+#include "procutil.h"
+
+
+/**
+ * \brief A worker of the agent, and the task it runs.
+ */
+typedef struct {
+    long id; /**< \brief identifier of the task given by the scheduler, 0 for a free worker */
+    pid_t pid; /**< \brief process group of the task */
+    int output; /**< \brief reading end of the console output, -1 when closed */
+    int timeout; /**< \brief wall clock limit in seconds, 0 for none */
+    int cpuLimit; /**< \brief CPU time limit in seconds, 0 for none */
+    double cpuTime; /**< \brief CPU time used by the task's process group */
+    struct timespec start; /**< \brief start time to compute the duration */
+    time_t killDate; /**< \brief when SIGTERM was sent to the task, or 0 */
+    int killed; /**< \brief TIMEOUT_RESULT or CANCELLED_RESULT when the task was killed, else 0 */
+    int token; /**< \brief 1 if the task holds a token of the jobserver */
+} yk_worker;
+
+
+/** \brief set when the agent is asked to stop */
+static volatile sig_atomic_t stopped = 0;
+
+/** \brief the pipe of the make jobserver, inherited by the tasks */
+static int tokens[2] = { -1, -1 };
+
+/** \brief non-blocking reading end of the jobserver, for the agent */
+static int tokenReader = -1;
+
+/** \brief number of tokens of the jobserver */
+static int nbTokens = 0;
+
+/** \brief number of tokens held by the running tasks */
+static int held = 0;
+
+/**
+ * Handler of SIGTERM and SIGINT.
+ */
+static void on_stop(int signum) {
+    (void) signum;
+    stopped = 1;
+}
+
+
+static void usage(char *prog) {
+    fprintf(stderr, "Execute the tasks of a %s scheduler\n", IC);
+    fprintf(stderr, "Usage : %s [OPTIONS] <ADDRESS>\n", prog);
+    fprintf(stderr, "  ADDRESS          the scheduler's Unix socket, or HOST:PORT\n");
+    fprintf(stderr, "  -j, --jobs       number of tasks executed at the same time\n");
+    fprintf(stderr, "  -m, --make-jobs  tokens of the make jobserver shared by the tasks, 0 for none\n");
+    fprintf(stderr, "  --memory <SIZE>  memory for the expected peaks of the running tasks\n");
+    fprintf(stderr, "  -n, --name       name of the agent in the scheduler's logs\n");
+    fprintf(stderr, "  -s, --secret     file whose first line is the secret of the scheduler\n");
+    exit(1);
+}
+
+
+/**
+ * Empty the jobserver and fill it again with all its tokens, when no task
+ * holds a token : the tokens taken by a killed make are never given back.
+ *
+ * \return 0 in case of success
+ */
+static int refill_tokens() {
+
+    char buffer[256];
+    char token = TOKEN;
+    int i;
+
+    while(read(tokenReader, buffer, sizeof(buffer)) > 0);
+
+    for(i = 0; i < nbTokens; i++) {
+        if(write(tokens[1], &token, 1) != 1) {
+            log_error("Can't fill the jobserver : %s", strerror(errno));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * Create the make jobserver of the tasks : a pipe filled with tokens,
+ * given to the tasks through MAKEFLAGS.
+ *
+ * \param makeJobs number of tokens, 0 for no jobserver
+ * \return 0 in case of success
+ */
+static int open_jobserver(int makeJobs) {
+
+    char path[64];
+    char *previous = getenv("MAKEFLAGS");
+    char *makeflags;
+
+    if(makeJobs <= 0) {
+        return 0;
+    }
+
+    // the descriptors are inherited by the tasks
+    if(pipe(tokens)) {
+        log_error("Can't create the jobserver : %s", strerror(errno));
+        return 1;
+    }
+
+    // a new open file description, the tasks keep a blocking one
+    sprintf(path, "/proc/self/fd/%d", tokens[0]);
+    tokenReader = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if(tokenReader == -1) {
+        log_error("Can't open %s : %s", path, strerror(errno));
+        return 1;
+    }
+
+    nbTokens = makeJobs;
+    if(refill_tokens()) {
+        return 1;
+    }
+
+    // the flags given by the user are kept, the last jobserver wins
+    if(previous == NULL) {
+        previous = "";
+    }
+    makeflags = malloc(strlen(previous) + 64);
+    sprintf(makeflags, "%s%s-j --jobserver-auth=%d,%d", previous, *previous ? " " : "", tokens[0], tokens[1]);
+    setenv("MAKEFLAGS", makeflags, 1);
+    free(makeflags);
+    return 0;
+}
+
+
+/**
+ * Give back the token of the jobserver held by a task.
+ *
+ * \param worker the worker of the task
+ */
+static void release_token(yk_worker *worker) {
+
+    char token = TOKEN;
+
+    if(!worker->token) {
+        return;
+    }
+    worker->token = 0;
+    held--;
+
+    if(held == 0) {
+        refill_tokens();
+    } else if(write(tokens[1], &token, 1) != 1) {
+        log_warning("Can't give back a token of the jobserver");
+    }
+}
+
+
+/**
+ * Start the command of a task in its own process group, its output going
+ * in a pipe.
+ *
+ * \param worker the free worker which will run the task
+ * \param workdir where to run the command, or NULL
+ * \param command the command to execute in a shell
+ * \return 0 if the task was started
+ */
+static int start_task(yk_worker *worker, const char *workdir, const char *command) {
+
+    char token;
+    int fds[2];
+
+    if(pipe(fds)) {
+        log_error("Can't create a pipe : %s", strerror(errno));
+        return 1;
+    }
+
+    worker->pid = fork();
+    if(worker->pid == -1) {
+        log_error("Fork failure : command \"%s\" not runned", command);
+        close(fds[0]);
+        close(fds[1]);
+        return 1;
+    }
+
+    if(worker->pid == 0) {
+        sigset_t sigchld;
+
+        setpgid(0, 0);
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGINT, SIG_DFL);
+        sigemptyset(&sigchld);
+        sigaddset(&sigchld, SIGCHLD);
+        sigprocmask(SIG_UNBLOCK, &sigchld, NULL);
+
+        dup2(fds[1], 1);
+        dup2(fds[1], 2);
+        close(fds[0]);
+        close(fds[1]);
+        if(workdir != NULL && chdir(workdir)) {
+            fprintf(stderr, "Can't change directory to %s : %s\n", workdir, strerror(errno));
+            _exit(1);
+        }
+        execl("/bin/sh", "sh", "-c", command, (char *) NULL);
+        _exit(127);
+    }
+
+    // also done here to avoid a race with a kill of the group
+    setpgid(worker->pid, worker->pid);
+
+    close(fds[1]);
+    // the next tasks must not inherit the output of this one
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    worker->output = fds[0];
+    clock_gettime(CLOCK_MONOTONIC, &worker->start);
+    worker->cpuTime = 0;
+    worker->killDate = 0;
+    worker->killed = 0;
+
+    // the scheduler already chose to start the task : it runs without a token if none is free
+    worker->token = tokenReader != -1 && read(tokenReader, &token, 1) == 1;
+    held += worker->token;
+    return 0;
+}
+
+
+/**
+ * Send to the scheduler the console output of a task available in its
+ * pipe.
+ *
+ * \param fd the connection to the scheduler
+ * \param worker the worker running the task
+ */
+static void send_output(int fd, yk_worker *worker) {
+
+    char buffer[OUTPUT_SIZE];
+    char header[AGENT_HEADER_SIZE];
+    ssize_t nb;
+
+    if(worker->output == -1) {
+        return;
+    }
+
+    while((nb = read(worker->output, buffer, OUTPUT_SIZE)) > 0) {
+        sprintf(header, "OUT %ld", worker->id);
+        agents_send(fd, header, buffer, nb);
+    }
+
+    if(nb == 0 || (errno != EAGAIN && errno != EINTR)) {
+        close(worker->output);
+        worker->output = -1;
+    }
+}
+
+
+/**
+ * Ask the process group of a running task to stop.
+ *
+ * \param worker the worker running the task
+ * \param result why the task is stopped : TIMEOUT_RESULT or CANCELLED_RESULT
+ */
+static void stop_task(yk_worker *worker, int result) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    worker->killDate = now.tv_sec;
+    worker->killed = result;
+    kill(-worker->pid, SIGTERM);
+}
+
+
+/**
+ * Update the CPU time used by the process groups of the running tasks.
+ *
+ * \param workers the workers
+ * \param nbWorkers the number of workers
+ */
+static void update_cpu_times(yk_worker *workers, int nbWorkers) {
+
+    pid_t *groups = malloc(nbWorkers * sizeof(pid_t));
+    double *times = malloc(nbWorkers * sizeof(double));
+    int i;
+
+    // a free worker has no group
+    for(i = 0; i < nbWorkers; i++) {
+        groups[i] = workers[i].id != 0 ? workers[i].pid : -1;
+    }
+
+    proc_cpu_times(groups, times, nbWorkers);
+
+    for(i = 0; i < nbWorkers; i++) {
+        workers[i].cpuTime = times[i];
+    }
+
+    free(groups);
+    free(times);
+}
+
+
+/**
+ * Kill the running tasks which exceeded their limits.
+ *
+ * \param workers the workers
+ * \param nbWorkers the number of workers
+ */
+static void check_limits(yk_worker *workers, int nbWorkers) {
+
+    struct timespec now;
+    int i;
+
+    for(i = 0; i < nbWorkers; i++) {
+        if(workers[i].id != 0 && workers[i].cpuLimit > 0 && !workers[i].killDate) {
+            update_cpu_times(workers, nbWorkers);
+            break;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    for(i = 0; i < nbWorkers; i++) {
+
+        yk_worker *worker = &workers[i];
+
+        if(worker->id == 0) {
+            continue;
+        }
+
+        if(worker->killDate) {
+            if(now.tv_sec - worker->killDate >= KILL_DELAY) {
+                kill(-worker->pid, SIGKILL);
+            }
+        } else if(worker->timeout > 0 && now.tv_sec - worker->start.tv_sec >= worker->timeout) {
+            log_warning("Task %ld exceeded its wall clock limit (%d s) : killing it", worker->id, worker->timeout);
+            stop_task(worker, TIMEOUT_RESULT);
+        } else if(worker->cpuLimit > 0 && worker->cpuTime >= worker->cpuLimit) {
+            log_warning("Task %ld exceeded its CPU time limit (%d s) : killing it", worker->id, worker->cpuLimit);
+            stop_task(worker, TIMEOUT_RESULT);
+        }
+    }
+}
+
+
+/**
+ * Send the end of the terminated tasks to the scheduler.
+ *
+ * \param fd the connection to the scheduler
+ * \param workers the workers
+ * \param nbWorkers the number of workers
+ */
+static void end_tasks(int fd, yk_worker *workers, int nbWorkers) {
+
+    struct rusage rusage;
+    int wstatus;
+    pid_t pid;
+
+    while((pid = wait4(-1, &wstatus, WNOHANG, &rusage)) > 0) {
+
+        char header[AGENT_HEADER_SIZE];
+        struct timespec end;
+        yk_worker *worker = NULL;
+        int result;
+        int i;
+
+        for(i = 0; i < nbWorkers; i++) {
+            if(workers[i].id != 0 && workers[i].pid == pid) {
+                worker = &workers[i];
+            }
+        }
+        if(worker == NULL) {
+            continue;
+        }
+
+        // the output written just before the end
+        send_output(fd, worker);
+        if(worker->output != -1) {
+            close(worker->output);
+            worker->output = -1;
+        }
+
+        if(worker->killDate) {
+            kill(-worker->pid, SIGKILL);
+            result = worker->killed;
+        } else {
+            result = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 1;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        snprintf(header, sizeof(header), "END %ld %d %.3f %.3f %.3f %ld %ld %ld", worker->id, result,
+                (end.tv_sec - worker->start.tv_sec) + (end.tv_nsec - worker->start.tv_nsec) / 1e9,
+                rusage.ru_utime.tv_sec + rusage.ru_utime.tv_usec / 1e6,
+                rusage.ru_stime.tv_sec + rusage.ru_stime.tv_usec / 1e6,
+                rusage.ru_maxrss, rusage.ru_inblock, rusage.ru_oublock);
+        agents_send(fd, header, NULL, 0);
+
+        log_info("Task %ld finished with status %d", worker->id, result);
+        release_token(worker);
+        worker->id = 0;
+    }
+}
+
+
+/**
+ * Read the messages of the scheduler : start or cancel tasks.
+ *
+ * \param channel the connection to the scheduler
+ * \param workers the workers
+ * \param nbWorkers the number of workers
+ * \return 0 if the scheduler follows the protocol
+ */
+static int read_messages(yk_channel *channel, yk_worker *workers, int nbWorkers) {
+
+    char header[AGENT_HEADER_SIZE];
+    char *data;
+    size_t length;
+    int err;
+
+    while((err = agents_message(channel, DATA_MAX_SIZE, header, &data, &length)) == 1) {
+
+        unsigned long workdirLength;
+        long id;
+        int timeout;
+        int cpuLimit;
+        int i;
+
+        if(sscanf(header, "JOB %ld %d %d %lu", &id, &timeout, &cpuLimit, &workdirLength) == 4
+                && id > 0 && workdirLength <= length) {
+
+            char *workdir = workdirLength > 0 ? strndup(data, workdirLength) : NULL;
+            yk_worker *worker = NULL;
+
+            for(i = 0; i < nbWorkers && worker == NULL; i++) {
+                if(workers[i].id == 0) {
+                    worker = &workers[i];
+                }
+            }
+
+            if(worker == NULL || start_task(worker, workdir, data + workdirLength)) {
+                snprintf(header, sizeof(header), "END %ld 1 0 0 0 0 0 0", id);
+                agents_send(channel->fd, header, NULL, 0);
+                log_error("Task %ld not executed", id);
+            } else {
+                worker->id = id;
+                worker->timeout = timeout;
+                worker->cpuLimit = cpuLimit;
+                log_info("Task %ld started (pid %d) : %s", id, worker->pid, data + workdirLength);
+            }
+            free(workdir);
+
+        } else if(sscanf(header, "CANCEL %ld", &id) == 1) {
+            for(i = 0; i < nbWorkers; i++) {
+                if(workers[i].id == id && !workers[i].killDate) {
+                    log_info("Task %ld cancelled", id);
+                    stop_task(&workers[i], CANCELLED_RESULT);
+                }
+            }
+        } else {
+            err = -1;
+        }
+
+        free(data);
+        if(err == -1) {
+            break;
+        }
+    }
+
+    return err == -1;
+}
+
+
+/**
+ * Run the tasks sent by a scheduler, until it goes away.
+ *
+ * \param fd the connection to the scheduler
+ * \param sigchldFd where SIGCHLD is received
+ * \param workers the workers, all free
+ * \param nbWorkers the number of workers
+ */
+static void serve(int fd, int sigchldFd, yk_worker *workers, int nbWorkers) {
+
+    yk_channel channel;
+    struct pollfd *fds = malloc((nbWorkers + 2) * sizeof(struct pollfd));
+    int i;
+
+    channel.fd = fd;
+    channel.data = NULL;
+    channel.length = 0;
+    channel.size = 0;
+
+    while(!stopped) {
+
+        struct signalfd_siginfo info;
+
+        fds[0].fd = fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = sigchldFd;
+        fds[1].events = POLLIN;
+        for(i = 0; i < nbWorkers; i++) {
+            fds[i + 2].fd = workers[i].id != 0 ? workers[i].output : -1;
+            fds[i + 2].events = POLLIN;
+        }
+
+        if(poll(fds, nbWorkers + 2, TICK * 1000) > 0) {
+
+            if(fds[0].revents && (agents_receive(&channel) || read_messages(&channel, workers, nbWorkers))) {
+                log_info("Disconnected from the scheduler");
+                break;
+            }
+
+            for(i = 0; i < nbWorkers; i++) {
+                if(fds[i + 2].revents) {
+                    send_output(fd, &workers[i]);
+                }
+            }
+
+            while(read(sigchldFd, &info, sizeof(info)) > 0);
+        }
+
+        end_tasks(fd, workers, nbWorkers);
+        check_limits(workers, nbWorkers);
+    }
+
+    // the scheduler will start them again
+    for(i = 0; i < nbWorkers; i++) {
+        if(workers[i].id != 0) {
+            kill(-workers[i].pid, SIGKILL);
+            waitpid(workers[i].pid, NULL, 0);
+            if(workers[i].output != -1) {
+                close(workers[i].output);
+            }
+            release_token(&workers[i]);
+            workers[i].id = 0;
+        }
+    }
+
+    free(channel.data);
+    free(fds);
+}
+
+
+int main(int argc, char **argv) {
+
+    yk_worker *workers;
+    int nbWorkers;
+    int makeJobs;
+    long memory;
+    long available;
+    long size;
+    char *secretFile = NULL;
+    char *secret = NULL;
+    char name[AGENT_HEADER_SIZE];
+    char hostname[128];
+    char header[AGENT_HEADER_SIZE + 16];
+    struct sigaction action;
+    sigset_t sigchld;
+    int sigchldFd;
+    int c;
+    struct option options[] = {
+        { "jobs", required_argument, NULL, 'j' },
+        { "make-jobs", required_argument, NULL, 'm' },
+        { "memory", required_argument, NULL, 'r' },
+        { "name", required_argument, NULL, 'n' },
+        { "secret", required_argument, NULL, 's' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    nbWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    if(nbWorkers < 1) {
+        nbWorkers = 1;
+    }
+    makeJobs = nbWorkers;
+    if(proc_meminfo(&memory, &available)) {
+        memory = 0;
+    }
+    if(gethostname(hostname, sizeof(hostname))) {
+        strcpy(hostname, "agent");
+    }
+    hostname[sizeof(hostname) - 1] = '\0';
+    snprintf(name, sizeof(name), "%s/%d", hostname, (int) getpid());
+
+    while ((c = getopt_long(argc, argv, "j:m:n:s:", options, NULL)) != -1) {
+        switch(c) {
+            case 'j':
+                nbWorkers = atoi(optarg);
+                if(nbWorkers < 1) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'm':
+                makeJobs = atoi(optarg);
+                if(makeJobs < 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'r':
+                size = capture_parse_size(optarg);
+                if(size < 0) {
+                    usage(argv[0]);
+                }
+                memory = size / 1024;
+                break;
+            case 'n':
+                if(optarg[0] == '\0' || strchr(optarg, ' ') != NULL || strlen(optarg) >= sizeof(name)) {
+                    usage(argv[0]);
+                }
+                strcpy(name, optarg);
+                break;
+            case 's':
+                secretFile = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if(argc - optind != 1) {
+        usage(argv[0]);
+    }
+
+    init_log(LOG_LEVEL_INFO);
+
+    if(secretFile != NULL && (secret = agents_read_secret(secretFile)) == NULL) {
+        close_log();
+        return 1;
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_stop;
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGINT, &action, NULL);
+
+    // SIGCHLD is only received with the signalfd
+    sigemptyset(&sigchld);
+    sigaddset(&sigchld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &sigchld, NULL);
+    sigchldFd = signalfd(-1, &sigchld, SFD_NONBLOCK | SFD_CLOEXEC);
+    if(sigchldFd == -1) {
+        log_error("Can't create a signalfd : %s", strerror(errno));
+        close_log();
+        return 1;
+    }
+
+    if(open_jobserver(makeJobs)) {
+        close(sigchldFd);
+        close_log();
+        return 1;
+    }
+
+    workers = calloc(nbWorkers, sizeof(yk_worker));
+
+    while(!stopped) {
+
+        int fd = agents_connect(argv[optind]);
+
+        if(fd == -1) {
+            sleep(RETRY_DELAY);
+            continue;
+        }
+
+        log_info("Agent %s connected to %s with %d worker(s)", name, argv[optind], nbWorkers);
+        snprintf(header, sizeof(header), "HELLO %d %ld %s", nbWorkers, memory, name);
+        if(!agents_send(fd, header, secret, secret != NULL ? strlen(secret) : 0)) {
+            serve(fd, sigchldFd, workers, nbWorkers);
+        }
+        close(fd);
+        // a refused agent must not flood the scheduler with connections
+        if(!stopped) {
+            sleep(RETRY_DELAY);
+        }
+    }
+
+    free(workers);
+    free(secret);
+    if(tokens[0] != -1) {
+        close(tokens[0]);
+        close(tokens[1]);
+        close(tokenReader);
+    }
+    close(sigchldFd);
+    close_log();
+    return 0;
+}
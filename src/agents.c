@@ -0,0 +1,809 @@
+/**
+ * \file agents.c
+ * \brief remote workers executing the jobs of the scheduler
+ */
+
+#include "agents.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/** \brief number of connections waiting to be accepted */
+#define AGENTS_BACKLOG 16
+
+/** \brief bytes read at once on a connection */
+#define RECEIVE_SIZE 65536
+
+/** \brief seconds given to a new connection to send its HELLO */
+#define HELLO_TIMEOUT 5
+
+
+/**
+ * \brief A job running on an agent.
+ */
+typedef struct yk_remote_ {
+    long id; /**< \brief identifier of the job in the messages */
+    yk_job *job; /**< \brief the job */
+    yk_console *console; /**< \brief where its console output is written */
+    int cancelSent; /**< \brief 1 when the agent was asked to cancel the job */
+    struct yk_remote_ *next; /**< \brief the next job of the same agent */
+} yk_remote;
+
+
+/**
+ * \brief A connected agent.
+ */
+typedef struct yk_agent_ {
+    yk_channel channel; /**< \brief the connection */
+    char name[AGENT_HEADER_SIZE]; /**< \brief the agent's name */
+    int workers; /**< \brief number of jobs run at the same time, 0 until the agent is presented */
+    int running; /**< \brief number of jobs running on the agent */
+    long memory; /**< \brief memory in kB for the expected peaks of the jobs, 0 for no limit */
+    long reserved; /**< \brief memory in kB expected by the running jobs */
+    time_t connected; /**< \brief monotonic date of the connection */
+    yk_remote *jobs; /**< \brief the jobs running on the agent */
+    struct yk_agent_ *next; /**< \brief the next agent */
+} yk_agent;
+
+
+struct yk_agents_ {
+    int listener; /**< \brief the listening socket */
+    char *path; /**< \brief the Unix socket to remove at the end, or NULL */
+    char *secret; /**< \brief the secret the agents must give, or NULL */
+    long lastId; /**< \brief identifier of the last job sent */
+    yk_agent *agents; /**< \brief the connected agents */
+};
+
+
+/**
+ * Open a socket on an address : a Unix socket's path if it contains a
+ * '/' or no ':', else "HOST:PORT" for TCP. An empty host is the loopback
+ * address, an IPv6 host may be written between brackets.
+ *
+ * \param address the address
+ * \param listening 1 to listen on the address, 0 to connect to it
+ * \return the socket, or -1 in case of error
+ */
+static int open_socket(const char *address, int listening) {
+
+    const char *port = strrchr(address, ':');
+    struct addrinfo hints;
+    struct addrinfo *result;
+    struct addrinfo *ai;
+    char *host;
+    int fd = -1;
+    int err;
+
+    if(strchr(address, '/') != NULL || port == NULL) {
+
+        struct sockaddr_un sun;
+
+        if(strlen(address) >= sizeof(sun.sun_path)) {
+            log_error("Socket's path too long : %s", address);
+            return -1;
+        }
+        memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        strcpy(sun.sun_path, address);
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(fd == -1) {
+            log_error("Can't create a socket : %s", strerror(errno));
+            return -1;
+        }
+
+        if(listening) {
+            // a socket left by a previous scheduler
+            unlink(address);
+            err = bind(fd, (struct sockaddr *) &sun, sizeof(sun)) || listen(fd, AGENTS_BACKLOG);
+        } else {
+            err = connect(fd, (struct sockaddr *) &sun, sizeof(sun));
+        }
+
+        if(err) {
+            log_error("Can't %s %s : %s", listening ? "listen on" : "connect to", address, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    if(address[0] == '[' && port > address && port[-1] == ']') {
+        host = strndup(address + 1, port - address - 2);
+    } else {
+        host = strndup(address, port - address);
+    }
+    // no AI_PASSIVE : without a host, only the local machine is listened to
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    err = getaddrinfo(host[0] != '\0' ? host : NULL, port + 1, &hints, &result);
+    free(host);
+    if(err) {
+        log_error("Can't find address %s : %s", address, gai_strerror(err));
+        return -1;
+    }
+
+    for(ai = result; ai != NULL; ai = ai->ai_next) {
+
+        int one = 1;
+
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if(fd == -1) {
+            continue;
+        }
+
+        if(listening) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            err = bind(fd, ai->ai_addr, ai->ai_addrlen) || listen(fd, AGENTS_BACKLOG);
+        } else {
+            err = connect(fd, ai->ai_addr, ai->ai_addrlen);
+        }
+
+        if(!err) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+
+    freeaddrinfo(result);
+
+    if(fd == -1) {
+        log_error("Can't %s %s : %s", listening ? "listen on" : "connect to", address, strerror(errno));
+    }
+    return fd;
+}
+
+
+/**
+ * Compare a secret with the one given by an agent, in a time which
+ * doesn't depend on where they differ.
+ *
+ * \param secret the expected secret
+ * \param given the given secret
+ * \param length length of the given secret
+ * \return 1 if they are the same
+ */
+static int same_secret(const char *secret, const char *given, size_t length) {
+
+    size_t secretLength = strlen(secret);
+    unsigned char diff = (length != secretLength);
+    size_t i;
+
+    for(i = 0; i < length && i < secretLength; i++) {
+        diff |= secret[i] ^ given[i];
+    }
+    return diff == 0;
+}
+
+
+char *agents_read_secret(const char *filename) {
+
+    char line[AGENT_HEADER_SIZE];
+    FILE *fd = fopen(filename, "r");
+
+    if(fd == NULL) {
+        log_error("Can't read the agents' secret %s : %s", filename, strerror(errno));
+        return NULL;
+    }
+
+    if(fgets(line, sizeof(line), fd) == NULL) {
+        line[0] = '\0';
+    }
+    fclose(fd);
+    line[strcspn(line, "\r\n")] = '\0';
+
+    if(line[0] == '\0') {
+        log_error("The agents' secret %s is empty", filename);
+        return NULL;
+    }
+    return strdup(line);
+}
+
+
+yk_agents *agents_listen(const char *address, const char *secret) {
+
+    yk_agents *agents;
+    int tcp = strchr(address, '/') == NULL && strrchr(address, ':') != NULL;
+    int fd;
+
+    // anybody who can connect gets the tasks' commands and writes their results
+    if(tcp && secret == NULL) {
+        log_error("The agents must give a secret to connect on %s", address);
+        return NULL;
+    }
+
+    fd = open_socket(address, 1);
+    if(fd == -1) {
+        return NULL;
+    }
+
+    agents = malloc(sizeof(yk_agents));
+    agents->listener = fd;
+    agents->path = !tcp ? strdup(address) : NULL;
+    agents->secret = secret != NULL ? strdup(secret) : NULL;
+    agents->lastId = 0;
+    agents->agents = NULL;
+
+    log_info("Waiting for agents on %s", address);
+    return agents;
+}
+
+
+int agents_connect(const char *address) {
+    return open_socket(address, 0);
+}
+
+
+int agents_send(int fd, const char *header, const char *data, size_t length) {
+
+    char line[AGENT_HEADER_SIZE + 32];
+    int size;
+
+    size = snprintf(line, sizeof(line), "%s %lu\n", header, (unsigned long) length);
+    if(size < 0 || (size_t) size >= sizeof(line)) {
+        log_error("Message too long : %s", header);
+        return 1;
+    }
+
+    // a lost peer must not kill us with SIGPIPE
+    if(send(fd, line, size, MSG_NOSIGNAL | (length > 0 ? MSG_MORE : 0)) != size) {
+        return 1;
+    }
+
+    while(length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if(sent == -1 && errno == EINTR) {
+            continue;
+        }
+        if(sent <= 0) {
+            return 1;
+        }
+        data += sent;
+        length -= sent;
+    }
+
+    return 0;
+}
+
+
+int agents_receive(yk_channel *channel) {
+
+    ssize_t nb;
+
+    if(channel->size - channel->length < RECEIVE_SIZE) {
+        char *data = realloc(channel->data, channel->length + RECEIVE_SIZE);
+        if(data == NULL) {
+            log_error("Can't allocate %d bytes for a connection", RECEIVE_SIZE);
+            return 1;
+        }
+        channel->data = data;
+        channel->size = channel->length + RECEIVE_SIZE;
+    }
+
+    nb = recv(channel->fd, channel->data + channel->length, RECEIVE_SIZE, MSG_DONTWAIT);
+    if(nb == -1 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    if(nb <= 0) {
+        return 1;
+    }
+
+    channel->length += nb;
+    return 0;
+}
+
+
+int agents_message(yk_channel *channel, size_t maxLength, char *header, char **data, size_t *length) {
+
+    char *end;
+    char *last;
+    char *stop;
+    size_t headerLength;
+    long dataLength;
+
+    if(channel->length == 0) {
+        return 0;
+    }
+
+    end = memchr(channel->data, '\n', channel->length);
+    if(end == NULL) {
+        return channel->length >= AGENT_HEADER_SIZE ? -1 : 0;
+    }
+
+    headerLength = end - channel->data;
+    if(headerLength >= AGENT_HEADER_SIZE) {
+        return -1;
+    }
+    memcpy(header, channel->data, headerLength);
+    header[headerLength] = '\0';
+
+    last = strrchr(header, ' ');
+    if(last == NULL) {
+        return -1;
+    }
+    dataLength = strtol(last + 1, &stop, 10);
+    if(*stop != '\0' || stop == last + 1 || dataLength < 0 || (size_t) dataLength > maxLength) {
+        return -1;
+    }
+
+    if(channel->length < headerLength + 1 + dataLength) {
+        return 0;
+    }
+    *last = '\0';
+
+    if(data != NULL) {
+        *data = malloc(dataLength + 1);
+        memcpy(*data, end + 1, dataLength);
+        (*data)[dataLength] = '\0';
+    }
+    *length = dataLength;
+
+    channel->length -= headerLength + 1 + dataLength;
+    memmove(channel->data, end + 1 + dataLength, channel->length);
+    return 1;
+}
+
+
+/**
+ * Look if an agent can start a job : a free worker, and enough memory for
+ * the expected peak of the job.
+ *
+ * \param agent the agent
+ * \param job the job
+ * \return 1 if the job may start on the agent
+ */
+static int fits_agent(const yk_agent *agent, const yk_job *job) {
+
+    if(agent->channel.fd == -1 || agent->running >= agent->workers) {
+        return 0;
+    }
+
+    // a job alone must run, whatever its needs
+    return agent->running == 0 || agent->memory <= 0 || agent->reserved + job->expectedRss <= agent->memory;
+}
+
+
+int agents_idle(yk_agents *agents, const yk_job *job) {
+
+    yk_agent *agent;
+    int idle = 0;
+
+    if(agents == NULL) {
+        return 0;
+    }
+
+    for(agent = agents->agents; agent != NULL; agent = agent->next) {
+        if(fits_agent(agent, job)) {
+            idle += agent->workers - agent->running;
+        }
+    }
+
+    return idle;
+}
+
+
+int agents_start(yk_agents *agents, yk_job *job, char *logdir) {
+
+    yk_agent *agent;
+    yk_agent *chosen = NULL;
+    yk_remote *remote;
+    char header[AGENT_HEADER_SIZE];
+    char *ficconsole;
+    char *data;
+    size_t workdirLength = job->workdir != NULL ? strlen(job->workdir) : 0;
+
+    for(agent = agents->agents; agent != NULL; agent = agent->next) {
+        if(fits_agent(agent, job)
+                && (chosen == NULL || agent->workers - agent->running > chosen->workers - chosen->running)) {
+            chosen = agent;
+        }
+    }
+
+    if(chosen == NULL) {
+        log_error("Task %s : no agent is idle", job->task);
+        return 1;
+    }
+
+    ficconsole = malloc(sizeof(char) * (strlen(logdir) + strlen(job->task) + 13));
+    if(ficconsole == NULL) {
+        log_error("Task %s could not allocate memory. Task aborted.", job->task);
+        return 1;
+    }
+
+    // remove the output of a previous run in the other format
+    sprintf(ficconsole, "%s/%s_console%s", logdir, job->task, job->capture.compress ? "" : ".gz");
+    remove(ficconsole);
+
+    remote = malloc(sizeof(yk_remote));
+    sprintf(ficconsole, "%s/%s_console%s", logdir, job->task, job->capture.compress ? ".gz" : "");
+    remote->console = capture_open(ficconsole, &job->capture);
+    free(ficconsole);
+    if(remote->console == NULL) {
+        log_error("Task %s could not create its console output. Task aborted", job->task);
+        free(remote);
+        return 1;
+    }
+
+    remote->id = ++agents->lastId;
+    remote->job = job;
+    remote->cancelSent = 0;
+
+    data = malloc(workdirLength + strlen(job->command) + 1);
+    sprintf(data, "%s%s", job->workdir != NULL ? job->workdir : "", job->command);
+    snprintf(header, sizeof(header), "JOB %ld %d %d %lu", remote->id, job->timeout, job->cpuLimit,
+            (unsigned long) workdirLength);
+
+    if(agents_send(chosen->channel.fd, header, data, strlen(data))) {
+        log_error("Task %s could not be sent to agent %s : %s", job->task, chosen->name, strerror(errno));
+        capture_close(remote->console, NULL);
+        free(remote);
+        free(data);
+        return 1;
+    }
+    free(data);
+
+    remote->next = chosen->jobs;
+    chosen->jobs = remote;
+    chosen->running++;
+    chosen->reserved += job->expectedRss;
+
+    log_info("Task %s sent to agent %s", job->task, chosen->name);
+    return 0;
+}
+
+
+/**
+ * Forget an agent whose connection is lost : its jobs will be started
+ * again, or fail if they were already lost.
+ *
+ * \param agent the agent, its connection is closed
+ * \param ended called for each job of the agent
+ * \param data given to ended
+ */
+static void lose_agent(yk_agent *agent, void (*ended)(yk_job *job, int result, const yk_usage *usage, void *data),
+        void *data) {
+
+    if(agent->workers > 0) {
+        log_warning("Agent %s lost with %d running job(s)", agent->name, agent->running);
+    }
+
+    while(agent->jobs != NULL) {
+        yk_remote *remote = agent->jobs;
+        agent->jobs = remote->next;
+        capture_close(remote->console, remote->job->cancelled ? CANCEL_NOTICE : LOST_NOTICE);
+        ended(remote->job, 1, NULL, data);
+        free(remote);
+    }
+
+    close(agent->channel.fd);
+    agent->channel.fd = -1;
+    agent->running = 0;
+    agent->reserved = 0;
+}
+
+
+/**
+ * Give the max length of the data of the next message of an agent : until
+ * its presentation, no more than the secret.
+ *
+ * \param agent the agent
+ * \param secret the secret the agent must give in its presentation, or NULL
+ * \return the max length
+ */
+static size_t max_data(const yk_agent *agent, const char *secret) {
+
+    if(agent->workers > 0) {
+        return DATA_MAX_SIZE;
+    }
+    // an agent may give a secret the scheduler doesn't require
+    return secret != NULL ? strlen(secret) : AGENT_HEADER_SIZE;
+}
+
+
+/**
+ * Read the messages received from an agent. Until its presentation, an
+ * agent may only send HELLO, with the secret as its data.
+ *
+ * \param agent the agent
+ * \param secret the secret the agent must give in its presentation, or NULL
+ * \param ended called for each ended job
+ * \param data given to ended
+ * \return 1 if a job ended or the agent presented itself, -1 if the
+ *         agent doesn't follow the protocol, else 0
+ */
+static int read_messages(yk_agent *agent, const char *secret, void (*ended)(yk_job *job, int result, const yk_usage *usage, void *data),
+        void *data) {
+
+    char header[AGENT_HEADER_SIZE];
+    char *output;
+    size_t length;
+    int changed = 0;
+    int err;
+
+    while((err = agents_message(&agent->channel, max_data(agent, secret), header, &output, &length)) == 1) {
+
+        yk_remote **previous;
+        yk_remote *remote = NULL;
+        yk_usage usage;
+        long id;
+        int result;
+        int hello = !strncmp(header, "HELLO ", 6);
+
+        // HELLO first, and only once
+        if(hello != (agent->workers == 0)) {
+            err = -1;
+        } else if(hello) {
+            char name[AGENT_HEADER_SIZE];
+            if(secret != NULL && !same_secret(secret, output, length)) {
+                log_warning("Agent refused : wrong secret");
+                free(output);
+                return -1;
+            } else if(sscanf(header, "HELLO %d %ld %s", &agent->workers, &agent->memory, name) == 3 && agent->workers > 0) {
+                strcpy(agent->name, name);
+                log_info("Agent %s connected with %d worker(s) and %ld MB", agent->name, agent->workers,
+                        agent->memory / 1024);
+                changed = 1;
+            } else {
+                err = -1;
+            }
+        } else if(sscanf(header, "OUT %ld", &id) == 1) {
+            for(remote = agent->jobs; remote != NULL && remote->id != id; remote = remote->next);
+            if(remote != NULL && capture_write(remote->console, output, length)) {
+                log_error("Error while capturing the output of task %s", remote->job->task);
+            }
+        } else if(sscanf(header, "END %ld %d %lf %lf %lf %ld %ld %ld", &id, &result, &usage.duration,
+                    &usage.user, &usage.system, &usage.maxrss, &usage.inblock, &usage.oublock) == 8) {
+            for(previous = &agent->jobs; *previous != NULL && (*previous)->id != id; previous = &(*previous)->next);
+            remote = *previous;
+            if(remote != NULL) {
+                *previous = remote->next;
+                agent->running--;
+                agent->reserved -= remote->job->expectedRss;
+                capture_close(remote->console, result == TIMEOUT_RESULT ? KILL_NOTICE
+                        : (result == CANCELLED_RESULT ? CANCEL_NOTICE : NULL));
+                ended(remote->job, result, &usage, data);
+                free(remote);
+                changed = 1;
+            }
+        } else {
+            err = -1;
+        }
+
+        free(output);
+        if(err == -1) {
+            break;
+        }
+    }
+
+    if(err == -1) {
+        log_error("Agent %s doesn't follow the protocol", agent->name);
+        return -1;
+    }
+    return changed;
+}
+
+
+/**
+ * Accept a new agent.
+ */
+static void accept_agent(yk_agents *agents) {
+
+    struct timespec now;
+    yk_agent *agent;
+    int fd = accept(agents->listener, NULL, NULL);
+
+    if(fd == -1) {
+        log_warning("Can't accept an agent : %s", strerror(errno));
+        return;
+    }
+    // the tasks must not inherit the connection
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    agent = malloc(sizeof(yk_agent));
+    agent->channel.fd = fd;
+    agent->channel.data = NULL;
+    agent->channel.length = 0;
+    agent->channel.size = 0;
+    strcpy(agent->name, "(unknown)");
+    agent->workers = 0;
+    agent->running = 0;
+    agent->memory = 0;
+    agent->reserved = 0;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    agent->connected = now.tv_sec;
+    agent->jobs = NULL;
+    agent->next = agents->agents;
+    agents->agents = agent;
+}
+
+
+/**
+ * Ask the agents to cancel the cancelled jobs.
+ */
+static void send_cancels(yk_agents *agents) {
+
+    yk_agent *agent;
+    yk_remote *remote;
+    char header[AGENT_HEADER_SIZE];
+
+    for(agent = agents->agents; agent != NULL; agent = agent->next) {
+        for(remote = agent->jobs; remote != NULL; remote = remote->next) {
+            if(remote->job->cancelled && !remote->cancelSent) {
+                sprintf(header, "CANCEL %ld", remote->id);
+                remote->cancelSent = 1;
+                if(agents_send(agent->channel.fd, header, NULL, 0)) {
+                    log_warning("Can't cancel task %s on agent %s", remote->job->task, agent->name);
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * Close the connections which didn't present an agent in time.
+ *
+ * \param agents the agents
+ * \param now the monotonic date
+ */
+static void refuse_silent_agents(yk_agents *agents, time_t now) {
+
+    yk_agent *agent;
+
+    for(agent = agents->agents; agent != NULL; agent = agent->next) {
+        if(agent->channel.fd != -1 && agent->workers == 0 && now - agent->connected >= HELLO_TIMEOUT) {
+            log_warning("Agent refused : no presentation within %d s", HELLO_TIMEOUT);
+            close(agent->channel.fd);
+            agent->channel.fd = -1;
+        }
+    }
+}
+
+
+/**
+ * Free the agents whose connection is closed.
+ */
+static void remove_lost_agents(yk_agents *agents) {
+
+    yk_agent **previous = &agents->agents;
+
+    while(*previous != NULL) {
+        yk_agent *agent = *previous;
+        if(agent->channel.fd == -1) {
+            *previous = agent->next;
+            free(agent->channel.data);
+            free(agent);
+        } else {
+            previous = &agent->next;
+        }
+    }
+}
+
+
+void agents_wait(yk_agents *agents, int wakeup, int timeout,
+        void (*ended)(yk_job *job, int result, const yk_usage *usage, void *data), void *data) {
+
+    struct timespec now;
+    time_t deadline;
+    int changed = 0;
+
+    send_cancels(agents);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    deadline = now.tv_sec + timeout;
+
+    do {
+        struct pollfd *fds;
+        yk_agent **polled;
+        yk_agent *agent;
+        int nb = 0;
+        int ready;
+        int i;
+
+        for(agent = agents->agents; agent != NULL; agent = agent->next) {
+            nb++;
+        }
+        fds = malloc((nb + 2) * sizeof(struct pollfd));
+        polled = malloc((nb + 2) * sizeof(yk_agent *));
+
+        nb = 0;
+        for(agent = agents->agents; agent != NULL; agent = agent->next) {
+            fds[nb].fd = agent->channel.fd;
+            fds[nb].events = POLLIN;
+            polled[nb++] = agent;
+        }
+        fds[nb].fd = agents->listener;
+        fds[nb].events = POLLIN;
+        fds[nb + 1].fd = wakeup;
+        fds[nb + 1].events = POLLIN;
+
+        ready = poll(fds, nb + 2, (deadline - now.tv_sec) * 1000);
+
+        if(ready > 0) {
+
+            for(i = 0; i < nb; i++) {
+                if(fds[i].revents == 0) {
+                    continue;
+                }
+                agent = polled[i];
+                if(agents_receive(&agent->channel)) {
+                    lose_agent(agent, ended, data);
+                    changed = 1;
+                    continue;
+                }
+                switch(read_messages(agent, agents->secret, ended, data)) {
+                    case -1:
+                        lose_agent(agent, ended, data);
+                        changed = 1;
+                        break;
+                    case 1:
+                        changed = 1;
+                        break;
+                }
+            }
+
+            // its presentation is usually already received
+            if(fds[nb].revents & POLLIN) {
+                accept_agent(agents);
+                agent = agents->agents;
+                if(agents_receive(&agent->channel) || read_messages(agent, agents->secret, ended, data) == -1) {
+                    lose_agent(agent, ended, data);
+                } else if(agent->workers > 0) {
+                    changed = 1;
+                }
+            }
+
+            if(wakeup != -1 && fds[nb + 1].revents) {
+                changed = 1;
+            }
+        }
+
+        free(fds);
+        free(polled);
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        refuse_silent_agents(agents, now.tv_sec);
+        remove_lost_agents(agents);
+
+        if(ready == -1 && errno != EINTR) {
+            log_error("Error while waiting for the agents : %s", strerror(errno));
+            break;
+        }
+    } while(!changed && now.tv_sec < deadline);
+}
+
+
+void agents_close(yk_agents *agents) {
+
+    yk_agent *agent;
+
+    if(agents == NULL) {
+        return;
+    }
+
+    for(agent = agents->agents; agent != NULL; agent = agent->next) {
+        close(agent->channel.fd);
+        agent->channel.fd = -1;
+    }
+    remove_lost_agents(agents);
+
+    close(agents->listener);
+    if(agents->path != NULL) {
+        unlink(agents->path);
+        free(agents->path);
+    }
+    free(agents->secret);
+    free(agents);
+}
@@ -0,0 +1,171 @@
+/**
+ * \file agents.h
+ * \brief remote workers executing the jobs of the scheduler
+ *
+ * An agent ("yannkins-agent") connects to the scheduler, on a Unix socket
+ * or on a TCP port, and gives its number of workers and its memory. The
+ * jobs which are ready to start, but which the local workers can't take,
+ * are pushed by the scheduler to the agent with the most free workers
+ * where the expected peak of memory of the job fits ; the agents don't
+ * ask for work. The agent runs the command in the same
+ * working directory, on the same machine or on a shared file system, and
+ * streams back the console output and then the result and the resources
+ * used. The scheduler stores them as for a local job. The jobs of the
+ * fetch pool, which update the working directories, stay local.
+ *
+ * Each message is a line of text whose last field is the length of the
+ * data following the line :
+ *     HELLO ${WORKERS} ${MEMORY} ${NAME} ${LENGTH}
+ *                                                 agent's presentation, with its memory in kB
+ *                                                 for the jobs, 0 for no limit, then the secret
+ *     JOB ${ID} ${TIMEOUT} ${CPU} ${WORKDIR_LENGTH} ${LENGTH}
+ *                                                 the working directory then the command
+ *     CANCEL ${ID} 0                              the job is superseded
+ *     OUT ${ID} ${LENGTH}                         some console output
+ *     END ${ID} ${RESULT} ${USAGE} 0              the exit status, TIMEOUT_RESULT
+ *                                                 or CANCELLED_RESULT, and the usage
+ * If an agent is lost, its running jobs are started again, once : a job
+ * lost twice fails, and a cancelled one is not started again.
+ *
+ * Whoever connects gets the commands of the jobs and writes their results :
+ * a TCP port only listens on the loopback address unless a host is given,
+ * and the agents must present the secret of the scheduler. It is optional
+ * on a Unix socket, protected by the permissions of its directory. HELLO
+ * must be the first message, with no more data than the secret, within
+ * HELLO_TIMEOUT seconds : the other connections are closed.
+ */
+
+#ifndef YK_AGENTS_H
+#define YK_AGENTS_H 1
+
+#include <stddef.h>
+#include "jobs.h"
+
+/** \brief size of the header of a message */
+#define AGENT_HEADER_SIZE 256
+
+/** \brief max length of the data of a message */
+#define DATA_MAX_SIZE (16 * 1024 * 1024)
+
+
+/**
+ * \brief The agents connected to a scheduler.
+ */
+typedef struct yk_agents_ yk_agents;
+
+
+/**
+ * \brief Data received on a connection, not yet read as messages.
+ */
+typedef struct {
+    int fd; /**< \brief the socket */
+    char *data; /**< \brief the received bytes */
+    size_t length; /**< \brief number of received bytes */
+    size_t size; /**< \brief allocated size of data */
+} yk_channel;
+
+
+/**
+ * \brief Read the secret shared by a scheduler and its agents : the first
+ * line of a file.
+ * \param filename the file
+ * \return the allocated secret, or NULL if it can't be read or is empty
+ */
+char *agents_read_secret(const char *filename);
+
+
+/**
+ * \brief Listen for the agents.
+ * \param address a Unix socket's path, or "[HOST]:PORT" for TCP, the
+ *        loopback address if HOST is empty
+ * \param secret the secret the agents must give, or NULL ; it is
+ *        required on TCP
+ * \return the agents, or NULL in case of error
+ */
+yk_agents *agents_listen(const char *address, const char *secret);
+
+
+/**
+ * \brief Count the free workers of the agents which have enough memory
+ * for the expected peak of a job.
+ * \param agents the agents, may be NULL
+ * \param job the job to start
+ * \return the number of free workers
+ */
+int agents_idle(yk_agents *agents, const yk_job *job);
+
+
+/**
+ * \brief Send a job to the agent with the most free workers among those
+ * with enough memory for it, and create its console output.
+ * \param agents the agents
+ * \param job the job to start
+ * \param logdir directory of the ouptut files
+ * \return 0 if the job was sent
+ */
+int agents_start(yk_agents *agents, yk_job *job, char *logdir);
+
+
+/**
+ * \brief Receive the agents' messages, until a job ends, a worker becomes
+ * free, or a descriptor becomes readable. The cancelled jobs are
+ * cancelled on their agents.
+ * \param agents the agents
+ * \param wakeup a descriptor to watch too, or -1
+ * \param timeout maximum time to wait, in seconds
+ * \param ended called for each ended job, with its result and the
+ *        resources used, or a NULL usage if its agent was lost
+ * \param data given to ended
+ */
+void agents_wait(yk_agents *agents, int wakeup, int timeout,
+        void (*ended)(yk_job *job, int result, const yk_usage *usage, void *data), void *data);
+
+
+/**
+ * \brief Disconnect the agents and stop listening.
+ * \param agents the agents, freed by this function
+ */
+void agents_close(yk_agents *agents);
+
+
+/**
+ * \brief Connect to a scheduler.
+ * \param address a Unix socket's path, or "HOST:PORT" for TCP
+ * \return the socket, or -1 in case of error
+ */
+int agents_connect(const char *address);
+
+
+/**
+ * \brief Send a message.
+ * \param fd the socket
+ * \param header the message's header, without its length nor '\n'
+ * \param data the data following the header, may be NULL
+ * \param length the number of bytes of data
+ * \return 0 if the message was sent
+ */
+int agents_send(int fd, const char *header, const char *data, size_t length);
+
+
+/**
+ * \brief Read the data available on a connection.
+ * \param channel the connection
+ * \return 0 if some data were read, 1 if the connection is closed
+ */
+int agents_receive(yk_channel *channel);
+
+
+/**
+ * \brief Take the next complete message of a connection.
+ * \param channel the connection
+ * \param maxLength the max length of the data of the message, DATA_MAX_SIZE at most
+ * \param header where to copy the message's header, without its length,
+ *        AGENT_HEADER_SIZE characters
+ * \param data where to copy the data of the message, to free, or NULL
+ * \param length where to put the number of bytes of data
+ * \return 1 if a message was taken, 0 if it is not complete, -1 if the
+ *         connection doesn't follow the protocol
+ */
+int agents_message(yk_channel *channel, size_t maxLength, char *header, char **data, size_t *length);
+
+#endif
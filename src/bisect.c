@@ -0,0 +1,815 @@
+/**
+ * \file bisect.c
+ * \brief find the commit which broke the tests of a git project
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "bisect.h"
+#include "report.h"
+#include "logger.h"
+
+/** \brief max length of a line in a result file */
+#define LINE_SIZE 4096
+
+/** \brief column of the result in a result file */
+#define RESULT_COLUMN 1
+
+/** \brief max length of a result in a result file */
+#define RESULT_SIZE 32
+
+/** \brief column of the revision in a result file */
+#define REVISION_COLUMN 8
+
+/** \brief first line of the file of the tests' states by commit */
+#define COMMIT_TESTS_HEADER "commit;tests\n"
+
+/** \brief first line of a bisections' file */
+#define BISECT_HEADER "date;good;bad;first bad;author;commentaries;tested;rounds\n"
+
+/** \brief suffix of the directory of the worktrees of a project */
+#define WORKTREES_SUFFIX ".bisect"
+
+/** \brief directory of the output files of the tested commits, in the directory of the worktrees */
+#define SCRATCH_DIR "log"
+
+/** \brief list of the commits of the batch, in the directory of the worktrees */
+#define COMMITS_FILE "commits"
+
+
+/**
+ * \brief What the next round of a bisection does.
+ */
+typedef enum {
+    ROUND_LIST, /**< \brief list the commits of the batch */
+    ROUND_WORKTREES, /**< \brief create the worktrees */
+    ROUND_TESTS, /**< \brief test some commits */
+    ROUND_CLEAN, /**< \brief remove the worktrees */
+    ROUND_NONE /**< \brief nothing left to do */
+} round_t;
+
+
+/**
+ * \brief A bisection in progress.
+ */
+struct yk_bisection_ {
+    yk_project *project; /**< \brief the project */
+    char *repository; /**< \brief the project's clone */
+    char *logdir; /**< \brief directory of the output files */
+    yk_job defaults; /**< \brief the job from which the limits of the tests are copied */
+    char base[REVISION_SIZE]; /**< \brief revision of the previous execution of the tests */
+    char head[REVISION_SIZE]; /**< \brief revision of the last execution of the tests */
+    int baseOk; /**< \brief 1 if the tests succeeded on base */
+    int headOk; /**< \brief 1 if the tests succeed on head */
+    int split; /**< \brief 1 to find each change of state, else only the commits which broke the tests */
+    char **commits; /**< \brief the commits of the batch, the oldest first */
+    int nb; /**< \brief number of commits */
+    int *states; /**< \brief the state of the tests before the batch, then of each commit, -1 if unknown */
+    int *points; /**< \brief the indexes of the states tested in the current round */
+    int nbPoints; /**< \brief number of states tested in the current round */
+    char *worktreesDir; /**< \brief directory of the worktrees */
+    char *scratch; /**< \brief directory of the output files of the tested commits */
+    char *commitsFile; /**< \brief list of the commits of the batch */
+    char **worktrees; /**< \brief a worktree for each commit tested at the same time */
+    int nbWorktrees; /**< \brief number of worktrees */
+    int nbWorkers; /**< \brief number of commits which can be tested at the same time */
+    round_t round; /**< \brief what the next round does */
+    int nbTested; /**< \brief number of tested commits */
+    int rounds; /**< \brief number of rounds */
+};
+
+
+/**
+ * Find the batch of commits brought by the last execution of the tests :
+ * the commits between the revisions of the two last executions.
+ *
+ * \param logdir directory of the output files
+ * \param tests the name of the tests' task
+ * \param base where to copy the revision of the previous execution, REVISION_SIZE characters
+ * \param head where to copy the revision of the last execution, REVISION_SIZE characters
+ * \param baseOk set to 1 if the previous execution succeeded
+ * \param headOk set to 1 if the last execution succeeded
+ * \return 1 if the last line of the tests' results is an execution on a new revision
+ */
+static int find_batch(const char *logdir, const char *tests, char *base, char *head, int *baseOk, int *headOk) {
+
+    char *filename = malloc(strlen(logdir) + strlen(tests) + 2);
+    char line[LINE_SIZE];
+    char previous[RESULT_SIZE] = "";
+    char last[RESULT_SIZE] = "";
+    int lastExecuted = 0;
+    FILE *fd;
+
+    base[0] = '\0';
+    head[0] = '\0';
+
+    sprintf(filename, "%s/%s", logdir, tests);
+    fd = fopen(filename, "r");
+    free(filename);
+    if(fd == NULL) {
+        return 0;
+    }
+
+    // skip the header
+    if(fgets(line, LINE_SIZE, fd) == NULL) {
+        fclose(fd);
+        return 0;
+    }
+
+    while(fgets(line, LINE_SIZE, fd) != NULL) {
+
+        char *fields[REVISION_COLUMN + 1];
+        char *saveptr = line;
+        int i;
+
+        line[strcspn(line, "\r\n")] = '\0';
+        for(i = 0; i <= REVISION_COLUMN; i++) {
+            fields[i] = strsep(&saveptr, ";");
+            if(fields[i] == NULL) {
+                break;
+            }
+        }
+        if(i <= REVISION_COLUMN) {
+            continue;
+        }
+
+        // once skipped, the batch was already split
+        if(!strncmp(fields[RESULT_COLUMN], "SKIPPED", 7) || !strcmp(fields[RESULT_COLUMN], "CANCELLED")) {
+            lastExecuted = 0;
+            continue;
+        }
+
+        strcpy(previous, last);
+        strcpy(base, head);
+        snprintf(last, RESULT_SIZE, "%s", fields[RESULT_COLUMN]);
+        snprintf(head, REVISION_SIZE, "%s", fields[REVISION_COLUMN]);
+        lastExecuted = 1;
+    }
+
+    fclose(fd);
+
+    // a timeout is a failure too
+    *baseOk = !strcmp(previous, "OK");
+    *headOk = !strcmp(last, "OK");
+    return lastExecuted && previous[0] != '\0' && base[0] != '\0' && head[0] != '\0' && strcmp(base, head);
+}
+
+
+/**
+ * Execute a command in a shell, without output.
+ *
+ * \param workdir where to execute the command
+ * \param command the command
+ * \return 0 if the command succeeded
+ */
+static int run_quietly(const char *workdir, const char *command) {
+
+    int wstatus;
+    pid_t pid = fork();
+
+    if(pid == -1) {
+        log_error("Can't fork to run %s", command);
+        return 1;
+    }
+
+    if(pid == 0) {
+        int fd = open("/dev/null", O_WRONLY);
+        if(fd == -1 || chdir(workdir)) {
+            _exit(127);
+        }
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+        execl("/bin/sh", "sh", "-c", command, (char *) NULL);
+        _exit(127);
+    }
+
+    if(waitpid(pid, &wstatus, 0) == -1) {
+        return 1;
+    }
+
+    return !WIFEXITED(wstatus) || WEXITSTATUS(wstatus);
+}
+
+
+/**
+ * Read the commits of a batch, listed by "git rev-list", the oldest first.
+ *
+ * \param filename the list of the commits
+ * \param nb set to the number of commits
+ * \return the allocated list of commits, or NULL
+ */
+static char **read_commits(const char *filename, int *nb) {
+
+    char line[REVISION_SIZE];
+    char **commits = NULL;
+    FILE *fd;
+
+    *nb = 0;
+
+    fd = fopen(filename, "r");
+    if(fd == NULL) {
+        return NULL;
+    }
+
+    while(fgets(line, REVISION_SIZE, fd) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        if(line[0] != '\0') {
+            commits = realloc(commits, (*nb + 1) * sizeof(char *));
+            commits[*nb] = strdup(line);
+            (*nb)++;
+        }
+    }
+
+    fclose(fd);
+    return commits;
+}
+
+
+/**
+ * Record the result of a bisection.
+ *
+ * \param project the project
+ * \param repository the project's clone
+ * \param logdir directory of the output files
+ * \param good the last good revision
+ * \param bad the bad revision
+ * \param first the first bad commit
+ * \param tested the number of tested commits
+ * \param rounds the number of rounds
+ */
+static void write_bisection(yk_project *project, const char *repository, const char *logdir,
+        const char *good, const char *bad, const char *first, int tested, int rounds) {
+
+    char *filename = malloc(strlen(logdir) + strlen(BISECT_TASK) + strlen(project->project_name) + 3);
+    char *command = malloc(strlen(repository) + strlen(first) + 100);
+    char description[LINE_SIZE] = "";
+    char date[20];
+    char *subject;
+    time_t now = time(NULL);
+    FILE *fd;
+    int create;
+
+    sprintf(command, "cd '%s' && git log -1 --format=%%an%%x1f%%s %s", repository, first);
+    fd = popen(command, "r");
+    free(command);
+    if(fd != NULL) {
+        if(fgets(description, LINE_SIZE, fd) == NULL) {
+            description[0] = '\0';
+        }
+        pclose(fd);
+    }
+    description[strcspn(description, "\r\n")] = '\0';
+
+    // no delimiter in the fields
+    for(subject = description; *subject != '\0'; subject++) {
+        if(*subject == ';' || *subject == '"') {
+            *subject = ',';
+        }
+    }
+    subject = strchr(description, '\x1f');
+    if(subject != NULL) {
+        *subject = '\0';
+        subject++;
+    } else {
+        subject = "";
+    }
+
+    sprintf(filename, "%s/%s_%s", logdir, BISECT_TASK, project->project_name);
+    create = access(filename, F_OK);
+    fd = fopen(filename, "a");
+    if(fd == NULL) {
+        log_error("Can't open file %s", filename);
+        free(filename);
+        return;
+    }
+
+    if(create) {
+        fprintf(fd, BISECT_HEADER);
+    }
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&now));
+    fprintf(fd, "%s;%s;%s;%s;%s;%s;%d;%d\n", date, good, bad, first, description, subject, tested, rounds);
+
+    fclose(fd);
+    free(filename);
+}
+
+
+/**
+ * Append the state of the tests of each commit of a batch to the file
+ * ${LOGDIR}/COMMIT_TESTS_${PROJECT}.
+ *
+ * \param project the project
+ * \param logdir directory of the output files
+ * \param commits the commits of the batch, the oldest first
+ * \param states the state of the tests before the batch, then of each commit : 1 if they succeed
+ * \param nb the number of commits
+ */
+static void write_states(yk_project *project, const char *logdir, char **commits, const int *states, int nb) {
+
+    char *filename = malloc(strlen(logdir) + strlen(COMMIT_TESTS) + strlen(project->project_name) + 3);
+    FILE *fd;
+    int create;
+    int i;
+
+    sprintf(filename, "%s/%s_%s", logdir, COMMIT_TESTS, project->project_name);
+    create = access(filename, F_OK);
+    fd = fopen(filename, "a");
+    if(fd == NULL) {
+        log_error("Can't open file %s", filename);
+        free(filename);
+        return;
+    }
+
+    if(create) {
+        fprintf(fd, COMMIT_TESTS_HEADER);
+    }
+    for(i = 1; i <= nb; i++) {
+        const char *state;
+        if(states[i] == states[i - 1]) {
+            state = states[i] ? "OK" : "FAIL";
+        } else {
+            state = states[i] ? "FIXED" : "BROKE";
+        }
+        fprintf(fd, "%s;%s\n", commits[i - 1], state);
+    }
+
+    fclose(fd);
+    free(filename);
+}
+
+
+int bisect_choose_points(const int *states, int nb, int nbWorkers, int split, int *points) {
+
+    int *starts = malloc(nb * sizeof(int));
+    int *ends = malloc(nb * sizeof(int));
+    int *workers = malloc(nb * sizeof(int));
+    int nbSegments = 0;
+    int nbPoints = 0;
+    int given;
+    int a = 0;
+    int b;
+    int s, j;
+
+    for(b = 1; b < nb; b++) {
+        if(states[b] == -1) {
+            continue;
+        }
+        // without the split of the batches, the fixes are not looked for
+        if(states[a] != states[b] && b - a > 1 && (split || (states[a] == 1 && states[b] == 0))) {
+            starts[nbSegments] = a;
+            ends[nbSegments] = b;
+            workers[nbSegments] = 0;
+            nbSegments++;
+        }
+        a = b;
+    }
+
+    // one more worker for each segment, while they can use it
+    do {
+        given = 0;
+        for(s = 0; s < nbSegments && nbPoints < nbWorkers; s++) {
+            if(workers[s] < ends[s] - starts[s] - 1) {
+                workers[s]++;
+                nbPoints++;
+                given = 1;
+            }
+        }
+    } while(given && nbPoints < nbWorkers);
+
+    nbPoints = 0;
+    for(s = 0; s < nbSegments; s++) {
+        for(j = 1; j <= workers[s]; j++) {
+            points[nbPoints++] = starts[s] + (j * (ends[s] - starts[s])) / (workers[s] + 1);
+        }
+    }
+
+    free(starts);
+    free(ends);
+    free(workers);
+    return nbPoints;
+}
+
+
+/**
+ * Remove the scratch directory of the output files of the tests, and its
+ * files.
+ *
+ * \param dirname the directory
+ */
+static void remove_scratch(const char *dirname) {
+
+    DIR *dir = opendir(dirname);
+    struct dirent *entry;
+
+    if(dir == NULL) {
+        return;
+    }
+
+    while((entry = readdir(dir)) != NULL) {
+        char *filename;
+        if(!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+            continue;
+        }
+        filename = malloc(strlen(dirname) + strlen(entry->d_name) + 2);
+        sprintf(filename, "%s/%s", dirname, entry->d_name);
+        unlink(filename);
+        free(filename);
+    }
+
+    closedir(dir);
+    rmdir(dirname);
+}
+
+
+yk_bisection *bisect_start(yk_project *project, const char *reposDir, const char *logdir, const yk_schedule *schedule,
+        const yk_job *defaults, int split) {
+
+    yk_bisection *bisection;
+    char base[REVISION_SIZE];
+    char head[REVISION_SIZE];
+    char *tests;
+    char *repository;
+    int baseOk, headOk;
+    int found;
+
+    if(project->versioning_type != GIT || project->tests_cmd == NULL || project->tests_cmd[0] == '\0') {
+        return NULL;
+    }
+
+    tests = malloc(strlen(TESTS_TASK) + strlen(project->project_name) + 2);
+    sprintf(tests, "%s_%s", TESTS_TASK, project->project_name);
+    found = find_batch(logdir, tests, base, head, &baseOk, &headOk);
+    free(tests);
+
+    // without the split of the batches, only a new failure is bisected
+    if(!found || (!split && !(baseOk && !headOk))) {
+        return NULL;
+    }
+
+    repository = malloc(strlen(reposDir) + strlen(project->project_name) + 2);
+    sprintf(repository, "%s/%s", reposDir, project->project_name);
+
+    bisection = malloc(sizeof(yk_bisection));
+    bisection->project = project;
+    bisection->repository = repository;
+    bisection->logdir = strdup(logdir);
+    bisection->defaults = *defaults;
+    strcpy(bisection->base, base);
+    strcpy(bisection->head, head);
+    bisection->baseOk = baseOk;
+    bisection->headOk = headOk;
+    bisection->split = split;
+    bisection->commits = NULL;
+    bisection->nb = 0;
+    bisection->states = NULL;
+    bisection->points = NULL;
+    bisection->worktrees = NULL;
+    bisection->nbWorktrees = 0;
+    bisection->nbWorkers = schedule->pools[POOL_TEST] > 0 ? schedule->pools[POOL_TEST] : schedule->nbWorkers;
+    bisection->nbTested = 0;
+    bisection->rounds = 0;
+    bisection->round = ROUND_LIST;
+
+    bisection->worktreesDir = malloc(strlen(repository) + strlen(WORKTREES_SUFFIX) + 1);
+    sprintf(bisection->worktreesDir, "%s%s", repository, WORKTREES_SUFFIX);
+    mkdir(bisection->worktreesDir, 0750);
+
+    // the results of the tested commits are not kept
+    bisection->scratch = malloc(strlen(bisection->worktreesDir) + strlen(SCRATCH_DIR) + 2);
+    sprintf(bisection->scratch, "%s/%s", bisection->worktreesDir, SCRATCH_DIR);
+    mkdir(bisection->scratch, 0750);
+
+    bisection->commitsFile = malloc(strlen(bisection->worktreesDir) + strlen(COMMITS_FILE) + 2);
+    sprintf(bisection->commitsFile, "%s/%s", bisection->worktreesDir, COMMITS_FILE);
+
+    return bisection;
+}
+
+
+/**
+ * Add a git command of a bisection to a round : it runs in the project's
+ * clone, at the same time as the other commands of the round.
+ *
+ * \param chain the chain of the round
+ * \param bisection the bisection
+ * \param step what the command does, for the name of its task
+ * \param i the index of the command in the round, 0 if it is alone
+ * \param command the command
+ */
+static void add_git_job(yk_chain **chain, yk_bisection *bisection, const char *step, int i, const char *command) {
+
+    const char *projectName = bisection->project->project_name;
+    char *name = malloc(strlen(BISECT_TASK) + strlen(step) + strlen(projectName) + 15);
+    yk_job *job;
+
+    if(i > 0) {
+        sprintf(name, "%s_%s_%d_%s", BISECT_TASK, step, i, projectName);
+    } else {
+        sprintf(name, "%s_%s_%s", BISECT_TASK, step, projectName);
+    }
+
+    // git mostly waits for the disks, as a checkout
+    job = jobs_create(name, bisection->repository, command, &bisection->defaults);
+    job->pool = POOL_FETCH;
+    job->logdir = strdup(bisection->scratch);
+    job->after = strdup("");
+    jobs_add(chain, projectName, job);
+
+    free(name);
+}
+
+
+/**
+ * Create the jobs testing the commits chosen for the next round.
+ *
+ * \param bisection the bisection
+ * \return the chain of the jobs, or NULL if each change of state was found
+ */
+static yk_chain *tests_round(yk_bisection *bisection) {
+
+    yk_project *project = bisection->project;
+    const char *compil = project->compil_cmd != NULL && project->compil_cmd[0] != '\0' ? project->compil_cmd : "true";
+    yk_chain *chain = NULL;
+    int k;
+    int i;
+
+    k = bisect_choose_points(bisection->states, bisection->nb + 1, bisection->nbWorktrees, bisection->split,
+            bisection->points);
+    bisection->nbPoints = k;
+
+    for(i = 0; i < k; i++) {
+
+        const char *commit = bisection->commits[bisection->points[i] - 1];
+        char *command = malloc(strlen(commit) + strlen(compil) + strlen(project->tests_cmd) + 100);
+        char *name = malloc(strlen(BISECT_TASK) + strlen(project->project_name) + 15);
+        yk_job *job;
+
+        // a clean copy, as a new clone would be
+        sprintf(command, "git checkout -q -f --detach %s && git clean -q -fdx && (%s) && (%s)",
+            commit, compil, project->tests_cmd);
+        sprintf(name, "%s_%d_%s", BISECT_TASK, i + 1, project->project_name);
+
+        job = jobs_create(name, bisection->worktrees[i], command, &bisection->defaults);
+        job->pool = POOL_TEST;
+        job->logdir = strdup(bisection->scratch);
+        // the commits are tested at the same time
+        job->after = strdup("");
+        jobs_add(&chain, project->project_name, job);
+
+        free(name);
+        free(command);
+    }
+
+    return chain;
+}
+
+
+yk_chain *bisect_next_round(yk_bisection *bisection) {
+
+    yk_chain *chain = NULL;
+    char *command;
+    size_t length;
+    int i;
+
+    switch(bisection->round) {
+        case ROUND_LIST:
+            command = malloc(strlen(bisection->commitsFile) + 2 * REVISION_SIZE + 100);
+            // only the commits leading from base to head can have changed the tests
+            sprintf(command, "git rev-list --reverse --ancestry-path %s..%s > '%s'", bisection->base, bisection->head,
+                bisection->commitsFile);
+            add_git_job(&chain, bisection, "LIST", 0, command);
+            free(command);
+            return chain;
+        case ROUND_WORKTREES:
+            for(i = 0; i < bisection->nbWorktrees; i++) {
+                command = malloc(strlen(bisection->worktrees[i]) + REVISION_SIZE + 100);
+                sprintf(command, "git worktree add -f --detach '%s' %s", bisection->worktrees[i], bisection->head);
+                add_git_job(&chain, bisection, "WORKTREE", i + 1, command);
+                free(command);
+            }
+            return chain;
+        case ROUND_TESTS:
+            chain = tests_round(bisection);
+            if(chain != NULL) {
+                return chain;
+            }
+            bisection->round = ROUND_CLEAN;
+            // fall through
+        case ROUND_CLEAN:
+            length = 100;
+            for(i = 0; i < bisection->nbWorktrees; i++) {
+                length += strlen(bisection->worktrees[i]) + 30;
+            }
+            command = malloc(length);
+            command[0] = '\0';
+            for(i = 0; i < bisection->nbWorktrees; i++) {
+                sprintf(command + strlen(command), "git worktree remove -f '%s' ; ", bisection->worktrees[i]);
+            }
+            strcat(command, "git worktree prune");
+            add_git_job(&chain, bisection, "CLEAN", 0, command);
+            free(command);
+            return chain;
+        default:
+            return NULL;
+    }
+}
+
+
+/**
+ * Read the commits of the batch once they are listed, and choose the
+ * worktrees to create.
+ *
+ * \param bisection the bisection
+ * \param listed 1 if the commits were listed
+ */
+static void read_batch(yk_bisection *bisection, int listed) {
+
+    yk_project *project = bisection->project;
+    int nbWorkers = bisection->nbWorkers;
+    int nb;
+    int i;
+
+    bisection->round = ROUND_NONE;
+    bisection->commits = listed ? read_commits(bisection->commitsFile, &nb) : NULL;
+    if(bisection->commits == NULL || nb == 0) {
+        log_warning("Project %s : can't list the commits between %s and %s", project->project_name,
+            bisection->base, bisection->head);
+        free(bisection->commits);
+        bisection->commits = NULL;
+        return;
+    }
+    bisection->nb = nb;
+
+    // states[0] is the base, states[i] the commit i - 1
+    bisection->states = malloc((nb + 1) * sizeof(int));
+    for(i = 0; i <= nb; i++) {
+        bisection->states[i] = -1;
+    }
+    bisection->states[0] = bisection->baseOk;
+    bisection->states[nb] = bisection->headOk;
+
+    if(nbWorkers > nb - 1) {
+        nbWorkers = nb - 1;
+    }
+    bisection->points = malloc((nbWorkers + 1) * sizeof(int));
+
+    if(bisection->baseOk == bisection->headOk || nbWorkers <= 0) {
+        return;
+    }
+
+    log_info("Project %s : the tests %s between %s and %s, splitting %d commits", project->project_name,
+        bisection->headOk ? "were fixed" : "were broken", bisection->base, bisection->head, nb);
+
+    bisection->worktrees = malloc(nbWorkers * sizeof(char *));
+    for(i = 0; i < nbWorkers; i++) {
+        bisection->worktrees[i] = malloc(strlen(bisection->worktreesDir) + 15);
+        sprintf(bisection->worktrees[i], "%s/%d", bisection->worktreesDir, i + 1);
+    }
+    bisection->nbWorktrees = nbWorkers;
+    bisection->round = ROUND_WORKTREES;
+}
+
+
+void bisect_read_round(yk_bisection *bisection, const yk_chain *chain) {
+
+    yk_job *job;
+    int i;
+    int k;
+
+    switch(bisection->round) {
+        case ROUND_LIST:
+            read_batch(bisection, chain->jobs != NULL && chain->jobs->success);
+            break;
+        case ROUND_WORKTREES:
+            // only the created worktrees are used
+            for(i = 0, k = 0, job = chain->jobs; job != NULL && i < bisection->nbWorktrees; i++, job = job->next) {
+                if(job->success) {
+                    bisection->worktrees[k++] = bisection->worktrees[i];
+                } else {
+                    log_warning("Project %s : can't create the worktree %s", bisection->project->project_name,
+                        bisection->worktrees[i]);
+                    free(bisection->worktrees[i]);
+                }
+            }
+            bisection->nbWorktrees = k;
+            bisection->round = k > 0 ? ROUND_TESTS : ROUND_CLEAN;
+            break;
+        case ROUND_TESTS:
+            for(i = 0, job = chain->jobs; job != NULL && i < bisection->nbPoints; i++, job = job->next) {
+                bisection->states[bisection->points[i]] = job->success;
+                log_info("Project %s : commit %s %s the tests", bisection->project->project_name,
+                    bisection->commits[bisection->points[i] - 1], job->success ? "passes" : "fails");
+            }
+            bisection->nbTested += i;
+            bisection->rounds++;
+            break;
+        case ROUND_CLEAN:
+            for(i = 0; i < bisection->nbWorktrees; i++) {
+                free(bisection->worktrees[i]);
+            }
+            bisection->nbWorktrees = 0;
+            bisection->round = ROUND_NONE;
+            break;
+        default:
+            break;
+    }
+}
+
+
+int bisect_end(yk_bisection *bisection) {
+
+    yk_project *project = bisection->project;
+    int *states = bisection->states;
+    int nb = bisection->nb;
+    int k = 1;
+    int i;
+
+    if(bisection->commits != NULL
+            && bisect_choose_points(states, nb + 1, 1, bisection->split, bisection->points) == 0) {
+
+        // between two tested commits in the same state, the commits are in this state too
+        for(i = nb - 1; i > 0; i--) {
+            if(states[i] == -1) {
+                states[i] = states[i + 1];
+            }
+        }
+
+        for(i = 1; i <= nb; i++) {
+            if(states[i - 1] && !states[i]) {
+                log_info("Project %s : commit %s broke the tests (%d commits tested in %d rounds)",
+                    project->project_name, bisection->commits[i - 1], bisection->nbTested, bisection->rounds);
+                write_bisection(project, bisection->repository, bisection->logdir, bisection->base, bisection->head,
+                    bisection->commits[i - 1], bisection->nbTested, bisection->rounds);
+                break;
+            }
+        }
+
+        if(bisection->split) {
+            write_states(project, bisection->logdir, bisection->commits, states, nb);
+        }
+    }
+
+    // the worktrees are left when the rounds were stopped before their removal
+    for(i = 0; i < bisection->nbWorktrees; i++) {
+        char *command = malloc(strlen(bisection->worktrees[i]) + 50);
+        sprintf(command, "git worktree remove -f '%s'", bisection->worktrees[i]);
+        run_quietly(bisection->repository, command);
+        free(command);
+        free(bisection->worktrees[i]);
+    }
+    if(bisection->nbWorktrees > 0) {
+        run_quietly(bisection->repository, "git worktree prune");
+    }
+    remove_scratch(bisection->scratch);
+    unlink(bisection->commitsFile);
+    rmdir(bisection->worktreesDir);
+
+    if(bisection->commits != NULL) {
+        k = bisect_choose_points(states, nb + 1, 1, bisection->split, bisection->points);
+    }
+
+    for(i = 0; i < nb; i++) {
+        free(bisection->commits[i]);
+    }
+    free(bisection->commits);
+    free(bisection->states);
+    free(bisection->points);
+    free(bisection->worktrees);
+    free(bisection->worktreesDir);
+    free(bisection->scratch);
+    free(bisection->commitsFile);
+    free(bisection->repository);
+    free(bisection->logdir);
+    free(bisection);
+
+    return k != 0;
+}
+
+
+int bisect_tests(yk_project *project, const char *reposDir, char *logdir, const yk_schedule *schedule,
+        const yk_job *defaults, int split) {
+
+    yk_bisection *bisection = bisect_start(project, reposDir, logdir, schedule, defaults, split);
+    yk_chain *chain;
+
+    if(bisection == NULL) {
+        return 0;
+    }
+
+    while((chain = bisect_next_round(bisection)) != NULL) {
+        jobs_run(chain, schedule, logdir);
+        bisect_read_round(bisection, chain);
+        jobs_destroy(chain);
+    }
+
+    return bisect_end(bisection);
+}
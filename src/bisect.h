@@ -0,0 +1,120 @@
+/**
+ * \file bisect.h
+ * \brief find the commits which changed the result of the tests of a git project
+ *
+ * The tests are executed on the head of the repository : a batch of
+ * commits is tested at once. When the tests fail after having succeeded,
+ * the batch is split : each round tests as many commits as there are
+ * workers in the test pool, each one in its own worktree of the project's
+ * clone, until each commit which broke the tests is found, succeeding
+ * before it and failing on it ; the commits which fixed them are not
+ * looked for. A batch of n commits takes about log(n) / log(workers + 1)
+ * rounds.
+ *
+ * In the "split" mode, every batch is split the same way, when the tests
+ * are fixed as well as when they are broken, until each change of the
+ * state of the tests is found between two consecutive commits, and the
+ * state of each commit is added in the file
+ * ${LOGDIR}/COMMIT_TESTS_${PROJECT} :
+ *     ${commit};${OK|FAIL|BROKE|FIXED}
+ * When the tests succeed, or fail, before and after a batch, nothing is
+ * tested again : the whole batch takes this state.
+ *
+ * The first commit which broke the tests is added in the file
+ * ${LOGDIR}/BISECT_${PROJECT} :
+ *     ${date};${good};${bad};${first bad};${author};${commentaries};${tested};${rounds}
+ *
+ * The results and the console outputs of the tested commits are written
+ * in a scratch directory, next to the worktrees, removed at the end.
+ * A bisection is either run at once by bisect_tests(), or round by round
+ * by the caller's own scheduler, with bisect_start(), bisect_next_round(),
+ * bisect_read_round() and bisect_end(). The git commands listing the
+ * commits, creating the worktrees and removing them are jobs of their own
+ * rounds too, so that the scheduler never waits for them.
+ */
+
+#ifndef YK_BISECT_H
+#define YK_BISECT_H 1
+
+#include "jobs.h"
+#include "project.h"
+
+
+/**
+ * \brief A bisection in progress.
+ */
+typedef struct yk_bisection_ yk_bisection;
+
+
+/**
+ * \brief Split the batch of commits of the last execution of the tests of a
+ * git project, if they failed while the previous ones succeeded, or in
+ * the split mode, if it is a new batch.
+ * \param project the project
+ * \param reposDir directory of the local copies
+ * \param logdir directory of the output files
+ * \param schedule how to run the tests
+ * \param defaults the job from which the limits of the tests are copied
+ * \param split 1 to find the state of the tests for each commit of each batch
+ * \return 0 if there was nothing to split, or if each change of state was found
+ */
+int bisect_tests(yk_project *project, const char *reposDir, char *logdir, const yk_schedule *schedule,
+        const yk_job *defaults, int split);
+
+
+/**
+ * \brief Begin a bisection, as bisect_tests() : find the batch to split.
+ * \param project the project, which must live until bisect_end()
+ * \param reposDir directory of the local copies
+ * \param logdir directory of the output files
+ * \param schedule how the tests will be run
+ * \param defaults the job from which the limits of the tests are copied
+ * \param split 1 to find the state of the tests for each commit of each batch
+ * \return the bisection, or NULL if there is nothing to split
+ */
+yk_bisection *bisect_start(yk_project *project, const char *reposDir, const char *logdir, const yk_schedule *schedule,
+        const yk_job *defaults, int split);
+
+
+/**
+ * \brief Create the jobs of the next round of a bisection : the listing of
+ * the commits, the creation of the worktrees, the tests of some commits,
+ * each one in its own worktree, at the same time, or the removal of the
+ * worktrees.
+ * \param bisection the bisection
+ * \return the chain of the jobs, named after the project, or NULL if there
+ *         is nothing left to test
+ */
+yk_chain *bisect_next_round(yk_bisection *bisection);
+
+
+/**
+ * \brief Read the results of a round, once its jobs are done.
+ * \param bisection the bisection
+ * \param chain the chain given by bisect_next_round(), still to free
+ */
+void bisect_read_round(yk_bisection *bisection, const yk_chain *chain);
+
+
+/**
+ * \brief Choose the commits to test in a round : the segments whose ends
+ * have different states are split, the workers being shared between them.
+ * \param states the known states, -1 if unknown ; the first and the last are known
+ * \param nb the number of states
+ * \param nbWorkers the number of commits which can be tested at the same time
+ * \param split 1 to split every segment whose ends differ, 0 to only split
+ *        those where the tests broke, succeeding then failing
+ * \param points where to put the indexes of the states to test, nbWorkers at most
+ * \return the number of states to test, 0 if each change of state is found
+ */
+int bisect_choose_points(const int *states, int nb, int nbWorkers, int split, int *points);
+
+
+/**
+ * \brief Write the results of a bisection, remove its worktrees and free it.
+ * \param bisection the bisection
+ * \return 0 if each change of state was found
+ */
+int bisect_end(yk_bisection *bisection);
+
+#endif
@@ -0,0 +1,276 @@
+/**
+ * \file capture.c
+ * \brief bounded and compressed capture of a task's console output
+ */
+
+#include "capture.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/** \brief size of the reading buffer */
+#define CAPTURE_BUF_SIZE 65536
+
+
+struct yk_console_ {
+    gzFile out; /**< \brief the output file */
+    long head; /**< \brief bytes to keep at the beginning, -1 for all */
+    long written; /**< \brief bytes of the head already written */
+    char *ring; /**< \brief the last bytes of the output */
+    long ringSize; /**< \brief size of the ring */
+    long ringPos; /**< \brief where the next byte will be put in the ring */
+    long ringFill; /**< \brief number of bytes in the ring */
+    long long bytes; /**< \brief total number of bytes */
+    long long lines; /**< \brief total number of lines */
+    long long elidedBytes; /**< \brief number of bytes not kept */
+    long long elidedLines; /**< \brief number of lines not kept */
+};
+
+
+/**
+ * Count the '\n' in a buffer.
+ */
+static long count_lines(const char *data, long length) {
+
+    long nb = 0;
+    const char *end = data + length;
+
+    while((data = memchr(data, '\n', end - data)) != NULL) {
+        nb++;
+        data++;
+    }
+
+    return nb;
+}
+
+
+/**
+ * Forget the oldest bytes of the ring.
+ */
+static void ring_evict(yk_console *console, long length) {
+
+    long start = (console->ringPos - console->ringFill + console->ringSize) % console->ringSize;
+    long first = length;
+
+    if(start + first > console->ringSize) {
+        first = console->ringSize - start;
+    }
+
+    console->elidedLines += count_lines(console->ring + start, first);
+    console->elidedLines += count_lines(console->ring, length - first);
+    console->elidedBytes += length;
+    console->ringFill -= length;
+}
+
+
+/**
+ * Put data at the end of the ring, forgetting the oldest bytes if needed.
+ */
+static void ring_push(yk_console *console, const char *data, long length) {
+
+    long first;
+
+    if(console->ringSize == 0) {
+        console->elidedBytes += length;
+        console->elidedLines += count_lines(data, length);
+        return;
+    }
+
+    if(length >= console->ringSize) {
+        ring_evict(console, console->ringFill);
+        console->elidedBytes += length - console->ringSize;
+        console->elidedLines += count_lines(data, length - console->ringSize);
+        memcpy(console->ring, data + length - console->ringSize, console->ringSize);
+        console->ringPos = 0;
+        console->ringFill = console->ringSize;
+        return;
+    }
+
+    if(console->ringFill + length > console->ringSize) {
+        ring_evict(console, console->ringFill + length - console->ringSize);
+    }
+
+    first = length;
+    if(console->ringPos + first > console->ringSize) {
+        first = console->ringSize - console->ringPos;
+    }
+    memcpy(console->ring + console->ringPos, data, first);
+    memcpy(console->ring, data + first, length - first);
+    console->ringPos = (console->ringPos + length) % console->ringSize;
+    console->ringFill += length;
+}
+
+
+yk_console *capture_open(const char *filename, const yk_capture *capture) {
+
+    yk_console *console = malloc(sizeof(yk_console));
+
+    if(console == NULL) {
+        return NULL;
+    }
+
+    // "T" : transparent writing, without compression
+    console->out = gzopen(filename, capture->compress ? "wb6" : "wT");
+    if(console->out == NULL) {
+        log_error("Can't create file %s", filename);
+        free(console);
+        return NULL;
+    }
+
+    console->head = capture->head;
+    console->written = 0;
+    console->ringSize = (capture->head < 0 || capture->tail < 0) ? 0 : capture->tail;
+    console->ring = NULL;
+    if(console->ringSize > 0) {
+        console->ring = malloc(console->ringSize);
+        if(console->ring == NULL) {
+            log_error("Can't allocate %ld bytes for the capture of %s", console->ringSize, filename);
+            console->ringSize = 0;
+        }
+    }
+    console->ringPos = 0;
+    console->ringFill = 0;
+    console->bytes = 0;
+    console->lines = 0;
+    console->elidedBytes = 0;
+    console->elidedLines = 0;
+
+    return console;
+}
+
+
+int capture_write(yk_console *console, const char *data, size_t length) {
+
+    long kept = length;
+
+    console->bytes += length;
+    console->lines += count_lines(data, length);
+
+    if(console->head >= 0 && console->written + kept > console->head) {
+        kept = console->head - console->written;
+    }
+
+    if(kept > 0) {
+        if(gzwrite(console->out, data, kept) != kept) {
+            return 1;
+        }
+        console->written += kept;
+    }
+
+    if(kept < (long) length) {
+        ring_push(console, data + kept, length - kept);
+    }
+
+    return 0;
+}
+
+
+int capture_fd(yk_console *console, int fd) {
+
+    char buffer[CAPTURE_BUF_SIZE];
+    ssize_t length;
+    int err = 0;
+
+    while((length = read(fd, buffer, CAPTURE_BUF_SIZE)) != 0) {
+
+        if(length < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return 1;
+        }
+
+        // keep reading even if the file can't be written, to not block the writer
+        if(!err) {
+            err = capture_write(console, buffer, length);
+        }
+    }
+
+    return err;
+}
+
+
+int capture_close(yk_console *console, const char *notice) {
+
+    long start = 0;
+    long first;
+    int err = 0;
+
+    if(console->ringSize > 0) {
+        start = (console->ringPos - console->ringFill + console->ringSize) % console->ringSize;
+    }
+
+    if(console->elidedBytes > 0 && console->ringFill > 0) {
+        // begin the tail with a whole line
+        long skip = 0;
+        while(skip < console->ringFill - 1 && console->ring[(start + skip) % console->ringSize] != '\n') {
+            skip++;
+        }
+        if(skip < console->ringFill - 1) {
+            ring_evict(console, skip + 1);
+            start = (console->ringPos - console->ringFill + console->ringSize) % console->ringSize;
+        }
+    }
+
+    if(console->elidedBytes > 0) {
+        gzprintf(console->out, "\n[... %lld bytes (%lld lines) elided, output was %lld bytes (%lld lines) ...]\n",
+                console->elidedBytes, console->elidedLines, console->bytes, console->lines);
+    }
+
+    if(console->ringFill > 0) {
+        first = console->ringFill;
+        if(start + first > console->ringSize) {
+            first = console->ringSize - start;
+        }
+        gzwrite(console->out, console->ring + start, first);
+        gzwrite(console->out, console->ring, console->ringFill - first);
+    }
+
+    if(notice != NULL) {
+        gzprintf(console->out, "\n%s\n", notice);
+    }
+
+    if(gzclose(console->out) != Z_OK) {
+        err = 1;
+    }
+
+    free(console->ring);
+    free(console);
+    return err;
+}
+
+
+long capture_parse_size(const char *value) {
+
+    char *end;
+    long size = strtol(value, &end, 10);
+
+    if(end == value || size < 0) {
+        return -1;
+    }
+
+    switch(*end) {
+    case '\0':
+        return size;
+    case 'k':
+    case 'K':
+        size *= 1024;
+        break;
+    case 'm':
+    case 'M':
+        size *= 1024 * 1024;
+        break;
+    case 'g':
+    case 'G':
+        size *= 1024 * 1024 * 1024;
+        break;
+    default:
+        return -1;
+    }
+
+    return end[1] == '\0' ? size : -1;
+}
@@ -0,0 +1,78 @@
+/**
+ * \file capture.h
+ * \brief bounded and compressed capture of a task's console output
+ *
+ * The output of a task may be very long. In capture mode, only the
+ * beginning ("head") and the end ("tail") of the output are kept, the
+ * middle is replaced by a line giving the number of elided bytes and
+ * lines. The file may be compressed with gzip.
+ */
+
+#ifndef YK_CAPTURE_H
+#define YK_CAPTURE_H 1
+
+#include <stddef.h>
+
+
+/**
+ * \brief How to capture an output
+ */
+typedef struct {
+    long head; /**< \brief bytes kept at the beginning of the output, -1 to keep all */
+    long tail; /**< \brief bytes kept at the end of the output */
+    int compress; /**< \brief 1 to write the output with gzip */
+} yk_capture;
+
+
+/**
+ * \brief An output being captured in a file
+ */
+typedef struct yk_console_ yk_console;
+
+
+/**
+ * \brief Create the file where an output will be captured.
+ * \param filename the name of the file
+ * \param capture the limits of the capture
+ * \return the new console or NULL in case of error
+ */
+yk_console *capture_open(const char *filename, const yk_capture *capture);
+
+
+/**
+ * \brief Capture some data.
+ * \param console the capture
+ * \param data the data to add
+ * \param length the number of bytes of data
+ * \return 0 in case of success
+ */
+int capture_write(yk_console *console, const char *data, size_t length);
+
+
+/**
+ * \brief Capture all the data read in a file descriptor, until the end
+ * of file.
+ * \param console the capture
+ * \param fd where to read, usually a pipe
+ * \return 0 in case of success
+ */
+int capture_fd(yk_console *console, int fd);
+
+
+/**
+ * \brief Write the end of the output and close the file.
+ * \param console the capture, freed by this function
+ * \param notice a line added at the end of the file, may be NULL
+ * \return 0 in case of success
+ */
+int capture_close(yk_console *console, const char *notice);
+
+
+/**
+ * \brief Read a size like "512", "64k" or "10M".
+ * \param value the string to read
+ * \return the size in bytes, or -1 if the value is not a size
+ */
+long capture_parse_size(const char *value);
+
+#endif
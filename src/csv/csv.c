@@ -476,12 +476,35 @@ void csv_show_table(csv_table_t *table, FILE *output){
 }
 
 
+/**
+ * @brief a line to sort, with its sorting value and its initial position
+ */
+typedef struct {
+    csv_line_t *line; /**< @brief the line */
+    const char *value; /**< @brief the value of the sorting column */
+    int rank; /**< @brief position of the line before the sort */
+} csv_sort_item_t;
+
+
+/**
+ * @brief compare two lines for a decreasing sort, keeping the order of
+ * the lines with the same value.
+ */
+static int csv_compare_decreasing(const void *item1, const void *item2){
+    const csv_sort_item_t *a = item1;
+    const csv_sort_item_t *b = item2;
+    int cmp = strcmp(b->value, a->value);
+
+    if(cmp != 0) return(cmp);
+    return(a->rank - b->rank);
+}
+
+
 int csv_sort_table_decreasing(csv_table_t *table, const char *columnsName){
     int n; /* index of the sorting column */
-    int i, j; /* counters */
-    csv_line_t **liste, **tri, **tempo; /* tables of pointers to the lines to sort */
+    int i; /* counter */
+    csv_sort_item_t *items; /* the lines to sort */
     csv_line_t *courant; /* crossing of the linked list */
-    char *value1, *value2; /* elements to compare */
 
 
     if(table==NULL) return(-1);
@@ -492,65 +515,30 @@ int csv_sort_table_decreasing(csv_table_t *table, const char *columnsName){
 
     if(table->nbLig==0) return(-4);
 
-    /* allocating the tables */
-    liste=malloc(sizeof(csv_line_t *) * table->nbLig);
-    if(liste==NULL) return(-5);
-
-    tri=malloc(sizeof(csv_line_t *) * table->nbLig);
-    if(tri==NULL) {
-        free(liste);
-        return(-6);
-    }
-
-    tempo=malloc(sizeof(csv_line_t *) * table->nbLig);
-    if(tempo==NULL) {
-        free(liste);
-        free(tri);
-        return(-7);
-    }
+    items=malloc(sizeof(csv_sort_item_t) * table->nbLig);
+    if(items==NULL) return(-5);
 
     /* initializations */
     courant=table->lines;
     for(i = 0; i < table->nbLig; i++){
-        liste[i]=courant;
-        tri[i]=NULL;
-        if(courant!=NULL) courant=courant->next;
+        items[i].line=courant;
+        items[i].value=courant->values[n]!=NULL ? courant->values[n] : "";
+        items[i].rank=i;
+        courant=courant->next;
     }
 
     /* sorting */
-    tri[0]=liste[0];
-
-    for(i=1; i<table->nbLig; i++){
-
-        /* looking for the element position */
-        for(j=0; j<i; j++){
-            /* comparaison */
-            value1=liste[i]->values[n];
-            value2=tri[j]->values[n];
-            if(strcmp(value1, value2)>0) break;
-        }
-
-        /* prospective shift in the bottom of the table */
-        if(j<i){
-            memcpy(tempo, tri+j, sizeof(csv_line_t *)*(table->nbLig-j-1));
-            memcpy(tri+j+1, tempo, sizeof(csv_line_t *)*(table->nbLig-j-1));
-        }
-
-        /* placement of the element */
-        tri[j]=liste[i];
-    }
+    qsort(items, table->nbLig, sizeof(csv_sort_item_t), csv_compare_decreasing);
 
     /* correcting the linkage of the list */
-    table->lines=tri[0];
+    table->lines=items[0].line;
     for(i = 0; i < table->nbLig - 1; i++){
-        tri[i]->next=tri[i+1];
+        items[i].line->next=items[i+1].line;
     }
-    tri[table->nbLig - 1]->next=NULL;
+    items[table->nbLig - 1].line->next=NULL;
 
     /* freeing memory and end */
-    free(liste);
-    free(tri);
-    free(tempo);
+    free(items);
     return(0);
 }
 
@@ -654,6 +642,12 @@ csv_table_t *csv_select_columns(csv_table_t *table, char **searchedElts, int nbS
 
         csv_add_line(selection, contenu, *nbFoundElts);
 
+        /* the line keeps a copy of the values */
+        for(j=0; j<*nbFoundElts; j++){
+            free(contenu[j]);
+        }
+        free(contenu);
+
         ligne=ligne->next;
     }
 
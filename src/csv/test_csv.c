@@ -0,0 +1,61 @@
+/**
+ * @file test_csv.c
+ * Unit test of the sort of a csv table
+ */
+
+#include "csv.h"
+#include <stdio.h>
+#include <string.h>
+
+/** number of lines of the test table */
+#define NB_LINES 6
+
+
+/** Will return 0 on success */
+int main(int argc, char **argv) {
+
+    char *headers[] = { "date", "id" };
+    // the lines with the same date must keep this order
+    char *lines[NB_LINES][2] = {
+        { "2020-01", "a" },
+        { "2021-06", "b" },
+        { "2020-01", "c" },
+        { "2022-03", "d" },
+        { "2021-06", "e" },
+        { "2020-01", "f" }
+    };
+    char *expected = "dbeacf";
+    csv_table_t *table;
+    char value[100];
+    int err = 0;
+    int i;
+
+    fprintf(stdout, "Creating test table\n");
+    table = csv_create_table(headers, 2);
+    for(i = 0; i < NB_LINES; i++) {
+        csv_add_line(table, lines[i], 2);
+    }
+
+    fprintf(stdout, "Sorting by decreasing date\n");
+    if(csv_sort_table_decreasing(table, "date")) {
+        err = 1;
+    }
+
+    for(i = 0; i < NB_LINES && !err; i++) {
+        if(csv_find_value(value, table, "id", i + 1) || value[0] != expected[i]) {
+            fprintf(stdout, "Line %d : expected %c, found %s\n", i + 1, expected[i], value);
+            err = 1;
+        }
+    }
+
+    fprintf(stdout, "Sorting by a missing column\n");
+    if(csv_sort_table_decreasing(table, "missing") >= 0) {
+        err = 1;
+    }
+
+    fprintf(stdout, "Freeing memory\n");
+    csv_destroy_table(table);
+
+    fprintf(stdout, "CSV tests completed\n");
+    return err;
+}
@@ -8,6 +8,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h> // getpid()
+#include <sys/stat.h>
 #include "html.h"
 
 /**
@@ -377,6 +379,530 @@ xmlNode *html_add_image_with_size_in_table(htmlTable *table, char *image, int wi
 }
 
 
+
+
+/** @brief initial size of the buffer of a stream */
+#define STREAM_BUFFER_SIZE 65536
+
+/** @brief the element has no text */
+#define NO_TEXT ((size_t) -1)
+
+/** @brief an element open in a stream */
+typedef struct {
+    size_t name; /**< @brief offset of the tag name in the stream's names */
+    int children; /**< @brief 1 if the element has child elements */
+    size_t text; /**< @brief offset of its text in the buffer, or NO_TEXT */
+} htmlOpenElement;
+
+struct htmlStream_ {
+    char *buffer; /**< @brief the document written so far */
+    size_t length; /**< @brief number of characters in buffer */
+    size_t size; /**< @brief allocated size of buffer */
+    htmlOpenElement *elements; /**< @brief the open elements, the innermost last */
+    int depth; /**< @brief number of open elements */
+    int allocated; /**< @brief allocated number of elements */
+    char *names; /**< @brief the tag names of the open elements */
+    size_t namesLength; /**< @brief number of characters in names */
+    size_t namesSize; /**< @brief allocated size of names */
+    int inTag; /**< @brief 1 if the innermost element's open tag is not ended, it may get attributes */
+};
+
+/** @brief the elements which have no closing tag */
+static const char *voidElements[] = { "br", "hr", "img", "input", "link", "meta", NULL };
+
+
+htmlStream *html_stream_create() {
+
+    htmlStream *stream = malloc(sizeof(htmlStream));
+
+    stream->size = STREAM_BUFFER_SIZE;
+    stream->buffer = malloc(stream->size);
+    stream->length = 0;
+    stream->allocated = 16;
+    stream->elements = malloc(stream->allocated * sizeof(htmlOpenElement));
+    stream->depth = 0;
+    stream->namesSize = 256;
+    stream->names = malloc(stream->namesSize);
+    stream->namesLength = 0;
+    stream->inTag = 0;
+    return stream;
+}
+
+
+void html_stream_destroy(htmlStream *stream) {
+
+    if(stream == NULL) {
+        return;
+    }
+    free(stream->buffer);
+    free(stream->elements);
+    free(stream->names);
+    free(stream);
+}
+
+
+/** Make room for some characters at the end of the buffer */
+static void stream_reserve(htmlStream *stream, size_t length) {
+
+    if(stream->length + length > stream->size) {
+        while(stream->length + length > stream->size) {
+            stream->size *= 2;
+        }
+        stream->buffer = realloc(stream->buffer, stream->size);
+    }
+}
+
+
+/** Append some characters to the buffer */
+static void stream_append(htmlStream *stream, const char *data, size_t length) {
+
+    stream_reserve(stream, length);
+    memcpy(stream->buffer + stream->length, data, length);
+    stream->length += length;
+}
+
+
+/** Append a string to the buffer, escaped or not */
+static void stream_append_text(htmlStream *stream, const char *text, int escape) {
+
+    const char *begin = text;
+    const char *c;
+
+    if(!escape) {
+        stream_append(stream, text, strlen(text));
+        return;
+    }
+
+    for(c = text; *c != '\0'; c++) {
+        const char *entity;
+        switch(*c) {
+            case '&':
+                entity = "&amp;";
+                break;
+            case '<':
+                entity = "&lt;";
+                break;
+            case '>':
+                entity = "&gt;";
+                break;
+            case '"':
+                entity = "&quot;";
+                break;
+            default:
+                continue;
+        }
+        stream_append(stream, begin, c - begin);
+        stream_append(stream, entity, strlen(entity));
+        begin = c + 1;
+    }
+    stream_append(stream, begin, c - begin);
+}
+
+
+/** Indent a line */
+static void stream_indent(htmlStream *stream, int depth) {
+
+    stream_reserve(stream, 4 * depth);
+    memset(stream->buffer + stream->length, ' ', 4 * depth);
+    stream->length += 4 * depth;
+}
+
+
+/** End the open tag of the innermost element */
+static void stream_end_tag(htmlStream *stream) {
+
+    if(stream->inTag) {
+        stream_append(stream, ">", 1);
+        stream->inTag = 0;
+    }
+}
+
+
+/** The text of an element goes on its own line when the element has children */
+static void stream_first_child(htmlStream *stream) {
+
+    htmlOpenElement *parent = &stream->elements[stream->depth - 1];
+
+    parent->children = 1;
+    if(parent->text == NO_TEXT) {
+        stream_append(stream, "\n", 1);
+    } else {
+        size_t textLength = stream->length - parent->text;
+        size_t shift = 1 + 4 * stream->depth;
+
+        stream_reserve(stream, shift + 1);
+        memmove(stream->buffer + parent->text + shift, stream->buffer + parent->text, textLength);
+        stream->buffer[parent->text] = '\n';
+        memset(stream->buffer + parent->text + 1, ' ', shift - 1);
+        stream->length += shift;
+        stream_append(stream, "\n", 1);
+    }
+}
+
+
+void html_stream_open(htmlStream *stream, const char *name) {
+
+    size_t nameLength = strlen(name) + 1;
+    htmlOpenElement *element;
+
+    stream_end_tag(stream);
+    if(stream->depth > 0 && !stream->elements[stream->depth - 1].children) {
+        stream_first_child(stream);
+    }
+
+    stream_indent(stream, stream->depth);
+    stream_append(stream, "<", 1);
+    stream_append(stream, name, nameLength - 1);
+    stream->inTag = 1;
+
+    if(stream->depth == stream->allocated) {
+        stream->allocated *= 2;
+        stream->elements = realloc(stream->elements, stream->allocated * sizeof(htmlOpenElement));
+    }
+    if(stream->namesLength + nameLength > stream->namesSize) {
+        stream->namesSize = 2 * (stream->namesLength + nameLength);
+        stream->names = realloc(stream->names, stream->namesSize);
+    }
+
+    element = &stream->elements[stream->depth++];
+    element->name = stream->namesLength;
+    element->children = 0;
+    element->text = NO_TEXT;
+    memcpy(stream->names + stream->namesLength, name, nameLength);
+    stream->namesLength += nameLength;
+}
+
+
+/** Add an attribute, escaped or not */
+static void stream_attribute(htmlStream *stream, const char *key, const char *value, int escape) {
+
+    if(!stream->inTag) {
+        fprintf(stderr, "Warning: attribute %s out of an open tag\n", key);
+        return;
+    }
+
+    stream_append(stream, " ", 1);
+    stream_append(stream, key, strlen(key));
+    stream_append(stream, "=\"", 2);
+    stream_append_text(stream, value, escape);
+    stream_append(stream, "\"", 1);
+}
+
+
+void html_stream_attribute(htmlStream *stream, const char *key, const char *value) {
+    stream_attribute(stream, key, value, 1);
+}
+
+
+/** Add some text, escaped or not */
+static void stream_text(htmlStream *stream, const char *text, int escape) {
+
+    htmlOpenElement *element;
+
+    if(text == NULL || stream->depth == 0) {
+        return;
+    }
+
+    stream_end_tag(stream);
+    element = &stream->elements[stream->depth - 1];
+
+    if(element->children) {
+        // the text following a child goes on its own line
+        stream_indent(stream, stream->depth);
+        stream_append_text(stream, text, escape);
+        stream_append(stream, "\n", 1);
+    } else {
+        if(element->text == NO_TEXT) {
+            element->text = stream->length;
+        }
+        stream_append_text(stream, text, escape);
+    }
+}
+
+
+void html_stream_text(htmlStream *stream, const char *text) {
+    stream_text(stream, text, 1);
+}
+
+
+void html_stream_close(htmlStream *stream) {
+
+    htmlOpenElement *element;
+    const char *name;
+    int i;
+
+    if(stream->depth == 0) {
+        return;
+    }
+
+    stream_end_tag(stream);
+    element = &stream->elements[--stream->depth];
+    name = stream->names + element->name;
+
+    for(i = 0; voidElements[i] != NULL; i++) {
+        if(!strcmp(name, voidElements[i])) {
+            break;
+        }
+    }
+
+    if(voidElements[i] == NULL) {
+        if(element->children) {
+            stream_indent(stream, stream->depth);
+        }
+        stream_append(stream, "</", 2);
+        stream_append(stream, name, strlen(name));
+        stream_append(stream, ">", 1);
+    }
+    stream_append(stream, "\n", 1);
+
+    stream->namesLength = element->name;
+}
+
+
+void html_stream_node(htmlStream *stream, xmlNode *node) {
+
+    for(; node != NULL; node = node->next) {
+
+        xmlAttribute *attribute;
+
+        html_stream_open(stream, node->name);
+        for(attribute = node->attributes; attribute != NULL; attribute = attribute->next) {
+            stream_attribute(stream, attribute->key, attribute->value, 0);
+        }
+        if(node->text != NULL) {
+            stream_text(stream, node->text, 0);
+        }
+        html_stream_node(stream, node->children);
+        html_stream_close(stream);
+
+        if(node->postText != NULL) {
+            stream_text(stream, node->postText, 0);
+        }
+    }
+}
+
+
+void html_stream_document(htmlStream *stream, char *title, char *cssFile) {
+
+    stream_append_text(stream, HTML5_HEADER "\n", 0);
+    html_stream_open(stream, "html");
+    html_stream_open(stream, "head");
+
+    html_stream_open(stream, "title");
+    html_stream_text(stream, title);
+    html_stream_close(stream);
+
+    html_stream_open(stream, "meta");
+    html_stream_attribute(stream, "charset", "utf-8");
+    html_stream_close(stream);
+
+    if(cssFile != NULL) {
+        html_stream_open(stream, "link");
+        html_stream_attribute(stream, "rel", "stylesheet");
+        html_stream_attribute(stream, "href", cssFile);
+        html_stream_close(stream);
+    }
+
+    html_stream_close(stream);
+    html_stream_open(stream, "body");
+}
+
+
+void html_stream_end_document(htmlStream *stream) {
+
+    while(stream->depth > 0) {
+        html_stream_close(stream);
+    }
+}
+
+
+void html_stream_title(htmlStream *stream, int level, char *title) {
+
+    char htag[3];
+    int l = level;
+
+    if(l>=10) { l=9; }
+    if(l<=0)  { l=1; }
+    sprintf(htag, "h%d", l);
+
+    html_stream_open(stream, htag);
+    html_stream_text(stream, title);
+    html_stream_close(stream);
+}
+
+
+void html_stream_title_with_hr(htmlStream *stream, int level, char *title) {
+
+    html_stream_title(stream, level, title);
+    html_stream_open(stream, "hr");
+    html_stream_close(stream);
+}
+
+
+void html_stream_link(htmlStream *stream, char *text, char *link) {
+
+    html_stream_open(stream, "a");
+    html_stream_attribute(stream, "href", link);
+    html_stream_text(stream, text);
+    html_stream_close(stream);
+}
+
+
+void html_stream_image(htmlStream *stream, char *image, int width, int height, char *title) {
+
+    char attribute[12];
+
+    html_stream_open(stream, "img");
+    html_stream_attribute(stream, "src", image);
+    if(width > 0) {
+        sprintf(attribute, "%d", width);
+        html_stream_attribute(stream, "width", attribute);
+    }
+    if(height > 0) {
+        sprintf(attribute, "%d", height);
+        html_stream_attribute(stream, "height", attribute);
+    }
+    if(title != NULL) {
+        html_stream_attribute(stream, "title", title);
+    }
+    html_stream_close(stream);
+}
+
+
+void html_stream_table_from_data(htmlStream *stream, csv_table_t *data) {
+
+    csv_line_t *csvLine;
+    int j;
+
+    html_stream_open(stream, "table");
+
+    if(data->headers != NULL) {
+        html_stream_open(stream, "thead");
+        html_stream_open(stream, "tr");
+        for(j = 0; j < data->nbCol && data->headers[j] != NULL; j++) {
+            html_stream_open(stream, "th");
+            html_stream_text(stream, data->headers[j]);
+            html_stream_close(stream);
+        }
+        html_stream_close(stream);
+        html_stream_close(stream);
+    }
+
+    html_stream_open(stream, "tbody");
+    for(csvLine = data->lines; csvLine != NULL; csvLine = csvLine->next) {
+        html_stream_open(stream, "tr");
+        for(j = 0; j < data->nbCol; j++) {
+            html_stream_open(stream, "td");
+            html_stream_text(stream, csvLine->values[j]);
+            html_stream_close(stream);
+        }
+        html_stream_close(stream);
+    }
+    html_stream_close(stream);
+
+    html_stream_close(stream);
+}
+
+
+const char *html_stream_content(htmlStream *stream, size_t *length) {
+
+    *length = stream->length;
+    return stream->buffer;
+}
+
+
+int html_stream_write_to_file(htmlStream *stream, char *filename) {
+
+    const char *content = stream->buffer;
+
+    return html_publish(filename, &content, &stream->length, 1);
+}
+
+
+/** @brief bytes read at once to compare a file */
+#define COMPARE_BUFFER_SIZE 65536
+
+/** Tell if a file has a given content */
+static int same_content(const char *filename, const char **parts, const size_t *lengths, int nbParts) {
+
+    char buffer[COMPARE_BUFFER_SIZE];
+    FILE *fd = fopen(filename, "r");
+    int same = (fd != NULL);
+    int i;
+
+    for(i = 0; i < nbParts && same; i++) {
+        size_t offset = 0;
+        while(offset < lengths[i] && same) {
+            size_t length = lengths[i] - offset < COMPARE_BUFFER_SIZE ? lengths[i] - offset : COMPARE_BUFFER_SIZE;
+            same = fread(buffer, 1, length, fd) == length && !memcmp(buffer, parts[i] + offset, length);
+            offset += length;
+        }
+    }
+
+    if(fd != NULL) {
+        same = same && fgetc(fd) == EOF;
+        fclose(fd);
+    }
+    return same;
+}
+
+
+int html_publish(const char *filename, const char **parts, const size_t *lengths, int nbParts) {
+
+    struct stat status;
+    off_t total = 0;
+    char *tmpfile;
+    FILE *fd;
+    int err = 0;
+    int i;
+
+    for(i = 0; i < nbParts; i++) {
+        total += lengths[i];
+    }
+
+    if(!stat(filename, &status) && status.st_size == total && same_content(filename, parts, lengths, nbParts)) {
+        return 0;
+    }
+
+    // in the same directory, for the renaming to be atomic
+    tmpfile = malloc(strlen(filename) + 20);
+    sprintf(tmpfile, "%s.%d.tmp", filename, (int) getpid());
+
+    fd = fopen(tmpfile, "w");
+    if(fd == NULL) {
+        fprintf(stderr, "Can't create file %s\n", tmpfile);
+        free(tmpfile);
+        return 1;
+    }
+
+    for(i = 0; i < nbParts && !err; i++) {
+        err = fwrite(parts[i], 1, lengths[i], fd) != lengths[i];
+    }
+    err = fclose(fd) || err;
+
+    if(err || rename(tmpfile, filename)) {
+        fprintf(stderr, "Can't write file %s\n", filename);
+        remove(tmpfile);
+        err = 1;
+    }
+
+    free(tmpfile);
+    return err;
+}
+
+
 int html_write_to_file(htmlDocument *document, char *filename) {
-    return xml_write_node_in_file(filename, document);
+
+    htmlStream *stream = html_stream_create();
+    int err;
+
+    if(document != NULL && document->header != NULL) {
+        stream_append_text(stream, document->header, 0);
+        stream_append(stream, "\n", 1);
+    }
+    html_stream_node(stream, document);
+
+    err = html_stream_write_to_file(stream, filename);
+    html_stream_destroy(stream);
+    return err;
 }
@@ -24,6 +24,16 @@ typedef xmlNode htmlTable;
 /** @brief Represents an HTML List (<ul>) */
 typedef xmlNode htmlList;
 
+/**
+ * @brief An HTML document written as it is created.
+ *
+ * The elements are opened, given attributes and text, and closed, in the
+ * order of the document. They are written at once in a buffer, without
+ * creating any node : the memory used only depends on the size of the
+ * document. The text and the values of the attributes are escaped.
+ */
+typedef struct htmlStream_ htmlStream;
+
 /**
  * @brief Create a new HTML page.
  * @param title the document's title
@@ -210,7 +220,19 @@ xmlNode *html_add_image_with_size_in_table(htmlTable *table, char *image, int wi
 
 
 /**
- * @brief Write the HTML document in a file.
+ * @brief Replace a file by a content, only if the content differs. The
+ * file is written under another name, then renamed : it is never seen
+ * partially written, and it is left untouched if it didn't change.
+ * @param filename the file
+ * @param parts the content, in several parts
+ * @param lengths the length of each part
+ * @param nbParts number of parts
+ * @return an error code, or 0 in case of success
+ */
+int html_publish(const char *filename, const char **parts, const size_t *lengths, int nbParts);
+
+/**
+ * @brief Write the HTML document in a file, if it changed.
  * @param document the document to write
  * @param filename the name of html file
  * @return an error code, or 0 in case of success
@@ -218,5 +240,126 @@ xmlNode *html_add_image_with_size_in_table(htmlTable *table, char *image, int wi
 int html_write_to_file(htmlDocument *document, char *filename);
 
 
+/**
+ * @brief Create an empty HTML stream.
+ * @return the new stream
+ */
+htmlStream *html_stream_create();
+
+/**
+ * @brief Free the memory used by an HTML stream.
+ * @param stream the stream to free
+ */
+void html_stream_destroy(htmlStream *stream);
+
+/**
+ * @brief Open an element, in the innermost open element.
+ * @param stream the stream
+ * @param name the element's tag name
+ */
+void html_stream_open(htmlStream *stream, const char *name);
+
+/**
+ * @brief Add an attribute to the element just opened.
+ * @param stream the stream
+ * @param key the attribute's name
+ * @param value the attribute's value
+ */
+void html_stream_attribute(htmlStream *stream, const char *key, const char *value);
+
+/**
+ * @brief Add some text to the innermost open element.
+ * @param stream the stream
+ * @param text the text, may be NULL
+ */
+void html_stream_text(htmlStream *stream, const char *text);
+
+/**
+ * @brief Close the innermost open element.
+ * @param stream the stream
+ */
+void html_stream_close(htmlStream *stream);
+
+/**
+ * @brief Write a XML document, as read by xml_read_file(), in the
+ * innermost open element. Its text is already markup : it is not escaped.
+ * @param stream the stream
+ * @param node the document, may be NULL
+ */
+void html_stream_node(htmlStream *stream, xmlNode *node);
+
+/**
+ * @brief Begin a HTML page, up to the opening of its body.
+ * @param stream the stream
+ * @param title the document's title
+ * @param cssFile a stylesheet, or NULL
+ */
+void html_stream_document(htmlStream *stream, char *title, char *cssFile);
+
+/**
+ * @brief Close all the open elements.
+ * @param stream the stream
+ */
+void html_stream_end_document(htmlStream *stream);
+
+/**
+ * @brief Write a chapter title with H balise.
+ * @param stream the stream
+ * @param level level of the title : 1 to 5
+ * @param title content enter <h> and </h> balise
+ */
+void html_stream_title(htmlStream *stream, int level, char *title);
+
+/**
+ * @brief Write a chapter title with H balise, and an horizontal line
+ * under the title
+ * @param stream the stream
+ * @param level level of the title : 1 to 5
+ * @param title content enter <h> and </h> balise
+ */
+void html_stream_title_with_hr(htmlStream *stream, int level, char *title);
+
+/**
+ * @brief Write a text with a hyperlink.
+ * @param stream the stream
+ * @param text appearing text
+ * @param link url to point in the link
+ */
+void html_stream_link(htmlStream *stream, char *text, char *link);
+
+/**
+ * @brief Write an image.
+ * @param stream the stream
+ * @param image the image's url
+ * @param width width of image, or 0
+ * @param height height of image, or 0
+ * @param title the image's tooltip, or NULL
+ */
+void html_stream_image(htmlStream *stream, char *image, int width, int height, char *title);
+
+/**
+ * @brief Write a table of data.
+ * @param stream the stream
+ * @param data the data to write
+ */
+void html_stream_table_from_data(htmlStream *stream, csv_table_t *data);
+
+/**
+ * @brief Get the document written in a HTML stream.
+ * @param stream the stream
+ * @param length where to put the length of the document
+ * @return the document, not ended by '\0', valid until the stream changes
+ */
+const char *html_stream_content(htmlStream *stream, size_t *length);
+
+/**
+ * @brief Write the HTML stream in a file, if it changed.
+ * @param stream the stream, with all its elements closed
+ * @param filename the name of html file
+ * @return an error code, or 0 in case of success
+ */
+int html_stream_write_to_file(htmlStream *stream, char *filename);
+
+
 
 #endif
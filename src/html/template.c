@@ -0,0 +1,248 @@
+/**
+ * @file template.c
+ * @brief Precompiled HTML templates
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "template.h"
+#include "html.h"
+
+/** @brief a part of a template */
+typedef struct {
+    int slot; /**< @brief index of the slot, or -1 for a literal segment */
+    size_t offset; /**< @brief for a literal segment, its offset in the template's literals */
+    size_t length; /**< @brief for a literal segment, its length */
+} htmlTemplatePart;
+
+struct htmlTemplate_ {
+    char *literals; /**< @brief the literal segments, one after the other */
+    size_t length; /**< @brief length of the literals */
+    size_t size; /**< @brief allocated size of the literals */
+    htmlTemplatePart *parts; /**< @brief the segments and the slots, in order */
+    int nbParts; /**< @brief number of parts */
+    int allocated; /**< @brief allocated number of parts */
+    char **includes; /**< @brief the included files, relative to the template's directory */
+    int nbIncludes; /**< @brief number of included files */
+};
+
+
+/** Read a whole file */
+static char *read_file(const char *filename, size_t *length) {
+
+    FILE *fd = fopen(filename, "r");
+    char *content;
+    long size;
+
+    if(fd == NULL) {
+        return NULL;
+    }
+
+    if(fseek(fd, 0, SEEK_END) || (size = ftell(fd)) < 0 || fseek(fd, 0, SEEK_SET)) {
+        fclose(fd);
+        return NULL;
+    }
+
+    content = malloc(size + 1);
+    *length = fread(content, 1, size, fd);
+    content[*length] = '\0';
+    fclose(fd);
+    return content;
+}
+
+
+/** Add a part to a template */
+static htmlTemplatePart *add_part(htmlTemplate *template, int slot) {
+
+    htmlTemplatePart *part;
+
+    if(template->nbParts == template->allocated) {
+        template->allocated *= 2;
+        template->parts = realloc(template->parts, template->allocated * sizeof(htmlTemplatePart));
+    }
+
+    part = &template->parts[template->nbParts++];
+    part->slot = slot;
+    part->offset = template->length;
+    part->length = 0;
+    return part;
+}
+
+
+/** Append some text to the literal segments, joined with the previous one */
+static void add_literal(htmlTemplate *template, const char *text, size_t length) {
+
+    htmlTemplatePart *last = template->nbParts > 0 ? &template->parts[template->nbParts - 1] : NULL;
+
+    if(length == 0) {
+        return;
+    }
+
+    if(last == NULL || last->slot != -1) {
+        last = add_part(template, -1);
+    }
+
+    if(template->length + length > template->size) {
+        while(template->length + length > template->size) {
+            template->size *= 2;
+        }
+        template->literals = realloc(template->literals, template->size);
+    }
+
+    memcpy(template->literals + template->length, text, length);
+    template->length += length;
+    last->length += length;
+}
+
+
+htmlTemplate *html_template_create(const char *text, const char *dir, char **slots, int nbSlots) {
+
+    htmlTemplate *template = malloc(sizeof(htmlTemplate));
+    const char *c = text;
+
+    template->size = 4096;
+    template->literals = malloc(template->size);
+    template->length = 0;
+    template->allocated = 16;
+    template->parts = malloc(template->allocated * sizeof(htmlTemplatePart));
+    template->nbParts = 0;
+    template->includes = NULL;
+    template->nbIncludes = 0;
+
+    for(;;) {
+        const char *begin = strstr(c, "${");
+        const char *end = begin != NULL ? strchr(begin, '}') : NULL;
+        size_t nameLength;
+        int i;
+
+        if(end == NULL) {
+            add_literal(template, c, strlen(c));
+            break;
+        }
+
+        add_literal(template, c, begin - c);
+        begin += 2;
+        nameLength = end - begin;
+        c = end + 1;
+
+        if(nameLength > 8 && !strncmp(begin, "include ", 8)) {
+
+            char *filename = malloc(strlen(dir) + nameLength - 8 + 2);
+            char *content;
+            size_t length;
+
+            sprintf(filename, "%s/%.*s", dir, (int) (nameLength - 8), begin + 8);
+            // a missing file is listed too : the pages change when it appears
+            template->includes = realloc(template->includes, (template->nbIncludes + 1) * sizeof(char *));
+            template->includes[template->nbIncludes++] = strdup(filename + strlen(dir) + 1);
+            content = read_file(filename, &length);
+            if(content == NULL) {
+                fprintf(stderr, "Can't read file %s\n", filename);
+            } else {
+                add_literal(template, content, length);
+                free(content);
+            }
+            free(filename);
+            continue;
+        }
+
+        for(i = 0; i < nbSlots; i++) {
+            if(strlen(slots[i]) == nameLength && !strncmp(slots[i], begin, nameLength)) {
+                break;
+            }
+        }
+
+        if(i == nbSlots) {
+            fprintf(stderr, "Unknown slot ${%.*s} in template\n", (int) nameLength, begin);
+            html_template_destroy(template);
+            return NULL;
+        }
+        add_part(template, i);
+    }
+
+    return template;
+}
+
+
+htmlTemplate *html_template_read(const char *filename, char **slots, int nbSlots) {
+
+    htmlTemplate *template;
+    char *text;
+    char *dir;
+    char *slash;
+    size_t length;
+
+    text = read_file(filename, &length);
+    if(text == NULL) {
+        return NULL;
+    }
+
+    dir = strdup(filename);
+    slash = strrchr(dir, '/');
+    if(slash != NULL) {
+        *slash = '\0';
+    } else {
+        strcpy(dir, ".");
+    }
+
+    template = html_template_create(text, dir, slots, nbSlots);
+    free(dir);
+    free(text);
+    return template;
+}
+
+
+int html_template_write_to_file(const htmlTemplate *template, char **values, const size_t *lengths, const char *filename) {
+
+    const char **parts = malloc((template->nbParts + 1) * sizeof(char *));
+    size_t *partLengths = malloc((template->nbParts + 1) * sizeof(size_t));
+    int nbParts = 0;
+    int err;
+    int i;
+
+    for(i = 0; i < template->nbParts; i++) {
+
+        const htmlTemplatePart *part = &template->parts[i];
+
+        if(part->slot == -1) {
+            parts[nbParts] = template->literals + part->offset;
+            partLengths[nbParts] = part->length;
+        } else if(values[part->slot] != NULL) {
+            parts[nbParts] = values[part->slot];
+            partLengths[nbParts] = lengths != NULL ? lengths[part->slot] : strlen(values[part->slot]);
+        } else {
+            continue;
+        }
+        nbParts++;
+    }
+
+    err = html_publish(filename, parts, partLengths, nbParts);
+    free(parts);
+    free(partLengths);
+    return err;
+}
+
+
+char **html_template_includes(const htmlTemplate *template, int *nb) {
+
+    *nb = template->nbIncludes;
+    return template->includes;
+}
+
+
+void html_template_destroy(htmlTemplate *template) {
+
+    int i;
+
+    if(template == NULL) {
+        return;
+    }
+    for(i = 0; i < template->nbIncludes; i++) {
+        free(template->includes[i]);
+    }
+    free(template->includes);
+    free(template->literals);
+    free(template->parts);
+    free(template);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file template.h
+ * @brief Precompiled HTML templates
+ *
+ * A template is a text with placeholders :
+ * <ul>
+ * <li>${NAME} is a slot, filled with a value at each rendering
+ * <li>${include FILE} is replaced by the content of FILE, relative to
+ * the template's directory, once for all ; nothing if FILE can't be read
+ * </ul>
+ * A template is compiled once in literal segments and slots. Rendering it
+ * only writes the segments and the values of the slots, which are written
+ * as they are : they must already be HTML.
+ */
+
+#ifndef HTML_TEMPLATE_H_
+#define HTML_TEMPLATE_H_
+
+#include <stddef.h>
+
+/** @brief A compiled template */
+typedef struct htmlTemplate_ htmlTemplate;
+
+/**
+ * @brief Compile a template.
+ * @param text the template
+ * @param dir the directory of the included files
+ * @param slots the names of the slots, the values of a rendering are
+ *        given in the same order
+ * @param nbSlots number of slots
+ * @return the template, or NULL if it has an unknown slot
+ */
+htmlTemplate *html_template_create(const char *text, const char *dir, char **slots, int nbSlots);
+
+/**
+ * @brief Read and compile a template.
+ * @param filename the template's file
+ * @param slots the names of the slots
+ * @param nbSlots number of slots
+ * @return the template, or NULL if the file can't be read or compiled
+ */
+htmlTemplate *html_template_read(const char *filename, char **slots, int nbSlots);
+
+/**
+ * @brief Render a template in a file, if the file's content changes.
+ * @param template the template
+ * @param values the values of the slots
+ * @param lengths the lengths of the values, or NULL if they are strings
+ * @param filename the file to create
+ * @return an error code, or 0 in case of success
+ */
+int html_template_write_to_file(const htmlTemplate *template, char **values, const size_t *lengths, const char *filename);
+
+/**
+ * @brief List the files included by a template, even the missing ones.
+ * @param template the template
+ * @param nb set to the number of files
+ * @return the files, relative to the template's directory, in the order
+ *         of the template ; they belong to the template
+ */
+char **html_template_includes(const htmlTemplate *template, int *nb);
+
+/**
+ * @brief Free the memory used by a template.
+ * @param template the template to free
+ */
+void html_template_destroy(htmlTemplate *template);
+
+#endif
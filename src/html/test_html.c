@@ -0,0 +1,174 @@
+/**
+ * @file test_html.c
+ * Unit test of the HTML templates and of the publication of the pages
+ */
+
+#include "template.h"
+#include "html.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/** the file included by the template */
+#define INCLUDED_FILE "included.tmp"
+/** output file */
+#define OUTPUT_FILE "page.tmp"
+
+
+/**
+ * @brief Compare the content of a file with the expected one.
+ * @return 0 if the file has the expected content
+ */
+static int check_file(const char *filename, const char *expected) {
+
+    char content[500];
+    FILE *fd = fopen(filename, "r");
+    size_t length;
+
+    if(fd == NULL) {
+        fprintf(stdout, "Can't read %s\n", filename);
+        return 1;
+    }
+    length = fread(content, 1, sizeof(content) - 1, fd);
+    content[length] = '\0';
+    fclose(fd);
+
+    if(strcmp(content, expected)) {
+        fprintf(stdout, "Unexpected content of %s : %s\n", filename, content);
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Test the compilation and the rendering of a template.
+ * @return the number of errors
+ */
+static int test_template() {
+
+    char *slots[] = { "TITLE", "BODY" };
+    char *values[] = { "Title", "<p>body</p>" };
+    char *missing[] = { "Title", NULL };
+    size_t lengths[] = { 3, 4 };
+    htmlTemplate *template;
+    char **includes;
+    int nbIncludes;
+    int err = 0;
+    FILE *fd;
+
+    fd = fopen(INCLUDED_FILE, "w");
+    fputs("<b>banner</b>", fd);
+    fclose(fd);
+
+    fprintf(stdout, "Compiling a template\n");
+    template = html_template_create("<h1>${TITLE}</h1>${include " INCLUDED_FILE "}${BODY}"
+            "${include missing.tmp}<i>${TITLE}</i>${ not a slot", ".", slots, 2);
+    if(template == NULL) {
+        return 1;
+    }
+
+    includes = html_template_includes(template, &nbIncludes);
+    if(nbIncludes != 2 || strcmp(includes[0], INCLUDED_FILE) || strcmp(includes[1], "missing.tmp")) {
+        fprintf(stdout, "Unexpected included files\n");
+        err++;
+    }
+
+    fprintf(stdout, "Rendering the template\n");
+    html_template_write_to_file(template, values, NULL, OUTPUT_FILE);
+    err += check_file(OUTPUT_FILE, "<h1>Title</h1><b>banner</b><p>body</p><i>Title</i>${ not a slot");
+
+    fprintf(stdout, "Rendering the template with a missing value\n");
+    html_template_write_to_file(template, missing, NULL, OUTPUT_FILE);
+    err += check_file(OUTPUT_FILE, "<h1>Title</h1><b>banner</b><i>Title</i>${ not a slot");
+
+    fprintf(stdout, "Rendering the template with the values' lengths\n");
+    html_template_write_to_file(template, values, lengths, OUTPUT_FILE);
+    err += check_file(OUTPUT_FILE, "<h1>Tit</h1><b>banner</b><p>b<i>Tit</i>${ not a slot");
+    html_template_destroy(template);
+
+    fprintf(stdout, "Compiling a template with an unknown slot\n");
+    template = html_template_create("<h1>${TITLE}</h1>${OTHER}", ".", slots, 2);
+    if(template != NULL) {
+        html_template_destroy(template);
+        err++;
+    }
+
+    return err;
+}
+
+
+/**
+ * @brief Publish a content in two parts.
+ * @param status set to the state of the file once published
+ * @return the error code of html_publish()
+ */
+static int publish(const char *first, const char *second, struct stat *status) {
+
+    const char *parts[] = { first, second };
+    size_t lengths[] = { strlen(first), strlen(second) };
+    int err = html_publish(OUTPUT_FILE, parts, lengths, 2);
+
+    stat(OUTPUT_FILE, status);
+    return err;
+}
+
+
+/**
+ * @brief Test that a page is only replaced when its content changes.
+ * @return the number of errors
+ */
+static int test_publish() {
+
+    struct stat before, after;
+    char tmpfile[50];
+    int err = 0;
+
+    remove(OUTPUT_FILE);
+
+    fprintf(stdout, "Publishing a new page\n");
+    err += publish("<p>one</p>", "<p>two</p>", &before);
+    err += check_file(OUTPUT_FILE, "<p>one</p><p>two</p>");
+
+    // the file is replaced by a renaming : a new inode
+    fprintf(stdout, "Publishing the same content\n");
+    err += publish("<p>one</p><p>", "two</p>", &after);
+    if(after.st_ino != before.st_ino) {
+        fprintf(stdout, "The page was replaced\n");
+        err++;
+    }
+
+    fprintf(stdout, "Publishing another content of the same size\n");
+    err += publish("<p>one</p>", "<p>TWO</p>", &after);
+    err += check_file(OUTPUT_FILE, "<p>one</p><p>TWO</p>");
+    if(after.st_ino == before.st_ino) {
+        fprintf(stdout, "The page was written in place\n");
+        err++;
+    }
+
+    fprintf(stdout, "Publishing a shorter content\n");
+    err += publish("<p>one</p>", "", &after);
+    err += check_file(OUTPUT_FILE, "<p>one</p>");
+
+    sprintf(tmpfile, "%s.%d.tmp", OUTPUT_FILE, (int) getpid());
+    if(!access(tmpfile, F_OK)) {
+        fprintf(stdout, "The temporary file %s was left\n", tmpfile);
+        err++;
+    }
+
+    return err;
+}
+
+
+/** Will return 0 on success */
+int main(int argc, char **argv) {
+
+    int err = 0;
+
+    err += test_template();
+    err += test_publish();
+
+    fprintf(stdout, "HTML tests completed, %d error(s)\n", err);
+    return err != 0;
+}
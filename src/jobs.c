@@ -0,0 +1,2073 @@
+/**
+ * \file jobs.c
+ * \brief execution of Yannkins' tasks by a pool of workers
+ *
+ * One line is added in the result file ${LOGDIR}/${TASK} for each
+ * execution of a task :
+ *     ${date};FAIL;${usage} (in case of failure)
+ *     ${date};OK;${usage}   (in case of success)
+ * where ${usage} are the resources used by the task : wall clock
+ * duration, user and system CPU time (in seconds), peak resident memory
+ * (in kB), and the number of blocks read and written.
+ * If the task exceeds its wall clock or CPU time limit, its process group
+ * is killed and the result is TIMEOUT.
+ * The last columns are the revision of the working copy and a hash of the
+ * command. If they are the same as for the last execution, the task is
+ * not run again and its result is "SKIPPED (up to date)". If a task the
+ * job depends on fails, the result is "SKIPPED (dependency failed)".
+ */
+
+/** \brief where are created output files */
+#define LOG_DIR "log"
+
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <signal.h>
+#include "jobs.h"
+#include "logger.h"
+#include "agents.h"
+#include "procutil.h"
+
+/** \brief max length of a line in a result file */
+#define RESULT_LINE_SIZE 4096
+
+/** \brief first line of a result file */
+#define RESULT_HEADER "date;result;duration;user;system;maxrss;inblock;oublock;revision;command"
+
+/** \brief number of columns of a result file */
+#define RESULT_COLUMNS 10
+
+/** \brief result of a task not executed because nothing changed */
+#define SKIPPED_RESULT -2
+
+/** \brief how a skipped task is written in the result file */
+#define SKIPPED_STRING "SKIPPED (up to date)"
+
+/** \brief result of a task not executed because a dependency failed */
+#define DEPENDENCY_RESULT -3
+
+/** \brief how a task not executed because a dependency failed is written */
+#define DEPENDENCY_STRING "SKIPPED (dependency failed)"
+
+/** \brief how a cancelled task is written */
+#define CANCELLED_STRING "CANCELLED"
+
+/** \brief seconds between two checks of the tasks' limits */
+#define TICK 1
+
+/** \brief number of previous executions giving the expected duration of a task */
+#define HISTORY_RUNS 5
+
+/** \brief seconds of rank gained by a ready job for each second it waits */
+#define AGING_RATE 1
+
+/** \brief percent of the memory kept available when a task starts */
+#define MEMORY_RESERVE 10
+
+/** \brief a token of the make jobserver */
+#define TOKEN '+'
+
+/** \brief times a job is started again after the loss of its agent, before it fails */
+#define LOST_RETRIES 1
+
+/**
+ * \brief State of a call to jobs_run().
+ */
+typedef struct {
+    const yk_schedule *schedule; /**< \brief how to run the jobs */
+    char *logdir; /**< \brief directory of the ouptut files */
+    int running; /**< \brief number of running jobs */
+    int remote; /**< \brief number of jobs running on the agents */
+    int byPool[NB_POOLS]; /**< \brief number of running jobs of each pool */
+    int err; /**< \brief set to 1 in case of error */
+    int tokens[2]; /**< \brief pipe of the make jobserver, -1 if there is none */
+    int tokenReader; /**< \brief non blocking reading end of the jobserver, for the scheduler */
+    int held; /**< \brief number of tokens held by the running jobs */
+    char *makeflags; /**< \brief MAKEFLAGS before the jobserver was added, NULL if it was not set */
+    long reserved; /**< \brief sum of the expected peaks of memory of the running jobs, in kB */
+} yk_run;
+
+
+static char stringDate[50];
+
+
+/**
+ * \return the directory of the output files of a job
+ */
+static char *job_logdir(const yk_run *run, const yk_job *job) {
+    return job->logdir != NULL ? job->logdir : run->logdir;
+}
+
+/**
+ * Format a timestamp in a readable format (%d/%m/%Y %H:%M).
+ * \date a timestamp
+ * \return a char string representing the date. This is a pointer to a
+ *         statically allocated memory zone : don't free it.
+ */
+static char *printDate(time_t date) {
+    struct tm *sdate = localtime(&date);
+    // %d/%m/%Y %H:%M
+    sprintf(stringDate, "%02d/%02d/%04d %02d:%02d", sdate->tm_mday, sdate->tm_mon+1, sdate->tm_year+1900,
+            sdate->tm_hour, sdate->tm_min);
+    return stringDate;
+}
+
+/**
+ * Count the number of fields in a line of a result file.
+ */
+static int count_columns(const char *line) {
+
+    int nb = 1;
+
+    while(*line != '\0' && *line != '\n') {
+        if(*line == ';') {
+            nb++;
+        }
+        line++;
+    }
+
+    return nb;
+}
+
+
+/**
+ * Rewrite a result file created by an older version of tache, adding
+ * empty fields for the missing columns.
+ *
+ * \param ficlog the result file
+ * \return 0 if the file has now the expected format
+ */
+static int upgrade_result_file(const char *ficlog) {
+
+    FILE *flog;
+    FILE *fnew;
+    char *ficnew;
+    char line[RESULT_LINE_SIZE];
+    int missing;
+    int i;
+
+    flog = fopen(ficlog, "r");
+    if(flog == NULL) {
+        // nothing to upgrade
+        return 0;
+    }
+
+    if(fgets(line, RESULT_LINE_SIZE, flog) == NULL) {
+        fclose(flog);
+        return 0;
+    }
+
+    missing = RESULT_COLUMNS - count_columns(line);
+    if(missing <= 0) {
+        fclose(flog);
+        return 0;
+    }
+
+    ficnew = malloc(sizeof(char) * (strlen(ficlog) + 5));
+    sprintf(ficnew, "%s.new", ficlog);
+    fnew = fopen(ficnew, "w");
+    if(fnew == NULL) {
+        log_error("Could not create the file %s", ficnew);
+        free(ficnew);
+        fclose(flog);
+        return 1;
+    }
+
+    log_info("Upgrading the format of %s", ficlog);
+    fprintf(fnew, "%s\n", RESULT_HEADER);
+    while(fgets(line, RESULT_LINE_SIZE, flog) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if(line[0] == '\0') {
+            continue;
+        }
+        fprintf(fnew, "%s", line);
+        for(i = 0; i < missing; i++) {
+            fprintf(fnew, ";");
+        }
+        fprintf(fnew, "\n");
+    }
+
+    fclose(flog);
+    fclose(fnew);
+
+    if(rename(ficnew, ficlog)) {
+        log_error("Could not replace %s", ficlog);
+        free(ficnew);
+        return 1;
+    }
+
+    free(ficnew);
+    return 0;
+}
+
+
+/**
+ * Compute a hash of a command (64 bits FNV-1a).
+ *
+ * \param command the command
+ * \param hash where to write the hash in hexadecimal, 17 characters
+ */
+static void hash_command(const char *command, char *hash) {
+
+    unsigned long long value = 14695981039346656037ULL;
+
+    while(*command != '\0') {
+        value ^= (unsigned char) *command;
+        value *= 1099511628211ULL;
+        command++;
+    }
+
+    sprintf(hash, "%016llx", value);
+}
+
+
+/**
+ * Save the task's result in the appropriate file.
+ *
+ * \param date the execution date
+ * \param resultat task's return value (0==success, TIMEOUT_RESULT if killed,
+ *        SKIPPED_RESULT or DEPENDENCY_RESULT if not executed)
+ * \param usage the resources used by the task, NULL if it was not executed
+ * \param job the task
+ * \param logdir directory where the logs are saved
+ * \return 0 if the result was saved
+ */
+static int save_result(time_t date, int resultat, const yk_usage *usage, const yk_job *job, char *logdir){
+
+    const char *tache = job->task;
+    char *stringResult;
+    char *ficlog;
+    char hash[17];
+    FILE *flog = NULL;
+
+    if(!resultat) {
+        stringResult = "OK";
+    } else if(resultat == TIMEOUT_RESULT) {
+        stringResult = "TIMEOUT";
+    } else if(resultat == SKIPPED_RESULT) {
+        stringResult = SKIPPED_STRING;
+    } else if(resultat == DEPENDENCY_RESULT) {
+        stringResult = DEPENDENCY_STRING;
+    } else if(resultat == CANCELLED_RESULT) {
+        stringResult = CANCELLED_STRING;
+    } else {
+        stringResult = "FAIL";
+    }
+
+    ficlog = malloc(sizeof(char) * (strlen(logdir) + strlen(tache) + 2));
+    if(ficlog == NULL) {
+        log_error("Task %s could not allocate memory. Task's result won't be saved.", tache);
+        return 1;
+    }
+
+    sprintf(ficlog, "%s/%s", logdir, tache);
+    upgrade_result_file(ficlog);
+    flog = fopen(ficlog, "a");
+    if(flog == NULL) {
+        log_error("Task %s could not create or modify the file %s. Task's result won't be saved.", tache, ficlog);
+        free(ficlog);
+        return 2;
+    }
+    free(ficlog);
+
+    fseek(flog, 0, SEEK_END);
+    if(!ftell(flog)) {
+        fprintf(flog, "%s\n", RESULT_HEADER);
+    }
+
+    fprintf(flog, "%s;%s;", printDate(date), stringResult);
+    if(usage != NULL) {
+        fprintf(flog, "%.2f;%.2f;%.2f;%ld;%ld;%ld;", usage->duration, usage->user, usage->system,
+                usage->maxrss, usage->inblock, usage->oublock);
+    } else {
+        fprintf(flog, ";;;;;;");
+    }
+    hash_command(job->command, hash);
+    fprintf(flog, "%s;%s\n", job->revision, hash);
+    fclose(flog);
+    return 0;
+}
+
+
+/**
+ * Find the revision and the command of the last execution of a task.
+ *
+ * \param logdir directory where the logs are saved
+ * \param tache the task's name
+ * \param revision where to copy the revision, REVISION_SIZE characters
+ * \param hash where to copy the hash of the command, 17 characters
+ * \param success set to 1 if the last execution succeeded
+ * \return 0 if the last execution ended with OK or FAIL
+ */
+static int read_last_execution(char *logdir, const char *tache, char *revision, char *hash, int *success) {
+
+    char *ficlog;
+    FILE *flog;
+    char line[RESULT_LINE_SIZE];
+    int found = 0;
+
+    ficlog = malloc(sizeof(char) * (strlen(logdir) + strlen(tache) + 2));
+    sprintf(ficlog, "%s/%s", logdir, tache);
+    flog = fopen(ficlog, "r");
+    free(ficlog);
+    if(flog == NULL) {
+        return 1;
+    }
+
+    // skip the header
+    if(fgets(line, RESULT_LINE_SIZE, flog) == NULL) {
+        fclose(flog);
+        return 1;
+    }
+
+    while(fgets(line, RESULT_LINE_SIZE, flog) != NULL) {
+
+        char *fields[RESULT_COLUMNS];
+        char *saveptr = line;
+        int i;
+
+        line[strcspn(line, "\r\n")] = '\0';
+        for(i = 0; i < RESULT_COLUMNS; i++) {
+            fields[i] = strsep(&saveptr, ";");
+            if(fields[i] == NULL) {
+                break;
+            }
+        }
+
+        if(i < RESULT_COLUMNS || !strncmp(fields[1], "SKIPPED", 7)) {
+            continue;
+        }
+
+        // a task killed may succeed next time
+        found = strcmp(fields[1], "OK") && strcmp(fields[1], "FAIL") ? 0 : 1;
+        *success = !strcmp(fields[1], "OK");
+        strncpy(revision, fields[8], REVISION_SIZE - 1);
+        revision[REVISION_SIZE - 1] = '\0';
+        strncpy(hash, fields[9], 16);
+        hash[16] = '\0';
+    }
+
+    fclose(flog);
+    return !found;
+}
+
+
+/**
+ * Find the expected duration and peak of memory of a task, from its last
+ * executions : the mean of their durations and the highest of their
+ * peaks. The skipped and cancelled ones are not counted, a timeout counts
+ * for the duration the task ran.
+ *
+ * \param logdir directory where the logs are saved
+ * \param tache the task's name
+ * \param duration set to the expected duration in seconds, or -1 if the task was never executed
+ * \param maxrss set to the expected peak of resident memory in kB, or 0 if unknown
+ */
+static void read_history(char *logdir, const char *tache, double *duration, long *maxrss) {
+
+    char *ficlog;
+    FILE *flog;
+    char line[RESULT_LINE_SIZE];
+    double durations[HISTORY_RUNS];
+    long peaks[HISTORY_RUNS];
+    double sum = 0;
+    int nb = 0;
+    int i;
+
+    *duration = -1;
+    *maxrss = 0;
+
+    ficlog = malloc(sizeof(char) * (strlen(logdir) + strlen(tache) + 2));
+    sprintf(ficlog, "%s/%s", logdir, tache);
+    flog = fopen(ficlog, "r");
+    free(ficlog);
+    if(flog == NULL) {
+        return;
+    }
+
+    // skip the header
+    if(fgets(line, RESULT_LINE_SIZE, flog) == NULL) {
+        fclose(flog);
+        return;
+    }
+
+    while(fgets(line, RESULT_LINE_SIZE, flog) != NULL) {
+
+        char *fields[6];
+        char *saveptr = line;
+
+        for(i = 0; i < 6; i++) {
+            fields[i] = strsep(&saveptr, ";");
+            if(fields[i] == NULL) {
+                break;
+            }
+        }
+
+        if(i < 6 || fields[2][0] == '\0' || !strncmp(fields[1], "SKIPPED", 7) || !strcmp(fields[1], CANCELLED_STRING)) {
+            continue;
+        }
+
+        // the last executions, in a circular buffer
+        durations[nb % HISTORY_RUNS] = atof(fields[2]);
+        peaks[nb % HISTORY_RUNS] = atol(fields[5]);
+        nb++;
+    }
+
+    fclose(flog);
+
+    if(nb > HISTORY_RUNS) {
+        nb = HISTORY_RUNS;
+    }
+    for(i = 0; i < nb; i++) {
+        sum += durations[i];
+        if(peaks[i] > *maxrss) {
+            *maxrss = peaks[i];
+        }
+    }
+    if(nb > 0) {
+        *duration = sum / nb;
+    }
+}
+
+
+/**
+ * Get the revision of a working copy.
+ *
+ * \param vcs the versioning system
+ * \param workdir the working copy, NULL for the current directory
+ * \param revision where to write the revision, REVISION_SIZE characters.
+ *        It will be an empty string if the revision can't be found.
+ */
+static void get_revision(repository_t vcs, const char *workdir, char *revision) {
+
+    int fds[2];
+    pid_t pid;
+    int status;
+    ssize_t length = 0;
+    ssize_t n;
+
+    revision[0] = '\0';
+
+    if(vcs == NONE || pipe(fds)) {
+        return;
+    }
+
+    fflush(NULL);
+    pid = fork();
+    if(pid == -1) {
+        close(fds[0]);
+        close(fds[1]);
+        return;
+    }
+
+    if(pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(fds[1], 1);
+        if(devnull != -1) {
+            dup2(devnull, 2);
+        }
+        close(fds[0]);
+        close(fds[1]);
+        if(workdir != NULL && chdir(workdir)) {
+            _exit(1);
+        }
+        if(vcs == GIT) {
+            execlp("git", "git", "rev-parse", "HEAD", (char *) NULL);
+        } else {
+            execlp("svn", "svn", "info", "--show-item", "revision", (char *) NULL);
+        }
+        _exit(127);
+    }
+
+    close(fds[1]);
+    while(length < REVISION_SIZE - 1 && (n = read(fds[0], revision + length, REVISION_SIZE - 1 - length)) > 0) {
+        length += n;
+    }
+    close(fds[0]);
+    while(waitpid(pid, &status, 0) == -1 && errno == EINTR);
+
+    revision[length] = '\0';
+    revision[strcspn(revision, " \r\n;")] = '\0';
+    if(!WIFEXITED(status) || WEXITSTATUS(status)) {
+        revision[0] = '\0';
+    }
+}
+
+
+/**
+ * Is a task up to date? This is the case if the revision of its working
+ * directory and its command are the same as for the last execution.
+ *
+ * \param job the task, its revision will be set, and its success if it
+ *        is up to date
+ * \param logdir directory where the logs are saved
+ * \return 1 if the task doesn't need to be executed
+ */
+static int is_up_to_date(yk_job *job, char *logdir) {
+
+    char revision[REVISION_SIZE];
+    char hash[17];
+    char lastHash[17];
+
+    if(job->upToDate) {
+        // already checked, only the last result is needed
+        job->success = 1;
+        read_last_execution(logdir, job->task, revision, lastHash, &job->success);
+        return 1;
+    }
+
+    get_revision(job->vcs, job->workdir, job->revision);
+
+    if(job->revision[0] == '\0' || read_last_execution(logdir, job->task, revision, lastHash, &job->success)) {
+        return 0;
+    }
+
+    hash_command(job->command, hash);
+    return !strcmp(revision, job->revision) && !strcmp(hash, lastHash);
+}
+
+
+/**
+ * Fill the usage of a terminated task.
+ *
+ * \param usage the struct to fill
+ * \param start the time when the task was started (CLOCK_MONOTONIC)
+ * \param rusage the resources used by the child, as returned by wait4()
+ */
+static void get_usage(yk_usage *usage, const struct timespec *start, const struct rusage *rusage) {
+
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    usage->duration = (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+    usage->user = rusage->ru_utime.tv_sec + rusage->ru_utime.tv_usec / 1e6;
+    usage->system = rusage->ru_stime.tv_sec + rusage->ru_stime.tv_usec / 1e6;
+    usage->maxrss = rusage->ru_maxrss;
+    usage->inblock = rusage->ru_inblock;
+    usage->oublock = rusage->ru_oublock;
+}
+
+
+/** \brief set when the task is asked to stop */
+static volatile sig_atomic_t stopped = 0;
+
+/**
+ * Handler of SIGTERM, or of SIGHUP for a cancelled task, in the process
+ * running a task.
+ */
+static void on_sigterm(int signum) {
+    stopped = signum;
+}
+
+
+/**
+ * Is the output of a job captured through a pipe?
+ */
+static int is_captured(const yk_capture *capture) {
+    return capture->head >= 0 || capture->compress;
+}
+
+
+/**
+ * Run the "system" function to execute a command redirecting output in
+ * a file. In capture mode, the output is read through a pipe and only
+ * its beginning and end are kept.
+ *
+ * \param logfile the file to use for the command's output
+ * \param workdir directory where to run the command, or NULL to stay in
+ *        the current directory
+ * \param command the command to execute in a shell
+ * \param capture how to capture the output
+ * \return the exit status of the command
+ */
+static int exec_command(char *logfile, const char *workdir, const char *command, const yk_capture *capture) {
+
+    struct sigaction action;
+    yk_console *console;
+    int fds[2];
+    int status;
+    pid_t pid;
+
+    // when killed, let the command end and write why
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_sigterm;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGHUP, &action, NULL);
+
+    remove(logfile);
+
+    if(!is_captured(capture)) {
+
+        close(1);
+        if(open(logfile, O_WRONLY|O_CREAT|O_APPEND, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH) == -1) {
+            log_error("fail to write output on %s", logfile);
+        } else {
+            close(2);
+            dup2(1, 2);
+        }
+
+        if(workdir != NULL && chdir(workdir)) {
+            // this message goes in the console output
+            fprintf(stderr, "Can't change directory to %s : %s\n", workdir, strerror(errno));
+            return 1;
+        }
+
+        status = system(command)/256;
+        if(stopped) {
+            printf("\n%s\n", stopped == SIGHUP ? CANCEL_NOTICE : KILL_NOTICE);
+        }
+        return status;
+    }
+
+    console = capture_open(logfile, capture);
+    if(console == NULL) {
+        return 1;
+    }
+
+    if(pipe(fds)) {
+        log_error("Can't create a pipe : %s", strerror(errno));
+        capture_close(console, NULL);
+        return 1;
+    }
+
+    pid = fork();
+    if(pid == -1) {
+        log_error("Fork failure : command \"%s\" not runned", command);
+        capture_close(console, NULL);
+        return 1;
+    }
+
+    if(pid == 0) {
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGHUP, SIG_DFL);
+        dup2(fds[1], 1);
+        dup2(fds[1], 2);
+        close(fds[0]);
+        close(fds[1]);
+        if(workdir != NULL && chdir(workdir)) {
+            fprintf(stderr, "Can't change directory to %s : %s\n", workdir, strerror(errno));
+            _exit(1);
+        }
+        execl("/bin/sh", "sh", "-c", command, (char *) NULL);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    if(capture_fd(console, fds[0])) {
+        log_error("Error while capturing the output in %s", logfile);
+    }
+    close(fds[0]);
+
+    while(waitpid(pid, &status, 0) == -1 && errno == EINTR);
+
+    capture_close(console, stopped ? (stopped == SIGHUP ? CANCEL_NOTICE : KILL_NOTICE) : NULL);
+
+    if(!WIFEXITED(status)) {
+        return 1;
+    }
+    return WEXITSTATUS(status);
+}
+
+
+/**
+ * Start a task in a forked process. The "system" function will execute
+ * the command redirecting output in a file. The run is done in a forked
+ * process to not lose the standard outputs.
+ *
+ * \param tache task's name
+ * \param commande the command to execute in a shell
+ * \param workdir directory where to run the command, or NULL
+ * \param capture how to capture the console output
+ * \param logdir directory of the ouptut files
+ * \return the pid of the child process, or -1 if the task was not started
+ */
+static pid_t start_task(const char *tache, const char *commande, const char *workdir, const yk_capture *capture, char *logdir) {
+
+    char *ficconsole;
+    FILE *fconsole = NULL;
+    pid_t pid;
+
+    ficconsole = malloc(sizeof(char) * (strlen(logdir) + strlen(tache) + 13));
+    if(ficconsole == NULL) {
+        log_error("Task %s could not allocate memory. Task aborted.", tache);
+        return -1;
+    }
+
+    // remove the output of a previous run in the other format
+    sprintf(ficconsole, "%s/%s_console%s", logdir, tache, capture->compress ? "" : ".gz");
+    remove(ficconsole);
+
+    sprintf(ficconsole, "%s/%s_console%s", logdir, tache, capture->compress ? ".gz" : "");
+    fconsole = fopen(ficconsole, "w");
+    if(fconsole == NULL) {
+        log_error("Task %s could not create or modify the file %s. Task aborted", tache, ficconsole);
+        free(ficconsole);
+        return -1;
+    }
+    fclose(fconsole);
+
+    // don't let the child flush our buffers a second time
+    fflush(NULL);
+
+    pid = fork();
+    if(pid == -1) {
+        log_error("Fork failure : command \"%s\" not runned", commande);
+    }
+
+    if(pid == 0) {
+        int err;
+        sigset_t sigchld;
+
+        // the task has its own process group to be killed as a whole
+        setpgid(0, 0);
+        sigemptyset(&sigchld);
+        sigaddset(&sigchld, SIGCHLD);
+        sigprocmask(SIG_UNBLOCK, &sigchld, NULL);
+
+        err = exec_command(ficconsole, workdir, commande, capture);
+        free(ficconsole);
+        log_debug("forked process exits with status %d", err);
+        exit(err);
+    }
+
+    if(pid != -1) {
+        // also done here to avoid a race with a kill of the group
+        setpgid(pid, pid);
+    }
+
+    free(ficconsole);
+    return pid;
+}
+
+
+/**
+ * Get the result of a task from the status returned by waitpid().
+ *
+ * \param wstatus the status of the terminated child
+ * \return the exit status of the command, or 1 if it did not exit normally
+ */
+static int task_result(int wstatus) {
+
+    if (!WIFEXITED(wstatus)) {
+        return 1;
+    }
+
+    log_debug("parent process get status %d", WEXITSTATUS(wstatus));
+    return WEXITSTATUS(wstatus);
+}
+
+
+/**
+ * Free the memory used by a job.
+ */
+static void destroy_job(yk_job *job) {
+    free(job->task);
+    free(job->workdir);
+    free(job->command);
+    free(job->after);
+    free(job->depends);
+    free(job->logdir);
+    free(job);
+}
+
+
+void jobs_destroy(yk_chain *chains) {
+
+    while(chains != NULL) {
+        yk_chain *next = chains->next;
+        while(chains->jobs != NULL) {
+            yk_job *job = chains->jobs->next;
+            destroy_job(chains->jobs);
+            chains->jobs = job;
+        }
+        free(chains->name);
+        free(chains);
+        chains = next;
+    }
+}
+
+
+yk_chain *jobs_add(yk_chain **chains, const char *name, yk_job *job) {
+
+    yk_chain *chain = *chains;
+    yk_chain *last = NULL;
+
+    while(chain != NULL && strcmp(chain->name, name)) {
+        last = chain;
+        chain = chain->next;
+    }
+
+    if(chain == NULL) {
+        chain = malloc(sizeof(yk_chain));
+        chain->name = strdup(name);
+        chain->jobs = NULL;
+        chain->last = NULL;
+        chain->next = NULL;
+        if(last == NULL) {
+            *chains = chain;
+        } else {
+            last->next = chain;
+        }
+    }
+
+    // without declared dependencies, follow the order of the file
+    if(job->after == NULL && job->depends == NULL && chain->last != NULL) {
+        job->after = strdup(chain->last->task);
+    }
+
+    if(chain->last == NULL) {
+        chain->jobs = job;
+    } else {
+        chain->last->next = job;
+    }
+    chain->last = job;
+
+    return chain;
+}
+
+
+yk_job *jobs_create(const char *task, const char *workdir, const char *command, const yk_job *defaults) {
+
+    yk_job *job = malloc(sizeof(yk_job));
+
+    job->task = strdup(task);
+    job->workdir = (workdir != NULL && workdir[0] != '\0') ? strdup(workdir) : NULL;
+    job->command = strdup(command);
+    job->timeout = defaults->timeout;
+    job->cpuLimit = defaults->cpuLimit;
+    job->capture = defaults->capture;
+    job->vcs = defaults->vcs;
+    job->pool = defaults->pool;
+    job->revision[0] = '\0';
+    job->after = NULL;
+    job->depends = NULL;
+    job->state = JOB_PENDING;
+    job->success = 0;
+    job->pid = -1;
+    job->remote = 0;
+    job->killDate = 0;
+    job->token = 0;
+    job->upToDate = 0;
+    job->cancelled = 0;
+    job->lost = 0;
+    job->expected = -1;
+    job->rank = 0;
+    job->expectedRss = 0;
+    job->readyDate = 0;
+    job->logdir = NULL;
+    job->next = NULL;
+
+    return job;
+}
+
+
+/**
+ * Look if the jobs a job waits for are done.
+ *
+ * \param chain the chain of the job
+ * \param names space separated list of tasks' names
+ * \param failed set to 1 if one of these jobs did not succeed
+ * \return 1 if all these jobs are done
+ */
+static int are_done(yk_chain *chain, const char *names, int *failed) {
+
+    const char *name = names;
+
+    while(name != NULL && *name != '\0') {
+
+        size_t length;
+        yk_job *job;
+
+        name += strspn(name, " ");
+        length = strcspn(name, " ");
+        if(length == 0) {
+            break;
+        }
+
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            if(strlen(job->task) == length && !strncmp(job->task, name, length)) {
+                break;
+            }
+        }
+
+        if(job == NULL) {
+            log_warning("Unknown dependency %.*s in chain %s", (int) length, name, chain->name);
+        } else if(job->state != JOB_DONE) {
+            return 0;
+        } else if(!job->success) {
+            *failed = 1;
+        }
+
+        name += length;
+    }
+
+    return 1;
+}
+
+
+/**
+ * Look if a task is in a list of tasks' names.
+ *
+ * \param names space separated list of tasks' names, may be NULL
+ * \param task the task's name
+ * \return 1 if the task is in the list
+ */
+static int is_listed(const char *names, const char *task) {
+
+    size_t taskLength = strlen(task);
+    const char *name = names;
+
+    while(name != NULL && *name != '\0') {
+
+        size_t length;
+
+        name += strspn(name, " ");
+        length = strcspn(name, " ");
+        if(length == 0) {
+            break;
+        }
+        if(length == taskLength && !strncmp(name, task, length)) {
+            return 1;
+        }
+        name += length;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Compute the expected durations, peaks of memory and ranks of the jobs.
+ * A task never executed is expected to last as long as the mean of the
+ * known ones.
+ *
+ * \param chains the jobs to run
+ * \param logdir directory of the result files
+ * \return the number of tasks with a known duration
+ */
+static int rank_jobs(yk_chain *chains, char *logdir) {
+
+    yk_chain *chain;
+    yk_job *job;
+    double sum = 0;
+    int known = 0;
+
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            // a running job keeps the memory it reserved
+            if(job->state == JOB_PENDING) {
+                read_history(job->logdir != NULL ? job->logdir : logdir, job->task, &job->expected, &job->expectedRss);
+            }
+            if(job->expected >= 0) {
+                sum += job->expected;
+                known++;
+            }
+        }
+    }
+
+    for(chain = chains; chain != NULL; chain = chain->next) {
+
+        int nbJobs = 0;
+        int i;
+
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            if(job->expected < 0) {
+                job->expected = known > 0 ? sum / known : 0;
+            }
+            job->rank = job->expected;
+            nbJobs++;
+        }
+
+        // a path has at most nbJobs jobs, even with circular dependencies
+        for(i = 1; i < nbJobs; i++) {
+            for(job = chain->jobs; job != NULL; job = job->next) {
+
+                yk_job *waiting;
+
+                for(waiting = chain->jobs; waiting != NULL; waiting = waiting->next) {
+                    if((is_listed(waiting->after, job->task) || is_listed(waiting->depends, job->task))
+                            && job->expected + waiting->rank > job->rank) {
+                        job->rank = job->expected + waiting->rank;
+                    }
+                }
+            }
+        }
+    }
+
+    return known;
+}
+
+
+/** \brief date used to age the jobs while they are sorted */
+static time_t agingDate;
+
+
+/**
+ * Priority of a ready job : its rank, increased while it waits, so that
+ * the short jobs are not always overtaken.
+ */
+static double priority(const yk_job *job) {
+    return job->rank + AGING_RATE * (double) (agingDate - job->readyDate);
+}
+
+
+/**
+ * Compare the jobs to start the one with the highest priority first.
+ */
+static int compare_priorities(const void *a, const void *b) {
+
+    double pa = priority(*(yk_job * const *) a);
+    double pb = priority(*(yk_job * const *) b);
+
+    return (pa < pb) - (pa > pb);
+}
+
+
+/**
+ * Look if a job of a pool may start : its pool has a free worker, and
+ * for the pools using the processors, the schedule has one too.
+ *
+ * \param schedule how to run the jobs
+ * \param nbWorkers the workers of the build and test pools together
+ * \param running the number of running jobs of each pool
+ * \param pool the pool of the job
+ * \return 1 if the job may start
+ */
+static int has_free_worker(const yk_schedule *schedule, int nbWorkers, const int running[NB_POOLS], job_pool_t pool) {
+
+    int limit = schedule->pools[pool] > 0 ? schedule->pools[pool] : nbWorkers;
+
+    if(running[pool] >= limit) {
+        return 0;
+    }
+
+    // the fetch jobs don't use the processors
+    return pool == POOL_FETCH || running[POOL_BUILD] + running[POOL_TEST] < nbWorkers;
+}
+
+
+/**
+ * Predict the makespan of the jobs : simulate their execution by the
+ * workers of their pools, ordered by rank, each one lasting its expected
+ * duration and using its expected peak of memory. The failures, the
+ * skipped tasks and the memory used outside of the tasks are not
+ * foreseen.
+ *
+ * \param chains the jobs to run, ranked
+ * \param schedule how to run the jobs
+ * \param nbWorkers the workers of the build and test pools together
+ * \return the predicted makespan in seconds
+ */
+static double predict_makespan(yk_chain *chains, const yk_schedule *schedule, int nbWorkers) {
+
+    yk_chain *chain;
+    yk_job *job;
+    yk_job **jobs;
+    yk_chain **chainOf;
+    job_state_t *state;
+    double *end;
+    yk_job **ready;
+    double now = 0;
+    long reserved = 0;
+    int nbJobs = 0;
+    int running = 0;
+    int byPool[NB_POOLS] = { 0 };
+    int i, j;
+
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            nbJobs++;
+        }
+    }
+
+    jobs = malloc(nbJobs * sizeof(yk_job *));
+    chainOf = malloc(nbJobs * sizeof(yk_chain *));
+    state = malloc(nbJobs * sizeof(job_state_t));
+    end = malloc(nbJobs * sizeof(double));
+    ready = malloc(nbJobs * sizeof(yk_job *));
+
+    i = 0;
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            jobs[i] = job;
+            chainOf[i] = chain;
+            state[i] = JOB_PENDING;
+            job->readyDate = 0;
+            i++;
+        }
+    }
+
+    // no aging in the simulation
+    agingDate = 0;
+
+    do {
+        int nbReady = 0;
+
+        for(i = 0; i < nbJobs; i++) {
+
+            int isReady = (state[i] == JOB_PENDING);
+
+            for(j = 0; j < nbJobs && isReady; j++) {
+                if(chainOf[j] == chainOf[i] && state[j] != JOB_DONE
+                        && (is_listed(jobs[i]->after, jobs[j]->task) || is_listed(jobs[i]->depends, jobs[j]->task))) {
+                    isReady = 0;
+                }
+            }
+
+            if(isReady) {
+                ready[nbReady++] = jobs[i];
+            }
+        }
+
+        qsort(ready, nbReady, sizeof(yk_job *), compare_priorities);
+
+        for(i = 0; i < nbReady; i++) {
+            if(!has_free_worker(schedule, nbWorkers, byPool, ready[i]->pool)
+                    || (running > 0 && schedule->memory > 0 && reserved + ready[i]->expectedRss > schedule->memory)) {
+                continue;
+            }
+            for(j = 0; jobs[j] != ready[i]; j++);
+            state[j] = JOB_RUNNING;
+            end[j] = now + ready[i]->expected;
+            reserved += ready[i]->expectedRss;
+            byPool[ready[i]->pool]++;
+            running++;
+        }
+
+        if(running == 0) {
+            break;
+        }
+
+        // go to the next end of a job
+        now = -1;
+        for(i = 0; i < nbJobs; i++) {
+            if(state[i] == JOB_RUNNING && (now < 0 || end[i] < now)) {
+                now = end[i];
+            }
+        }
+        for(i = 0; i < nbJobs; i++) {
+            if(state[i] == JOB_RUNNING && end[i] <= now) {
+                state[i] = JOB_DONE;
+                reserved -= jobs[i]->expectedRss;
+                byPool[jobs[i]->pool]--;
+                running--;
+            }
+        }
+
+    } while(1);
+
+    free(jobs);
+    free(chainOf);
+    free(state);
+    free(end);
+    free(ready);
+
+    return now;
+}
+
+
+/**
+ * Start a job, or don't run it if it is up to date.
+ *
+ * \param run the state of the execution
+ * \param job the job to start
+ * \param remote 1 to send the job to an agent
+ * \return 0 if the job is running
+ */
+static int start_job(yk_run *run, yk_job *job, int remote) {
+
+    job->state = JOB_DONE;
+
+    if((job->vcs != NONE || job->upToDate) && is_up_to_date(job, job_logdir(run, job)) && !run->schedule->force) {
+        log_info("Task %s is up to date (revision %s)", job->task, job->revision);
+        if(save_result(time(NULL), SKIPPED_RESULT, NULL, job, job_logdir(run, job))) {
+            run->err = 1;
+        }
+        return 1;
+    }
+
+    job->success = 0;
+    job->date = time(NULL);
+    clock_gettime(CLOCK_MONOTONIC, &job->start);
+    job->cpuTime = 0;
+    job->killDate = 0;
+
+    if(remote) {
+        if(agents_start(run->schedule->agents, job, job_logdir(run, job))) {
+            log_error("task %s was not executed", job->task);
+            run->err = 1;
+            return 1;
+        }
+        job->remote = 1;
+        job->state = JOB_RUNNING;
+        return 0;
+    }
+
+    job->pid = start_task(job->task, job->command, job->workdir, &job->capture, job_logdir(run, job));
+
+    if(job->pid == -1) {
+        log_error("task %s was not executed", job->task);
+        run->err = 1;
+        return 1;
+    }
+
+    log_info("Task %s started (pid %d)", job->task, job->pid);
+    job->state = JOB_RUNNING;
+    return 0;
+}
+
+
+/**
+ * Update the CPU time used by the process groups of the running jobs.
+ */
+static void update_cpu_times(yk_chain *chains) {
+
+    yk_chain *chain;
+    yk_job *job;
+    pid_t *groups;
+    double *times;
+    int nb = 0;
+
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            job->cpuTime = 0;
+            nb += (job->state == JOB_RUNNING && !job->remote);
+        }
+    }
+
+    groups = malloc(nb * sizeof(pid_t));
+    times = malloc(nb * sizeof(double));
+    nb = 0;
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            if(job->state == JOB_RUNNING && !job->remote) {
+                groups[nb++] = job->pid;
+            }
+        }
+    }
+
+    proc_cpu_times(groups, times, nb);
+
+    nb = 0;
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            if(job->state == JOB_RUNNING && !job->remote) {
+                job->cpuTime = times[nb++];
+            }
+        }
+    }
+
+    free(groups);
+    free(times);
+}
+
+
+/**
+ * Ask the process group of a running job to stop. The process running
+ * the command will write a notice at the end of the console output.
+ *
+ * \param job the job
+ * \param reason why the job is stopped
+ * \param limit the exceeded limit in seconds
+ */
+static void stop_job(yk_job *job, const char *reason, int limit) {
+
+    struct timespec now;
+
+    log_warning("Task %s exceeded its %s limit (%d s) : killing it", job->task, reason, limit);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    job->killDate = now.tv_sec;
+    kill(-job->pid, SIGTERM);
+}
+
+
+/**
+ * Kill the running jobs which exceeded their limits.
+ *
+ * \param chains the chains of jobs
+ */
+static void check_limits(yk_chain *chains) {
+
+    yk_chain *chain;
+    yk_job *job;
+    struct timespec now;
+    int cpuLimits = 0;
+
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            if(job->state == JOB_RUNNING && !job->remote && job->cpuLimit > 0 && !job->killDate) {
+                cpuLimits = 1;
+            }
+        }
+    }
+
+    if(cpuLimits) {
+        update_cpu_times(chains);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+
+            // the agents check the limits of their jobs
+            if(job->state != JOB_RUNNING || job->remote) {
+                continue;
+            }
+
+            if(job->killDate) {
+                if(now.tv_sec - job->killDate >= KILL_DELAY) {
+                    kill(-job->pid, SIGKILL);
+                }
+            } else if(job->timeout > 0 && now.tv_sec - job->start.tv_sec >= job->timeout) {
+                stop_job(job, "wall clock", job->timeout);
+            } else if(job->cpuLimit > 0 && job->cpuTime >= job->cpuLimit) {
+                stop_job(job, "CPU time", job->cpuLimit);
+            }
+        }
+    }
+}
+
+
+/** \brief names of the pools, in the order of job_pool_t */
+static const char *poolNames[NB_POOLS] = { "fetch", "build", "test" };
+
+
+int jobs_pool(const char *name) {
+
+    int pool;
+
+    for(pool = 0; pool < NB_POOLS; pool++) {
+        if(!strcmp(poolNames[pool], name)) {
+            return pool;
+        }
+    }
+
+    return -1;
+}
+
+
+int jobs_parse_pools(int pools[NB_POOLS], const char *value) {
+
+    char *copy = strdup(value);
+    char *item;
+    char *saveptr;
+    int err = 0;
+
+    for(item = strtok_r(copy, ",", &saveptr); item != NULL; item = strtok_r(NULL, ",", &saveptr)) {
+
+        char *number = strchr(item, '=');
+        int pool;
+
+        if(number == NULL) {
+            err = 1;
+            continue;
+        }
+        *number = '\0';
+        number++;
+
+        pool = jobs_pool(item);
+        if(pool == -1 || atoi(number) < 0) {
+            err = 1;
+            continue;
+        }
+        pools[pool] = atoi(number);
+    }
+
+    free(copy);
+    return err;
+}
+
+
+void jobs_cancel(yk_chain *chain) {
+
+    yk_job *job;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    for(job = chain->jobs; job != NULL; job = job->next) {
+
+        if(job->state == JOB_DONE || job->cancelled) {
+            continue;
+        }
+
+        job->cancelled = 1;
+
+        // SIGHUP tells the task why it is killed, SIGKILL follows as for a timeout
+        if(job->state == JOB_RUNNING) {
+            log_info("Task %s superseded : cancelling it", job->task);
+            // the scheduler tells the agent
+            if(!job->killDate && !job->remote) {
+                job->killDate = now.tv_sec;
+                kill(-job->pid, SIGHUP);
+            }
+        }
+    }
+}
+
+
+/**
+ * Empty the make jobserver and fill it again with all its tokens. This
+ * is only done when no job holds a token : the tokens taken by a killed
+ * make are never given back.
+ *
+ * \param run the state of the execution
+ * \return 0 in case of success
+ */
+static int refill_tokens(yk_run *run) {
+
+    char buffer[256];
+    char token = TOKEN;
+    int i;
+
+    while(read(run->tokenReader, buffer, sizeof(buffer)) > 0);
+
+    for(i = 0; i < run->schedule->makeJobs; i++) {
+        if(write(run->tokens[1], &token, 1) != 1) {
+            log_error("Can't fill the jobserver : %s", strerror(errno));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * Take a token of the make jobserver, if the job uses the processors.
+ *
+ * \param run the state of the execution
+ * \param job the job which will hold the token
+ * \return 0 if the job may start
+ */
+static int take_token(yk_run *run, yk_job *job) {
+
+    char token;
+
+    if(run->tokenReader == -1 || job->pool == POOL_FETCH) {
+        return 0;
+    }
+
+    if(read(run->tokenReader, &token, 1) == 1) {
+        job->token = 1;
+        run->held++;
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/**
+ * Give back the token of the make jobserver held by a job.
+ */
+static void release_token(yk_run *run, yk_job *job) {
+
+    char token = TOKEN;
+
+    if(!job->token) {
+        return;
+    }
+    job->token = 0;
+    run->held--;
+
+    if(run->held == 0) {
+        refill_tokens(run);
+    } else if(write(run->tokens[1], &token, 1) != 1) {
+        log_warning("Can't give back a token of the jobserver");
+    }
+}
+
+
+/**
+ * Save the result of a terminated job.
+ *
+ * \param run the state of the execution
+ * \param job the job
+ * \param wstatus the status of the terminated child
+ * \param rusage the resources used by the child
+ * \return 0 if the result was saved
+ */
+static int end_job(yk_run *run, yk_job *job, int wstatus, struct rusage *rusage) {
+
+    yk_usage usage;
+    int resultat = task_result(wstatus);
+    int err;
+
+    if(job->killDate) {
+        // don't let any process of the group survive
+        kill(-job->pid, SIGKILL);
+        resultat = job->cancelled ? CANCELLED_RESULT : TIMEOUT_RESULT;
+    }
+
+    get_usage(&usage, &job->start, rusage);
+    err = save_result(job->date, resultat, &usage, job, job_logdir(run, job));
+    release_token(run, job);
+    run->reserved -= job->expectedRss;
+    run->byPool[job->pool]--;
+    log_info("Task %s finished", job->task);
+    job->state = JOB_DONE;
+    job->success = (resultat == 0);
+    job->pid = -1;
+
+    return err;
+}
+
+
+/**
+ * Save the result of a job ended on an agent. If its agent was lost, the
+ * job is put back in the queue, LOST_RETRIES times at most : then it
+ * fails, unless it was cancelled.
+ *
+ * \param job the job
+ * \param resultat the exit status of the command, TIMEOUT_RESULT or CANCELLED_RESULT
+ * \param usage the resources used by the job, NULL if its agent was lost
+ * \param data the state of the execution
+ */
+static void end_remote_job(yk_job *job, int resultat, const yk_usage *usage, void *data) {
+
+    yk_run *run = data;
+
+    run->remote--;
+    job->remote = 0;
+
+    if(usage == NULL) {
+        job->lost++;
+        if(job->cancelled) {
+            resultat = CANCELLED_RESULT;
+        } else if(job->lost <= LOST_RETRIES) {
+            log_warning("Task %s will be started again : its agent was lost", job->task);
+            job->state = JOB_PENDING;
+            return;
+        } else {
+            log_warning("Task %s failed : its agent was lost %d times", job->task, job->lost);
+            resultat = 1;
+        }
+    }
+
+    if(save_result(job->date, resultat, usage, job, job_logdir(run, job))) {
+        run->err = 1;
+    }
+    log_info("Task %s finished", job->task);
+    job->state = JOB_DONE;
+    job->success = (resultat == 0);
+}
+
+
+/**
+ * Look if there is enough memory to start a job.
+ *
+ * \param run the state of the execution
+ * \param job the job to start
+ * \param total total memory of the system in kB, or -1 if unknown
+ * \param available memory available for the job in kB, or -1 if unknown
+ * \return 1 if the job may start
+ */
+static int fits_memory(const yk_run *run, const yk_job *job, long total, long available) {
+
+    // a job alone must run, whatever its needs
+    if(run->running == 0) {
+        return 1;
+    }
+
+    if(run->schedule->memory > 0 && run->reserved + job->expectedRss > run->schedule->memory) {
+        log_debug("Task %s waits : %ld kB expected, %ld kB of the budget used", job->task, job->expectedRss, run->reserved);
+        return 0;
+    }
+
+    if(available >= 0 && available - job->expectedRss < total / 100 * MEMORY_RESERVE) {
+        log_debug("Task %s waits : %ld kB expected, %ld kB available", job->task, job->expectedRss, available);
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/**
+ * Start the jobs whose dependencies are done, while there are free
+ * workers, the highest priorities first.
+ *
+ * \param run the state of the execution
+ * \param chains the jobs to run
+ * \return the number of jobs still pending
+ */
+static int start_ready_jobs(yk_run *run, yk_chain *chains) {
+
+    yk_chain *chain;
+    yk_job *job;
+    yk_job **ready = NULL;
+    long total;
+    long available;
+    int size = 0;
+    int pending;
+    int progress;
+
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            size++;
+        }
+    }
+    ready = malloc(size * sizeof(yk_job *));
+
+    // the jobs started now don't use their memory yet
+    if(proc_meminfo(&total, &available)) {
+        total = -1;
+        available = -1;
+    }
+
+    do {
+        int nbReady = 0;
+        int i;
+
+        progress = 0;
+        pending = 0;
+
+        for(chain = chains; chain != NULL; chain = chain->next) {
+            for(job = chain->jobs; job != NULL; job = job->next) {
+
+                int failed = 0;
+
+                if(job->state != JOB_PENDING) {
+                    continue;
+                }
+
+                if(job->cancelled) {
+                    log_info("Task %s cancelled", job->task);
+                    job->state = JOB_DONE;
+                    job->success = 0;
+                    if(save_result(time(NULL), CANCELLED_RESULT, NULL, job, job_logdir(run, job))) {
+                        run->err = 1;
+                    }
+                    progress = 1;
+                    continue;
+                }
+
+                if(!are_done(chain, job->after, &failed) || !are_done(chain, job->depends, &failed)) {
+                    pending++;
+                    continue;
+                }
+
+                // only the "depends" jobs must succeed
+                failed = 0;
+                are_done(chain, job->depends, &failed);
+
+                if(failed) {
+                    log_info("Task %s not executed : a dependency failed", job->task);
+                    job->state = JOB_DONE;
+                    job->success = 0;
+                    if(save_result(time(NULL), DEPENDENCY_RESULT, NULL, job, job_logdir(run, job))) {
+                        run->err = 1;
+                    }
+                    progress = 1;
+                } else {
+                    if(job->readyDate == 0) {
+                        job->readyDate = time(NULL);
+                    }
+                    ready[nbReady++] = job;
+                }
+            }
+        }
+
+        agingDate = time(NULL);
+        qsort(ready, nbReady, sizeof(yk_job *), compare_priorities);
+
+        for(i = 0; i < nbReady; i++) {
+            job = ready[i];
+            if(has_free_worker(run->schedule, run->schedule->nbWorkers, run->byPool, job->pool)
+                    && fits_memory(run, job, total, available) && !take_token(run, job)) {
+                if(!start_job(run, job, 0)) {
+                    run->running++;
+                    run->byPool[job->pool]++;
+                    run->reserved += job->expectedRss;
+                    if(available >= 0) {
+                        available -= job->expectedRss;
+                    }
+                } else {
+                    release_token(run, job);
+                    progress = 1;
+                }
+            } else if(job->pool != POOL_FETCH && agents_idle(run->schedule->agents, job) > 0) {
+                if(!start_job(run, job, 1)) {
+                    run->remote++;
+                } else {
+                    progress = 1;
+                }
+            } else {
+                pending++;
+            }
+        }
+    // a job done without being run may unlock others
+    } while(progress);
+
+    free(ready);
+    return pending;
+}
+
+
+/**
+ * \return the last chain of a list, or NULL if the list is empty
+ */
+static yk_chain *last_chain(yk_chain *chains) {
+
+    while(chains != NULL && chains->next != NULL) {
+        chains = chains->next;
+    }
+    return chains;
+}
+
+
+/**
+ * Don't run the jobs still pending when no job runs : they wait for each
+ * other.
+ *
+ * \param run the state of the execution
+ * \param chains the jobs to run
+ * \param pending the number of pending jobs
+ */
+static void drop_pending(yk_run *run, yk_chain *chains, int pending) {
+
+    yk_chain *chain;
+    yk_job *job;
+
+    log_error("%d task(s) not executed : circular dependencies", pending);
+    run->err = 1;
+
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            if(job->state == JOB_PENDING) {
+                job->state = JOB_DONE;
+                job->success = 0;
+            }
+        }
+    }
+}
+
+
+/**
+ * Give the chains whose jobs are all done to the ended function of the
+ * schedule.
+ *
+ * \param run the state of the execution
+ * \param chains the list of the chains, the done ones are taken out
+ * \return 1 if the ended function added chains
+ */
+static int end_chains(yk_run *run, yk_chain **chains) {
+
+    yk_chain **current = chains;
+    int added = 0;
+
+    while(*current != NULL) {
+
+        yk_chain *chain = *current;
+        yk_chain *last;
+        yk_job *job;
+
+        for(job = chain->jobs; job != NULL && job->state == JOB_DONE; job = job->next);
+        if(job != NULL) {
+            current = &(chain->next);
+            continue;
+        }
+
+        *current = chain->next;
+        chain->next = NULL;
+        last = last_chain(*chains);
+        run->schedule->ended(chains, chain, run->schedule->watchData);
+        if(last_chain(*chains) != last) {
+            added = 1;
+        }
+    }
+
+    return added;
+}
+
+
+/**
+ * Create the make jobserver : a pipe filled with tokens, given to the
+ * children through MAKEFLAGS.
+ *
+ * \param run the state of the execution
+ * \return 0 in case of success
+ */
+static int open_jobserver(yk_run *run) {
+
+    char path[64];
+    char *previous = getenv("MAKEFLAGS");
+    char *makeflags;
+
+    run->tokens[0] = -1;
+    run->tokens[1] = -1;
+    run->tokenReader = -1;
+    run->held = 0;
+    run->makeflags = NULL;
+
+    if(run->schedule->makeJobs <= 0) {
+        return 0;
+    }
+
+    // the descriptors are inherited by the tasks
+    if(pipe(run->tokens)) {
+        log_error("Can't create the jobserver : %s", strerror(errno));
+        return 1;
+    }
+
+    // a new open file description, the tasks keep a blocking one
+    sprintf(path, "/proc/self/fd/%d", run->tokens[0]);
+    run->tokenReader = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if(run->tokenReader == -1) {
+        log_error("Can't open %s : %s", path, strerror(errno));
+        return 1;
+    }
+
+    if(refill_tokens(run)) {
+        return 1;
+    }
+
+    // the flags given by the user are kept, the last jobserver wins
+    if(previous != NULL) {
+        run->makeflags = strdup(previous);
+    } else {
+        previous = "";
+    }
+    makeflags = malloc(strlen(previous) + 64);
+    sprintf(makeflags, "%s%s-j --jobserver-auth=%d,%d", previous, *previous ? " " : "", run->tokens[0], run->tokens[1]);
+    setenv("MAKEFLAGS", makeflags, 1);
+    log_debug("Jobserver of %d tokens : MAKEFLAGS=%s", run->schedule->makeJobs, makeflags);
+    free(makeflags);
+
+    return 0;
+}
+
+
+/**
+ * Remove the make jobserver.
+ */
+static void close_jobserver(yk_run *run) {
+
+    if(run->tokens[0] != -1) {
+        if(run->makeflags != NULL) {
+            setenv("MAKEFLAGS", run->makeflags, 1);
+            free(run->makeflags);
+        } else {
+            unsetenv("MAKEFLAGS");
+        }
+        close(run->tokens[0]);
+        close(run->tokens[1]);
+    }
+    if(run->tokenReader != -1) {
+        close(run->tokenReader);
+    }
+}
+
+
+int jobs_run(yk_chain *chains, const yk_schedule *schedule, char *logdir) {
+
+    yk_chain *chain;
+    yk_job *job = NULL;
+    yk_run run;
+    int pending = 0;
+    sigset_t sigchld;
+    struct timespec tick = { TICK, 0 };
+    struct timespec start;
+    struct timespec stop;
+    double predicted;
+    int slots;
+    int known;
+    int alive = (schedule->watch != NULL);
+    int sigchldFd = -1;
+
+    run.schedule = schedule;
+    run.logdir = logdir;
+    run.running = 0;
+    run.remote = 0;
+    run.err = 0;
+    run.reserved = 0;
+    memset(run.byPool, 0, sizeof(run.byPool));
+
+    known = rank_jobs(chains, logdir);
+    slots = schedule->nbWorkers;
+    if(schedule->makeJobs > 0 && schedule->makeJobs < slots) {
+        slots = schedule->makeJobs;
+    }
+    predicted = predict_makespan(chains, schedule, slots);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if(open_jobserver(&run)) {
+        close_jobserver(&run);
+        return 1;
+    }
+
+    // SIGCHLD is only received with sigtimedwait()
+    sigemptyset(&sigchld);
+    sigaddset(&sigchld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &sigchld, NULL);
+
+    if(schedule->agents != NULL) {
+        // wait for the agents and for the local jobs at the same time
+        sigchldFd = signalfd(-1, &sigchld, SFD_NONBLOCK | SFD_CLOEXEC);
+        agents_wait(schedule->agents, -1, 0, end_remote_job, &run);
+    }
+
+    do {
+        pid_t pid;
+        int wstatus;
+        struct rusage rusage;
+        int reaped = 0;
+
+        pending = start_ready_jobs(&run, chains);
+
+        if(run.running == 0 && run.remote == 0 && pending > 0) {
+            drop_pending(&run, chains, pending);
+        }
+
+        // the new chains of the ended function may start at once
+        if(schedule->ended != NULL && end_chains(&run, &chains)) {
+            rank_jobs(chains, logdir);
+            continue;
+        }
+
+        if(run.running == 0 && run.remote == 0 && !alive) {
+            break;
+        }
+
+        while((pid = wait4(-1, &wstatus, WNOHANG, &rusage)) > 0) {
+
+            // the list may be empty in a long-lived scheduler
+            job = NULL;
+            for(chain = chains; chain != NULL; chain = chain->next) {
+                for(job = chain->jobs; job != NULL; job = job->next) {
+                    if(job->state == JOB_RUNNING && job->pid == pid) {
+                        break;
+                    }
+                }
+                if(job != NULL) {
+                    break;
+                }
+            }
+
+            if(job != NULL) {
+                run.running--;
+                reaped++;
+                if(end_job(&run, job, wstatus, &rusage)) {
+                    run.err = 1;
+                }
+            } else if(schedule->reaped != NULL) {
+                yk_chain *last = last_chain(chains);
+                schedule->reaped(&chains, pid, wstatus, schedule->watchData);
+                if(last_chain(chains) != last) {
+                    rank_jobs(chains, logdir);
+                    reaped++;
+                }
+            }
+        }
+
+        if(pid == -1 && errno != EINTR && run.running > 0) {
+            log_error("Unexpected error while waiting for tasks : %s", strerror(errno));
+            run.err = 1;
+            break;
+        }
+
+        if(!reaped) {
+            if(schedule->watch != NULL) {
+                yk_chain *last = last_chain(chains);
+                alive = schedule->watch(&chains, schedule->watchData);
+                if(last_chain(chains) != last) {
+                    rank_jobs(chains, logdir);
+                    continue;
+                }
+            }
+            check_limits(chains);
+            if(schedule->agents != NULL) {
+                struct signalfd_siginfo info;
+                agents_wait(schedule->agents, sigchldFd, TICK, end_remote_job, &run);
+                while(read(sigchldFd, &info, sizeof(info)) > 0);
+            } else {
+                sigtimedwait(&sigchld, NULL, &tick);
+            }
+        }
+
+    } while(1);
+
+    // a long-lived scheduler has no makespan
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    if(schedule->watch != NULL) {
+        log_debug("Scheduler stopped after %.0f s", (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9);
+    } else if(known > 0) {
+        log_info("Makespan : predicted %.0f s, actual %.0f s", predicted,
+            (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9);
+    } else {
+        log_info("Makespan : %.0f s, no history to predict it",
+            (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9);
+    }
+
+    if(sigchldFd != -1) {
+        close(sigchldFd);
+    }
+    sigprocmask(SIG_UNBLOCK, &sigchld, NULL);
+    close_jobserver(&run);
+    return run.err;
+}
+
+
+/**
+ * \return 0 in case of success
+ */
+static int create_directory(char *dirname) {
+
+    struct stat buf;
+    int err = mkdir(dirname, 0750);
+
+    if(err == -1) {
+
+        if(errno != EEXIST) {
+            log_error("Could not create the directory %s. Exiting", dirname);
+            return err;
+        }
+
+        err = stat(dirname, &buf);
+        if(err) {
+            log_error("Stat failed for file %s. Exiting", dirname);
+            return err;
+        }
+
+        if(!S_ISDIR(buf.st_mode)) {
+            log_error("File %s exist but is not a directory. Exiting", dirname);
+            err = -1;
+        }
+    }
+
+    return err;
+}
+
+
+
+char *jobs_logdir(const char *yannkinsDir) {
+
+    char *logdir = malloc((strlen(yannkinsDir) + strlen(LOG_DIR) + 2) * sizeof(char));
+
+    if(logdir == NULL) {
+        return NULL;
+    }
+
+    sprintf(logdir, "%s/%s", yannkinsDir, LOG_DIR);
+
+    if(create_directory(logdir)) {
+        free(logdir);
+        return NULL;
+    }
+
+    return logdir;
+}
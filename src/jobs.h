@@ -0,0 +1,243 @@
+/**
+ * \file jobs.h
+ * \brief execution of Yannkins' tasks by a pool of workers
+ *
+ * A job is a task : a command executed in a working directory, whose
+ * result is added in the file ${LOGDIR}/${TASK} and whose console output
+ * is written in ${LOGDIR}/${TASK}_console. The jobs are grouped in chains,
+ * usually one chain by project. A job starts when the jobs of its chain
+ * listed in "after" and "depends" are ended. Among the jobs ready to
+ * start, the longest ones go first : a job's rank is its expected
+ * duration, from its previous executions, plus the longest path of the
+ * jobs of its chain waiting for it. Each job belongs to a resource pool,
+ * with its own number of workers : the checkouts of the next projects
+ * don't wait for the compilations of the current ones, and don't take
+ * their processors. A chain may be cancelled while it runs : its jobs
+ * are killed or not started, and their result is CANCELLED.
+ */
+
+#ifndef YK_JOBS_H
+#define YK_JOBS_H 1
+
+#include <time.h>
+#include <sys/types.h>
+#include "capture.h"
+#include "project.h"
+
+/** \brief max length of a revision */
+#define REVISION_SIZE 64
+
+/** \brief default number of concurrent jobs of the fetch pool */
+#define FETCH_WORKERS 4
+
+/** \brief result of a task killed because it exceeded its limits */
+#define TIMEOUT_RESULT -1
+
+/** \brief result of a task killed, or not executed, because a newer revision arrived */
+#define CANCELLED_RESULT -4
+
+/** \brief seconds to wait after SIGTERM before sending SIGKILL */
+#define KILL_DELAY 10
+
+/** \brief written at the end of the console output of a killed task */
+#define KILL_NOTICE "Yannkins: task killed, time limit exceeded"
+
+/** \brief written at the end of the console output of a cancelled task */
+#define CANCEL_NOTICE "Yannkins: task cancelled, a newer revision arrived"
+
+/** \brief written at the end of the console output of a task whose agent was lost */
+#define LOST_NOTICE "Yannkins: task interrupted, its agent was lost"
+
+
+/**
+ * \brief State of a job.
+ */
+typedef enum {
+    JOB_PENDING, /**< \brief not yet started */
+    JOB_RUNNING, /**< \brief in execution */
+    JOB_DONE /**< \brief ended, or not executed */
+} job_state_t;
+
+
+/**
+ * \brief Resource pool of a job : what the job mostly waits for.
+ */
+typedef enum {
+    POOL_FETCH, /**< \brief checkouts and updates, bound by the network and the disks */
+    POOL_BUILD, /**< \brief compilations and the other tasks using the processors */
+    POOL_TEST, /**< \brief tests */
+    NB_POOLS /**< \brief number of pools */
+} job_pool_t;
+
+
+/**
+ * \brief Resources used by a task.
+ */
+typedef struct {
+    double duration; /**< \brief wall clock time in seconds */
+    double user; /**< \brief user CPU time in seconds */
+    double system; /**< \brief system CPU time in seconds */
+    long maxrss; /**< \brief peak resident set size in kB */
+    long inblock; /**< \brief number of blocks read */
+    long oublock; /**< \brief number of blocks written */
+} yk_usage;
+
+
+/**
+ * \brief A job, a task to execute.
+ */
+typedef struct yk_job_ {
+    char *task; /**< \brief the task's name */
+    char *workdir; /**< \brief where to execute the command */
+    char *command; /**< \brief the command to execute in a shell */
+    int timeout; /**< \brief wall clock limit in seconds, 0 for none */
+    int cpuLimit; /**< \brief CPU time limit in seconds, 0 for none */
+    yk_capture capture; /**< \brief how to capture the console output */
+    repository_t vcs; /**< \brief versioning system of the working directory */
+    job_pool_t pool; /**< \brief resource pool of the job */
+    char revision[REVISION_SIZE]; /**< \brief revision of the working directory */
+    char *after; /**< \brief tasks which must be ended before this one, NULL to follow the order of the chain */
+    char *depends; /**< \brief tasks which must succeed before this one */
+    job_state_t state; /**< \brief pending, running or done */
+    int success; /**< \brief when done, 1 if the job succeeded */
+    pid_t pid; /**< \brief process of the running job */
+    int remote; /**< \brief 1 if the job runs on an agent */
+    time_t date; /**< \brief start date of the job */
+    struct timespec start; /**< \brief start time to compute the duration */
+    double cpuTime; /**< \brief CPU time used by the job's process group */
+    time_t killDate; /**< \brief when SIGTERM was sent to the job, or 0 */
+    int token; /**< \brief 1 if the job holds a token of the make jobserver */
+    int upToDate; /**< \brief 1 if the job is known to be up to date, it won't be run */
+    int cancelled; /**< \brief 1 if the job was cancelled, superseded by a newer revision */
+    int lost; /**< \brief number of times the agent running the job was lost */
+    double expected; /**< \brief expected duration in seconds, from the previous executions, or -1 if unknown */
+    double rank; /**< \brief expected duration of the job and of the longest path of jobs waiting for it */
+    long expectedRss; /**< \brief expected peak resident memory in kB, from the previous executions, 0 if unknown */
+    time_t readyDate; /**< \brief when the job became ready to start, or 0 */
+    char *logdir; /**< \brief directory of the output files of the job, NULL for the one given to jobs_run() */
+    struct yk_job_ *next; /**< \brief the next job of the same chain */
+} yk_job;
+
+
+/**
+ * \brief A group of jobs, usually the tasks of a project.
+ */
+typedef struct yk_chain_ {
+    char *name; /**< \brief name of the chain, usually the project */
+    yk_job *jobs; /**< \brief the jobs in the order they were added */
+    yk_job *last; /**< \brief the last job of the chain */
+    struct yk_chain_ *next; /**< \brief the next chain */
+} yk_chain;
+
+
+/**
+ * \brief How to run the jobs.
+ */
+typedef struct {
+    int nbWorkers; /**< \brief the maximum number of concurrent tasks of the build and test pools */
+    int pools[NB_POOLS]; /**< \brief the maximum number of concurrent tasks of each pool, 0 for nbWorkers */
+    int force; /**< \brief 1 to run the tasks even if they are up to date */
+    int makeJobs; /**< \brief size of the make jobserver shared by all the tasks, 0 for none */
+    long memory; /**< \brief kB of memory for the expected peaks of the running tasks, 0 for no limit */
+    struct yk_agents_ *agents; /**< \brief remote workers taking the jobs the local ones can't take, or NULL */
+    int (*watch)(yk_chain **chains, void *data); /**< \brief called about every second while the jobs run, may cancel chains or add new ones at the end of the list ; while it returns 1, jobs_run() waits for new chains when no job is left ; or NULL */
+    void (*ended)(yk_chain **chains, yk_chain *chain, void *data); /**< \brief called when all the jobs of a chain are done : the chain is taken out of the list and given to the function, which frees it and may add new chains as watch ; NULL to keep the chains in the list */
+    void (*reaped)(yk_chain **chains, pid_t pid, int wstatus, void *data); /**< \brief called for the terminated children which are not jobs, started by the other functions, which may add new chains as watch ; or NULL */
+    void *watchData; /**< \brief given to watch, ended and reaped */
+} yk_schedule;
+
+
+/**
+ * \brief Create a new job.
+ * \param task the task's name
+ * \param workdir where to execute the command, may be NULL
+ * \param command the command to execute
+ * \param defaults the job from which the limits are copied
+ * \return the new job
+ */
+yk_job *jobs_create(const char *task, const char *workdir, const char *command, const yk_job *defaults);
+
+
+/**
+ * \brief Add a job at the end of its chain, creating the chain if needed.
+ * A job without "after" nor "depends" will start after the previous job
+ * of the chain.
+ * \param chains pointer on the first chain of the list
+ * \param name the chain's name
+ * \param job the job to add
+ * \return the chain of the job
+ */
+yk_chain *jobs_add(yk_chain **chains, const char *name, yk_job *job);
+
+
+/**
+ * \brief Run all the jobs of a list of chains.
+ *
+ * With a make jobserver, a job needs a token to start, and the "make"
+ * commands of the running jobs share the remaining tokens through
+ * MAKEFLAGS, appended to the inherited flags : the load stays at the
+ * size of the jobserver. Whenever no job holds a token, the jobserver is
+ * filled again, so the tokens lost by a killed make come back.
+ * The jobs of the fetch pool don't take a token, and are not counted in
+ * the workers of the schedule.
+ * A job only starts if the expected peaks of memory of the running jobs
+ * and of the new one fit in the memory of the schedule, and if the
+ * system would still have MEMORY_RESERVE percent of its memory
+ * available. When no job runs, the next one starts anyway.
+ * The jobs of the build and test pools which can't start for want of a
+ * free local worker, or of memory, are sent to the idle agents of the
+ * schedule.
+ * The makespan predicted from the expected durations of the jobs, and
+ * the actual one, are logged at the end.
+ *
+ * With the functions of the schedule, jobs_run() is a long-lived
+ * scheduler : new chains are added while the others run, and each chain
+ * is given back as soon as it is done.
+ * \param chains the jobs to run, given to jobs_run() if the schedule has an ended function
+ * \param schedule how to run the jobs
+ * \param logdir directory of the ouptut files
+ * \return 0 if all the tasks were executed and their results saved
+ */
+int jobs_run(yk_chain *chains, const yk_schedule *schedule, char *logdir);
+
+
+/**
+ * \brief Find a resource pool by its name : "fetch", "build" or "test".
+ * \param name the name of the pool
+ * \return the pool, or -1 if there is no such pool
+ */
+int jobs_pool(const char *name);
+
+
+/**
+ * \brief Read the number of workers of the pools, like "fetch=4,test=2".
+ * \param pools where to set the numbers of workers
+ * \param value the comma separated list of "pool=number"
+ * \return 0 if the value is correct
+ */
+int jobs_parse_pools(int pools[NB_POOLS], const char *value);
+
+
+/**
+ * \brief Cancel the jobs of a chain, from the watch function of
+ * jobs_run(). The running jobs are killed, the pending ones won't start.
+ * \param chain the chain to cancel
+ */
+void jobs_cancel(yk_chain *chain);
+
+
+/**
+ * \brief Free the memory used by a list of chains and their jobs.
+ * \param chains the chains to free
+ */
+void jobs_destroy(yk_chain *chains);
+
+
+/**
+ * \brief Find the directory of the output files, and create it if needed.
+ * \param yannkinsDir Yannkins' working directory
+ * \return the directory's name, to free, or NULL in case of error
+ */
+char *jobs_logdir(const char *yannkinsDir);
+
+#endif
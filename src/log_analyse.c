@@ -111,10 +111,24 @@ csv_table_t *nb_by_month(csv_table_t *table, char *date_header) {
 
     csv_table_t *result;
     char *headers[2] = { "month", "number of commits" };
-    int i; // line counter
+    csv_line_t *line;
+    int col = -1; // date column
+    int i;
     int numMonth; // month's number
     int number; // counter of occurences
 
+    // find column number
+    for(i = 0; i<table->nbCol; i++) {
+        if(!strcmp(date_header, table->headers[i])) {
+            col = i;
+        }
+    }
+
+    if(col < 0) {
+        log_error("column \"%s\" not found", date_header);
+        return NULL;
+    }
+
     csv_sort_table_decreasing(table, date_header);
 
     result = csv_create_table(headers, 2);
@@ -122,20 +136,15 @@ csv_table_t *nb_by_month(csv_table_t *table, char *date_header) {
     number = 0;
     numMonth = 0;
 
-    for(i=1; i<=table->nbLig; i++) {
+    for(line = table->lines; line != NULL; line = line->next) {
 
-        int err;
-        char value[100];
         int month;
 
-        err = csv_find_value(value, table, date_header, i);
-
-        if(err) {
-            log_error("An error occured line %d: %d", i, err);
+        if(line->values[col] == NULL) {
             continue;
         }
 
-        month = get_num_month(value);
+        month = get_num_month(line->values[col]);
         if(numMonth==0) { numMonth = month; }
 
         if(month == numMonth) {
@@ -155,6 +164,30 @@ csv_table_t *nb_by_month(csv_table_t *table, char *date_header) {
         }
     }
 
+    // the oldest month
+    if(numMonth != 0) {
+        add_line(result, numMonth, number);
+    }
+
+    return result;
+}
+
+
+
+csv_table_t *get_last_commits(csv_table_t *table, char *date_header, int nb) {
+
+    csv_table_t *result;
+    csv_line_t *line;
+    int i;
+
+    csv_sort_table_decreasing(table, date_header);
+
+    result = csv_create_table(table->headers, table->nbCol);
+
+    for(line = table->lines, i = 0; line != NULL && i < nb; line = line->next, i++) {
+        csv_add_line(result, line->values, table->nbCol);
+    }
+
     return result;
 }
 
@@ -225,7 +258,7 @@ static char **get_authors(csv_table_t *table, int *nbAuthors, char *author_heade
                 authors = realloc(authors, (size) * sizeof(char *));
             }
 
-            authors[nb] = malloc(strlen(author+1));
+            authors[nb] = malloc(strlen(author)+1);
             strcpy(authors[nb], author);
             authors[nb+1] = NULL;
             nb++;
@@ -251,6 +284,10 @@ static void free_authors(char **authors) {
 
     int i = 0;
 
+    if(authors == NULL) {
+        return;
+    }
+
     while(authors[i]!=NULL){
         free(authors[i]);
         i++;
@@ -43,6 +43,19 @@ csv_table_t *nb_by_month(csv_table_t *table, char *date_header);
 
 
 
+/**
+ * \brief Get the most recent entries of a log table.
+ *
+ * The input table will be sorted by decreasing date.
+ * \param table the data to process
+ * \param date_header the name of the date column
+ * \param nb the maximum number of entries to keep
+ * \return a new table with the last nb entries, the most recent first
+ */
+csv_table_t *get_last_commits(csv_table_t *table, char *date_header, int nb);
+
+
+
 /**
  * \brief Process a table of logs to count the number of entries(i.e. commits) by month and by authors.
  *
@@ -3,6 +3,8 @@
  * \brief log manager
  *
  * The logs will be written in the file in /var/log/yannkins/yannkins.log
+ *
+ * The logs may be written by several threads at once.
  */
 
 
@@ -11,6 +13,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <stdarg.h>
+#include <pthread.h>
 
 /** file where appends the logs */
 #define LOGFILE "yannkins.log"
@@ -24,6 +27,9 @@ static bool initialized = false;
 /** For tests, write logs on console instead of a file */
 static bool console = false;
 
+/** one message written at once */
+static pthread_mutex_t logMutex = PTHREAD_MUTEX_INITIALIZER;
+
 
 /**
  * Open the logs stream.
@@ -75,15 +81,14 @@ int close_log() {
 }
 
 
-static char *write_date() {
-
-    static char date[20];
+static char *write_date(char *date, size_t size) {
 
     time_t now;
-    time(&now);
+    struct tm tm;
 
-    struct tm *tm = localtime(&now);
-    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", tm);
+    time(&now);
+    localtime_r(&now, &tm);
+    strftime(date, size, "%Y-%m-%d %H:%M:%S", &tm);
 
     return date;
 }
@@ -97,11 +102,15 @@ static void log_message_va(const LogLevel_t level, const char *message_fmt, va_l
 
     FILE *out = stdout;
     FILE *fd = NULL;
+    char date[20];
+
+    pthread_mutex_lock(&logMutex);
 
     if(!console) {
         fd = fopen(LOGFILE, "a+");
         if(fd == NULL) {
             // Fail opening log file - abort logging
+            pthread_mutex_unlock(&logMutex);
             return;
         }
         out = fd;
@@ -125,13 +134,15 @@ static void log_message_va(const LogLevel_t level, const char *message_fmt, va_l
             levelName = "";
     }
 
-    fprintf(out, "%s - Yannkins %s: ", write_date(), levelName);
+    fprintf(out, "%s - Yannkins %s: ", write_date(date, sizeof(date)), levelName);
     vfprintf(out, message_fmt, va);
     fprintf(out, "\n");
 
     if(fd != NULL) {
         fclose(fd);
     }
+
+    pthread_mutex_unlock(&logMutex);
 }
 
 /**
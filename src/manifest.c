@@ -0,0 +1,319 @@
+/**
+ * \file manifest.c
+ * \brief what the HTML pages were created from
+ */
+
+#include "manifest.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+/** \brief max length of a line of the manifest */
+#define MANIFEST_LINE_SIZE 4096
+
+/** \brief first line of the manifest, with the version of the format of the pages */
+#define MANIFEST_HEADER "# report format %d\n"
+
+/** \brief bytes read at once to compute a hash */
+#define HASH_BUFFER_SIZE 65536
+
+/** \brief hash of a missing file */
+#define NO_HASH "-"
+
+
+/**
+ * \brief An input file of a page.
+ */
+typedef struct {
+    char *path; /**< \brief the file, relative to the directory of the inputs */
+    long long size; /**< \brief size in bytes, -1 if the file doesn't exist */
+    long long mtime; /**< \brief modification time in nanoseconds */
+    char hash[17]; /**< \brief hash of the content */
+} yk_input;
+
+
+struct yk_page_state_ {
+    char *page; /**< \brief the page's name */
+    int nbInputs; /**< \brief number of inputs */
+    yk_input *inputs; /**< \brief the inputs */
+    struct yk_page_state_ *next; /**< \brief the next page of the manifest */
+};
+
+
+struct yk_manifest_ {
+    yk_page_state *pages; /**< \brief the pages, in the order of the file */
+    yk_page_state *last; /**< \brief the last page */
+    int version; /**< \brief version of the format of the pages */
+};
+
+
+/**
+ * Hash the content of a file (64 bits FNV-1a).
+ *
+ * \param filename the file
+ * \param hash where to write the hash in hexadecimal, 17 characters
+ * \return 0 if the file was read
+ */
+static int hash_file(const char *filename, char *hash) {
+
+    unsigned long long value = 14695981039346656037ULL;
+    unsigned char buffer[HASH_BUFFER_SIZE];
+    size_t nb;
+    FILE *fd = fopen(filename, "r");
+
+    if(fd == NULL) {
+        strcpy(hash, NO_HASH);
+        return 1;
+    }
+
+    while((nb = fread(buffer, 1, HASH_BUFFER_SIZE, fd)) > 0) {
+        size_t i;
+        for(i = 0; i < nb; i++) {
+            value ^= buffer[i];
+            value *= 1099511628211ULL;
+        }
+    }
+
+    fclose(fd);
+    sprintf(hash, "%016llx", value);
+    return 0;
+}
+
+
+/**
+ * Create the state of a page, without inputs.
+ */
+static yk_page_state *create_state(const char *page, int nbInputs) {
+
+    yk_page_state *state = malloc(sizeof(yk_page_state));
+
+    state->page = strdup(page);
+    state->nbInputs = 0;
+    state->inputs = malloc((nbInputs > 0 ? nbInputs : 1) * sizeof(yk_input));
+    state->next = NULL;
+    return state;
+}
+
+
+void manifest_destroy_state(yk_page_state *state) {
+
+    int i;
+
+    if(state == NULL) {
+        return;
+    }
+
+    for(i = 0; i < state->nbInputs; i++) {
+        free(state->inputs[i].path);
+    }
+    free(state->inputs);
+    free(state->page);
+    free(state);
+}
+
+
+void manifest_add(yk_manifest *manifest, yk_page_state *state) {
+
+    state->next = NULL;
+    if(manifest->last == NULL) {
+        manifest->pages = state;
+    } else {
+        manifest->last->next = state;
+    }
+    manifest->last = state;
+}
+
+
+yk_page_state *manifest_take(yk_manifest *manifest, const char *page) {
+
+    yk_page_state **current;
+    yk_page_state *previous = NULL;
+
+    for(current = &(manifest->pages); *current != NULL; current = &((*current)->next)) {
+        yk_page_state *state = *current;
+        if(!strcmp(state->page, page)) {
+            *current = state->next;
+            if(manifest->last == state) {
+                manifest->last = previous;
+            }
+            state->next = NULL;
+            return state;
+        }
+        previous = state;
+    }
+
+    return NULL;
+}
+
+
+yk_manifest *manifest_read(const char *filename, int version) {
+
+    yk_manifest *manifest = malloc(sizeof(yk_manifest));
+    yk_page_state *state = NULL;
+    char line[MANIFEST_LINE_SIZE];
+    char header[64];
+    int allocated = 0;
+    FILE *fd;
+
+    manifest->pages = NULL;
+    manifest->last = NULL;
+    manifest->version = version;
+
+    fd = fopen(filename, "r");
+    if(fd == NULL) {
+        return manifest;
+    }
+
+    sprintf(header, MANIFEST_HEADER, version);
+    if(fgets(line, MANIFEST_LINE_SIZE, fd) == NULL || strcmp(line, header)) {
+        log_info("The pages were created in another format : creating them all");
+        fclose(fd);
+        return manifest;
+    }
+
+    while(fgets(line, MANIFEST_LINE_SIZE, fd) != NULL) {
+
+        char *fields[5];
+        yk_input *input;
+        int i;
+
+        line[strcspn(line, "\r\n")] = '\0';
+
+        // the path is between the page and the three last fields
+        fields[0] = line;
+        fields[1] = strchr(line, ';');
+        if(fields[1] == NULL) {
+            continue;
+        }
+        *fields[1]++ = '\0';
+        for(i = 4; i >= 2; i--) {
+            fields[i] = strrchr(fields[1], ';');
+            if(fields[i] == NULL) {
+                break;
+            }
+            *fields[i]++ = '\0';
+        }
+        if(i >= 2) {
+            continue;
+        }
+
+        if(state == NULL || strcmp(state->page, fields[0])) {
+            state = create_state(fields[0], 8);
+            allocated = 8;
+            manifest_add(manifest, state);
+        }
+
+        if(state->nbInputs == allocated) {
+            allocated *= 2;
+            state->inputs = realloc(state->inputs, allocated * sizeof(yk_input));
+        }
+
+        input = &state->inputs[state->nbInputs++];
+        input->path = strdup(fields[1]);
+        input->size = atoll(fields[2]);
+        input->mtime = atoll(fields[3]);
+        snprintf(input->hash, sizeof(input->hash), "%s", fields[4]);
+    }
+
+    fclose(fd);
+    return manifest;
+}
+
+
+yk_page_state *manifest_check(const yk_manifest *manifest, const char *page, const char *baseDir,
+        char **inputs, int nbInputs, int *changed) {
+
+    yk_page_state *state = create_state(page, nbInputs);
+    yk_page_state *previous;
+    int i;
+
+    for(previous = manifest->pages; previous != NULL && strcmp(previous->page, page); previous = previous->next);
+
+    *changed = (previous == NULL || previous->nbInputs != nbInputs);
+
+    for(i = 0; i < nbInputs; i++) {
+
+        yk_input *input = &state->inputs[i];
+        yk_input *before = NULL;
+        struct stat status;
+        char *filename = malloc(strlen(baseDir) + strlen(inputs[i]) + 2);
+
+        sprintf(filename, "%s/%s", baseDir, inputs[i]);
+        input->path = strdup(inputs[i]);
+        state->nbInputs++;
+
+        if(previous != NULL && i < previous->nbInputs && !strcmp(previous->inputs[i].path, inputs[i])) {
+            before = &previous->inputs[i];
+        }
+
+        if(stat(filename, &status)) {
+            input->size = -1;
+            input->mtime = 0;
+            strcpy(input->hash, NO_HASH);
+        } else {
+            input->size = status.st_size;
+            input->mtime = status.st_mtim.tv_sec * 1000000000LL + status.st_mtim.tv_nsec;
+            if(before != NULL && before->size == input->size && before->mtime == input->mtime) {
+                strcpy(input->hash, before->hash);
+            } else {
+                hash_file(filename, input->hash);
+            }
+        }
+        free(filename);
+
+        if(before == NULL || before->size != input->size || strcmp(before->hash, input->hash)) {
+            *changed = 1;
+        }
+    }
+
+    return state;
+}
+
+
+int manifest_write(const yk_manifest *manifest, const char *filename) {
+
+    yk_page_state *state;
+    char *tmpfile = malloc(strlen(filename) + 5);
+    FILE *fd;
+    int err;
+
+    sprintf(tmpfile, "%s.tmp", filename);
+    fd = fopen(tmpfile, "w");
+    if(fd == NULL) {
+        log_error("Can't create file %s : %s", tmpfile, strerror(errno));
+        free(tmpfile);
+        return 1;
+    }
+
+    fprintf(fd, MANIFEST_HEADER, manifest->version);
+    for(state = manifest->pages; state != NULL; state = state->next) {
+        int i;
+        for(i = 0; i < state->nbInputs; i++) {
+            fprintf(fd, "%s;%s;%lld;%lld;%s\n", state->page, state->inputs[i].path, state->inputs[i].size,
+                    state->inputs[i].mtime, state->inputs[i].hash);
+        }
+    }
+
+    err = fclose(fd) || rename(tmpfile, filename);
+    if(err) {
+        log_error("Can't write file %s : %s", filename, strerror(errno));
+        remove(tmpfile);
+    }
+
+    free(tmpfile);
+    return err;
+}
+
+
+void manifest_destroy(yk_manifest *manifest) {
+
+    while(manifest->pages != NULL) {
+        yk_page_state *state = manifest->pages;
+        manifest->pages = state->next;
+        manifest_destroy_state(state);
+    }
+    free(manifest);
+}
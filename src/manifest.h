@@ -0,0 +1,99 @@
+/**
+ * \file manifest.h
+ * \brief what the HTML pages were created from
+ *
+ * The manifest keeps, for each page, the files read to create it : their
+ * size, their modification time and a hash of their content. A page is
+ * only created again if one of these files changed. The hash of a file
+ * is only computed again when its size or its modification time changed :
+ * a file rewritten with the same content doesn't change the page.
+ *
+ * The manifest is a file with a line by page and input file :
+ *     ${PAGE};${FILE};${SIZE};${MTIME};${HASH}
+ * where the size of a missing file is -1. Its first line gives the version
+ * of the format of the pages : when the program creating them changes it,
+ * all of them are created again.
+ */
+
+#ifndef YK_MANIFEST_H
+#define YK_MANIFEST_H 1
+
+
+/**
+ * \brief The pages and their inputs.
+ */
+typedef struct yk_manifest_ yk_manifest;
+
+
+/**
+ * \brief The state of the inputs of a page.
+ */
+typedef struct yk_page_state_ yk_page_state;
+
+
+/**
+ * \brief Read a manifest.
+ * \param filename the manifest's file
+ * \param version the version of the format of the pages
+ * \return the manifest, empty if the file doesn't exist or was written
+ *         for another version of the format
+ */
+yk_manifest *manifest_read(const char *filename, int version);
+
+
+/**
+ * \brief Look at the inputs of a page.
+ * \param manifest the manifest of the last creation of the pages
+ * \param page the page's name
+ * \param baseDir the directory of the inputs
+ * \param inputs the files read to create the page, relative to baseDir
+ * \param nbInputs the number of inputs
+ * \param changed set to 1 if an input changed since the page was created,
+ *        or if the page is not in the manifest
+ * \return the state of the inputs, to add in the next manifest once the
+ *         page is created
+ */
+yk_page_state *manifest_check(const yk_manifest *manifest, const char *page, const char *baseDir,
+        char **inputs, int nbInputs, int *changed);
+
+
+/**
+ * \brief Take the state of the inputs of a page out of a manifest, to keep
+ * it in the next one when the page is not created again.
+ * \param manifest the manifest
+ * \param page the page's name
+ * \return the state, to add in the next manifest or to free, or NULL if
+ *         the page is not in the manifest
+ */
+yk_page_state *manifest_take(yk_manifest *manifest, const char *page);
+
+
+/**
+ * \brief Add the state of the inputs of a page.
+ * \param manifest the manifest
+ * \param state the state, given to the manifest
+ */
+void manifest_add(yk_manifest *manifest, yk_page_state *state);
+
+
+/**
+ * \brief Free the state of the inputs of a page.
+ */
+void manifest_destroy_state(yk_page_state *state);
+
+
+/**
+ * \brief Write a manifest. The file is replaced at once.
+ * \param manifest the manifest
+ * \param filename the manifest's file
+ * \return 0 if the file was written
+ */
+int manifest_write(const yk_manifest *manifest, const char *filename);
+
+
+/**
+ * \brief Free a manifest.
+ */
+void manifest_destroy(yk_manifest *manifest);
+
+#endif
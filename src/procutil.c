@@ -0,0 +1,101 @@
+/**
+ * \file procutil.c
+ * \brief information on the running processes, read in /proc
+ */
+
+#include "procutil.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+
+/** \brief where the kernel tells the available memory */
+#define MEMINFO_FILE "/proc/meminfo"
+
+
+void proc_cpu_times(const pid_t *groups, double *times, int nb) {
+
+    DIR *proc;
+    struct dirent *entry;
+    long ticks = sysconf(_SC_CLK_TCK);
+    int i;
+
+    for(i = 0; i < nb; i++) {
+        times[i] = 0;
+    }
+
+    if(nb == 0) {
+        return;
+    }
+
+    proc = opendir("/proc");
+    if(proc == NULL) {
+        return;
+    }
+
+    while((entry = readdir(proc)) != NULL) {
+
+        char filename[300];
+        char stat[1024];
+        char *end;
+        FILE *fd;
+        int pgrp;
+        unsigned long utime, stime;
+        long cutime, cstime;
+
+        if(entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+
+        sprintf(filename, "/proc/%s/stat", entry->d_name);
+        fd = fopen(filename, "r");
+        if(fd == NULL) {
+            continue;
+        }
+        end = fgets(stat, sizeof(stat), fd);
+        fclose(fd);
+        if(end == NULL) {
+            continue;
+        }
+
+        // the command's name may contain spaces : look after the last ')'
+        end = strrchr(stat, ')');
+        if(end == NULL || sscanf(end + 1, " %*c %*d %d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %ld %ld",
+                    &pgrp, &utime, &stime, &cutime, &cstime) != 5) {
+            continue;
+        }
+
+        for(i = 0; i < nb; i++) {
+            if(groups[i] == pgrp) {
+                times[i] += (double) (utime + stime + cutime + cstime) / ticks;
+                break;
+            }
+        }
+    }
+
+    closedir(proc);
+}
+
+
+int proc_meminfo(long *total, long *available) {
+
+    FILE *fd;
+    char line[128];
+    int found = 0;
+
+    fd = fopen(MEMINFO_FILE, "r");
+    if(fd == NULL) {
+        return 1;
+    }
+
+    while(found != 3 && fgets(line, sizeof(line), fd) != NULL) {
+        if(sscanf(line, "MemTotal: %ld", total) == 1) {
+            found |= 1;
+        } else if(sscanf(line, "MemAvailable: %ld", available) == 1) {
+            found |= 2;
+        }
+    }
+
+    fclose(fd);
+    return found != 3;
+}
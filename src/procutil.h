@@ -0,0 +1,30 @@
+/**
+ * \file procutil.h
+ * \brief information on the running processes, read in /proc
+ */
+
+#ifndef YK_PROCUTIL_H
+#define YK_PROCUTIL_H 1
+
+#include <sys/types.h>
+
+
+/**
+ * \brief Give the CPU time used by some process groups : the sum, for all
+ * their living processes, of their own time and of the time of their
+ * terminated children.
+ * \param groups the process groups
+ * \param times filled with the CPU time of each group, in seconds
+ * \param nb number of groups
+ */
+void proc_cpu_times(const pid_t *groups, double *times, int nb);
+
+/**
+ * \brief Read the total and the available memory of the system.
+ * \param total set to the total memory in kB
+ * \param available set to the available memory in kB
+ * \return 0 if they were found
+ */
+int proc_meminfo(long *total, long *available);
+
+#endif
@@ -9,6 +9,32 @@
 #include <stdlib.h> //malloc
 #include <string.h>
 
+/**
+ * \brief Find a task of a project, or add it at the end of the list.
+ * \param project the project
+ * \param name the task's name
+ * \return the task
+ */
+static yk_task *yk_get_task(yk_project *project, char *name){
+
+    yk_task **task = &(project->tasks);
+
+    while(*task != NULL){
+        if(!strcmp((*task)->name, name)) {
+            return *task;
+        }
+        task = &((*task)->next);
+    }
+
+    *task = malloc(sizeof(yk_task));
+    (*task)->name = strdup(name);
+    (*task)->command = NULL;
+    (*task)->depends = NULL;
+    (*task)->next = NULL;
+
+    return *task;
+}
+
 yk_project *yk_read_project_file(char *filename){
 
     FILE *fd; /* file descriptor */
@@ -29,10 +55,15 @@ yk_project *yk_read_project_file(char *filename){
         project->project_name=NULL;
         project->versioning_type=NONE;
         project->repository=NULL;
+        project->upstream=NULL;
         project->repos_user=NULL;
         project->repos_password=NULL;
         project->compil_cmd=NULL;
         project->tests_cmd=NULL;
+        project->timeout=0;
+        project->cpu_limit=0;
+        project->poll_interval=0;
+        project->tasks=NULL;
 
         while(fgets(line, 250, fd)!=NULL){
 
@@ -79,6 +110,9 @@ yk_project *yk_read_project_file(char *filename){
                 project->versioning_type=GIT;
                 project->repository=malloc((strlen(value)+1)*sizeof(char));
                 strcpy(project->repository, value);
+            } else if(!strcmp(line, "GIT_UPSTREAM")){
+                project->upstream=malloc((strlen(value)+1)*sizeof(char));
+                strcpy(project->upstream, value);
             } else if(!strcmp(line, "SVN_USER") || !strcmp(line, "GIT_USER")){
                 project->repos_user=malloc((strlen(value)+1)*sizeof(char));
                 strcpy(project->repos_user, value);
@@ -91,6 +125,24 @@ yk_project *yk_read_project_file(char *filename){
             } else if(!strcmp(line, "TESTS_UNI")){
                 project->tests_cmd=malloc((strlen(value)+1)*sizeof(char));
                 strcpy(project->tests_cmd, value);
+            } else if(!strcmp(line, "TIMEOUT")){
+                project->timeout=atoi(value);
+            } else if(!strcmp(line, "CPU_LIMIT")){
+                project->cpu_limit=atoi(value);
+            } else if(!strcmp(line, "POLL_INTERVAL")){
+                project->poll_interval=yk_parse_duration(value);
+                if(project->poll_interval < 0) {
+                    log_warning("File %s : invalid POLL_INTERVAL %s", filename, value);
+                    project->poll_interval=0;
+                }
+            } else if(!strncmp(line, "TASK_", 5) && line[5]!='\0'){
+                yk_task *task = yk_get_task(project, line+5);
+                free(task->command);
+                task->command = strdup(value);
+            } else if(!strncmp(line, "DEPENDS_", 8) && line[8]!='\0'){
+                yk_task *task = yk_get_task(project, line+8);
+                free(task->depends);
+                task->depends = strdup(value);
             }
 
             // if we have not read the end of line
@@ -109,6 +161,43 @@ yk_project *yk_read_project_file(char *filename){
     return project;
 }
 
+int yk_is_project_file(const char *name){
+    return name[0] != '.' && name[0] != '\0' && name[strlen(name) - 1] != '~';
+}
+
+int yk_parse_duration(const char *value){
+
+    char *unit;
+    long duration = strtol(value, &unit, 10);
+
+    if(unit == value || duration < 0) {
+        return -1;
+    }
+
+    switch(*unit) {
+        case '\0':
+        case 's':
+            break;
+        case 'm':
+            duration *= 60;
+            break;
+        case 'h':
+            duration *= 3600;
+            break;
+        case 'd':
+            duration *= 86400;
+            break;
+        default:
+            return -1;
+    }
+
+    if(*unit != '\0' && unit[1] != '\0') {
+        return -1;
+    }
+
+    return (int) duration;
+}
+
 void yk_destroy_project(yk_project *project){
 
     if(project == NULL){
@@ -121,6 +210,9 @@ void yk_destroy_project(yk_project *project){
     if(project->repository != NULL){
         free(project->repository);
     }
+    if(project->upstream != NULL){
+        free(project->upstream);
+    }
     if(project->repos_user != NULL){
         free(project->repos_user);
     }
@@ -133,6 +225,14 @@ void yk_destroy_project(yk_project *project){
     if(project->tests_cmd != NULL){
         free(project->tests_cmd);
     }
+    while(project->tasks != NULL){
+        yk_task *next = project->tasks->next;
+        free(project->tasks->name);
+        free(project->tasks->command);
+        free(project->tasks->depends);
+        free(project->tasks);
+        project->tasks = next;
+    }
 
     free(project);
 }
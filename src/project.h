@@ -17,6 +17,17 @@ typedef enum {
 } repository_t;
 
 
+/**
+ * \brief A named task of a project, declared by TASK_<NAME>="command"
+ */
+typedef struct yk_task_ {
+    char *name; /**< \brief name of the task */
+    char *command; /**< \brief command of the task, may be NULL if only DEPENDS_<NAME> is set */
+    char *depends; /**< \brief space separated names of the tasks which must succeed before this one */
+    struct yk_task_ *next; /**< \brief the next task of the project */
+} yk_task;
+
+
 /**
  * \brief Data of a project
  */
@@ -24,10 +35,15 @@ typedef struct {
     char *project_name; /**< \brief name of this project */
     repository_t versioning_type; /**< \brief which versionning system is used */
     char *repository; /**< \brief repository's url */
+    char *upstream; /**< \brief url of the git repository whose mirror is shared by this project, may be NULL */
     char *repos_user; /**< \brief login for svn authentification */
     char *repos_password; /**< \brief password for svn authentification */
     char *compil_cmd; /**< \brief compilation command*/
     char *tests_cmd; /**< \brief unit tests command */
+    int timeout; /**< \brief wall clock limit of a task in seconds, 0 for none */
+    int cpu_limit; /**< \brief CPU time limit of a task in seconds, 0 for none */
+    int poll_interval; /**< \brief in daemon mode, seconds between two analyses, 0 for the default */
+    yk_task *tasks; /**< \brief other tasks, in the order of the file */
 } yk_project;
 
 /**
@@ -38,6 +54,23 @@ typedef struct {
 yk_project *yk_read_project_file(char *filename);
 
 
+/**
+ * \brief Is a file of the projects' directory a project ? The hidden files
+ * and the backups ending with '~' are ignored.
+ * \param name the file's name
+ * \return 1 for a project's file
+ */
+int yk_is_project_file(const char *name);
+
+
+/**
+ * \brief Read a duration, in seconds or with a unit : "90", "2m", "6h", "1d".
+ * \param value the duration
+ * \return the number of seconds, or -1 if the duration is not valid
+ */
+int yk_parse_duration(const char *value);
+
+
 /**
  * \brief Free the memory.
  * \param a struct to free
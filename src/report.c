@@ -0,0 +1,1216 @@
+/**
+ * \file report.c
+ * \brief Create the HTML pages.
+ *
+ * This must be done after the tasks of configurated projects. It will create the index pages
+ * with the links to projects resumes, plus one page by projects.
+ *
+ * Each project's page will present the results of the tasks and a list of the latest commit's comments.
+ *
+ * A project's page is only created again if the files it is created from
+ * changed, as told by the manifest ${YANNKINS_HOME}/log/REPORT_MANIFEST.
+ * The pages of the projects are created by several threads, the index once
+ * all of them are done.
+ */
+
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <stdlib.h> // free(), getenv()
+#include <string.h> // strlen()
+#include <unistd.h> // access()
+#include <errno.h>
+#include <time.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include "html/html.h"
+#include "html/template.h"
+#include "xml/xml.h"
+#include "csv/csv.h"
+#include "report.h"
+#include "manifest.h"
+#include "project.h"
+#include "log_analyse.h"
+#include "logger.h"
+
+
+/** \brief where are the projects defined */
+#define PROJECTS_DIR "projects"
+
+/** \brief title of the html page */
+#define TITLE "Yannkins' statistics - The best of continuous integration services"
+/** \brief image for failed task */
+#define FAIL_ICON "icons/fail.png"
+/** \brief image for successfull task */
+#define OK_ICON "icons/ok.png"
+/** \brief image for task killed because it was too long */
+#define TIMEOUT_ICON "icons/timeout.png"
+/** \brief image for task cancelled because a newer revision arrived */
+#define CANCELLED_ICON "icons/cancelled.png"
+/** \brief index html page for report */
+#define HTML_FILE "www/index.html"
+/** \brief skeleton of the pages */
+#define TEMPLATE_FILE "www/page.tpl"
+/** \brief skeleton of the pages if TEMPLATE_FILE is missing */
+#define DEFAULT_TEMPLATE "<!DOCTYPE html>\n<html>\n    <head>\n        <title>${TITLE}</title>\n" \
+    "        <meta charset=\"utf-8\">\n        <link rel=\"stylesheet\" href=\"style/style.css\">\n" \
+    "    </head>\n    <body>\n${include bandeau.html}\n${BODY}\n    </body>\n</html>\n"
+/** \brief slot of the template for the page's title */
+#define TITLE_SLOT 0
+/** \brief slot of the template for the page's content */
+#define BODY_SLOT 1
+/** \brief what the pages were created from */
+#define MANIFEST_FILE "log/REPORT_MANIFEST"
+/** \brief version of the format of the pages, to increase when the code changes them : all are created again */
+#define REPORT_FORMAT_VERSION 1
+/** \brief directory of the pages, of their template and of the files it includes */
+#define WWW_DIR "www"
+
+// RESULTS OF A TASK
+/** \brief the task was successfull */
+#define RESULT_OK 0
+/** \brief the task failed */
+#define RESULT_FAIL 1
+/** \brief the task exceeded its time limits */
+#define RESULT_TIMEOUT 2
+/** \brief Task superseded by a newer revision */
+#define RESULT_CANCELLED 3
+
+/** \brief result of a task skipped because its sources did not change */
+#define SKIPPED_RESULT "SKIPPED (up to date)"
+/** \brief result of a task not executed because a dependency failed */
+#define DEPENDENCY_RESULT "SKIPPED (dependency failed)"
+
+// ERROR CODES
+/** \brief Error code allocation */
+#define ERR_MEMORY 2
+/** \brief Error code opening file */
+#define ERR_OPEN_FILE 1
+/** \brief Error code OK */
+#define ERR_OK 0
+
+/** \brief number of commits shown on a project's page */
+#define NB_COMMITS 10
+
+/** \brief number of bisections shown on a project's page */
+#define NB_BISECTIONS 5
+
+// STRING CONSTANTS
+/** \brief how to display source code recovery task's name*/
+#define REPOS_LABEL "Source code recovery"
+/** \brief how to display compilation task's name*/
+#define COMPILATION_LABEL "Project 's compilation"
+/** \brief how to display tests task's name*/
+#define TESTS_LABEL "Units' tests execution"
+
+
+// TYPEDEF
+
+/**
+ * Data to show for one task. This is one line in a project's resume table.
+ */
+typedef struct yannkins_line_t_ {
+    int result; /**< RESULT_OK, RESULT_FAIL, RESULT_TIMEOUT or RESULT_CANCELLED */
+    char *name; /**< the task's name */
+    const char *note; /**< shown after the name, why the task was not executed, or NULL */
+    char date[17]; /**< the last execution date */
+    char lastSuccessDate[17]; /**< the date of last successfull exectution */
+    char duration[20]; /**< wall clock duration of the last execution */
+    char cpu[48]; /**< user and system CPU time of the last execution */
+    char memory[20]; /**< peak memory of the last execution */
+    char io[40]; /**< number of blocks read and written by the last execution */
+    char *console_file; /**< the name of console output file */
+} yannkins_line_t;
+
+// FUNCTIONS
+
+
+/**
+ * \brief concatenate two strings adding a '/' between the two.
+ * \param beg the beginning string
+ * \param end the ending string
+ * \return a pointer to the concatenated string. Must be freed.
+ */
+static char *concat_path(char *beg, char *end) {
+
+    char *result = malloc(sizeof(char) *(strlen(beg)+strlen(end)+2));
+
+    if(result==NULL){
+        log_error("Allocation error");
+        return NULL;
+    }
+
+    sprintf(result, "%s/%s", beg, end);
+    return result;
+}
+
+
+/**
+ * \brief Get the value of a field in a line of a task's log file.
+ * \param log the content of the file
+ * \param line a line of the file
+ * \param header the name of the column
+ * \return the value, or NULL if the column does not exist or is empty
+ */
+static char *get_field(csv_table_t *log, csv_line_t *line, char *header) {
+
+    int i;
+
+    for(i = 0; i < log->nbCol; i++) {
+        if(!strcmp(log->headers[i], header)) {
+            if(line->values[i] == NULL || line->values[i][0] == '\0') {
+                return NULL;
+            }
+            return line->values[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * \brief Write a duration in human readable form.
+ * \param buffer where to write, at least 20 characters
+ * \param value the duration in seconds, as written in the log file
+ */
+static void format_duration(char *buffer, char *value) {
+
+    double seconds;
+    long total;
+
+    if(value == NULL) {
+        strcpy(buffer, "-");
+        return;
+    }
+
+    seconds = atof(value);
+    total = (long) seconds;
+
+    if(total >= 3600) {
+        sprintf(buffer, "%ldh%02ldm%02lds", total / 3600, (total % 3600) / 60, total % 60);
+    } else if(total >= 60) {
+        sprintf(buffer, "%ldm%02lds", total / 60, total % 60);
+    } else {
+        sprintf(buffer, "%.2fs", seconds);
+    }
+}
+
+
+/**
+ * \brief Write a memory size in human readable form.
+ * \param buffer where to write, at least 20 characters
+ * \param value the size in kB, as written in the log file
+ */
+static void format_memory(char *buffer, char *value) {
+
+    double size;
+
+    if(value == NULL) {
+        strcpy(buffer, "-");
+        return;
+    }
+
+    size = atof(value);
+
+    if(size >= 1024 * 1024) {
+        sprintf(buffer, "%.1f GB", size / (1024 * 1024));
+    } else if(size >= 1024) {
+        sprintf(buffer, "%.1f MB", size / 1024);
+    } else {
+        sprintf(buffer, "%.0f kB", size);
+    }
+}
+
+
+/**
+ * \brief Write the project's resume table at the end of a HTML document.
+ *
+ * The created table will contains a line by executed task to show the results
+ * such as "success", "execution date", "last success date", the resources
+ * used by the last execution, ...
+ * The last column will present a link to see the last console output.
+ * \param page the HTML page where append the table
+ * \param lines the datas to put in the table, must end with NULL value
+ */
+static void write_yannkins_table(htmlStream *page, yannkins_line_t **lines){
+
+    yannkins_line_t *line; // current line
+    int i = 0; // counter
+    char *headers[9] = { "Last result" , "Task", "Last execution date", "Last success date",
+        "Duration", "CPU time (user / system)", "Peak memory", "Blocks (read / written)", "Console output" };
+    char *cells[6];
+    int j;
+
+    if(lines == NULL){
+        return;
+    }
+
+    html_stream_open(page, "table");
+    html_stream_open(page, "thead");
+    html_stream_open(page, "tr");
+    for(j = 0; j < 9; j++) {
+        html_stream_open(page, "th");
+        html_stream_text(page, headers[j]);
+        html_stream_close(page);
+    }
+    html_stream_close(page);
+    html_stream_close(page);
+    html_stream_open(page, "tbody");
+
+    line = lines[0];
+    while(line != NULL){
+
+        char *icon;
+        char *label;
+        char *consoleOutputPath;
+
+        switch(line->result) {
+        case RESULT_OK:
+            icon = OK_ICON;
+            label = "OK";
+            break;
+        case RESULT_TIMEOUT:
+            icon = TIMEOUT_ICON;
+            label = "TIMEOUT";
+            break;
+        case RESULT_CANCELLED:
+            icon = CANCELLED_ICON;
+            label = "CANCELLED";
+            break;
+        default:
+            icon = FAIL_ICON;
+            label = "FAIL";
+        }
+
+        html_stream_open(page, "tr");
+
+        html_stream_open(page, "td");
+        html_stream_image(page, icon, 32, 32, label);
+        html_stream_close(page);
+
+        html_stream_open(page, "td");
+        html_stream_text(page, line->name);
+        if(line->note != NULL) {
+            html_stream_text(page, " (");
+            html_stream_text(page, line->note);
+            html_stream_text(page, ")");
+        }
+        html_stream_close(page);
+
+        cells[0] = line->date;
+        cells[1] = line->lastSuccessDate;
+        cells[2] = line->duration;
+        cells[3] = line->cpu;
+        cells[4] = line->memory;
+        cells[5] = line->io;
+        for(j = 0; j < 6; j++) {
+            html_stream_open(page, "td");
+            html_stream_text(page, cells[j]);
+            html_stream_close(page);
+        }
+
+        consoleOutputPath = concat_path("log", line->console_file);
+        html_stream_open(page, "td");
+        html_stream_link(page, "see", consoleOutputPath);
+        html_stream_close(page);
+        free(consoleOutputPath);
+
+        html_stream_close(page);
+
+        i++;
+        line = lines[i];
+    }
+
+    html_stream_close(page);
+    html_stream_close(page);
+}
+
+
+/**
+ * \brief Create a struct for a line if the file passed in argument is the log file of a task.
+ * \param filename complete name
+ * \param basename name of file without path. Console output is suppose to be in file "${basename}_console",
+ * or "${basename}_console.gz" if it was compressed
+ * \param entryName the task's name, basename will be use instead if NULL
+ * \return NULL if filename is not the name of a task log
+ */
+static yannkins_line_t *new_entry(char *filename, char *basename, char *entryName){
+
+    yannkins_line_t *entry = NULL; // return value
+    csv_table_t *log; // content of the file
+    csv_line_t *logline; // a line of the file
+    csv_line_t *last; // last line of the file, skipped executions excepted
+    const char *note = NULL; // why the task was not executed the last time
+    char *lastSuccessDate = NULL; // record for last success date
+    char *name =entryName; // task's name
+
+    // don't take in account "." and ".."
+    if( (!strcmp(basename, ".")) || (!strcmp(basename,"..")) ){
+        return NULL;
+    }
+
+    // don't take in account the names ending with "_console" or "_console.gz"
+    if(strlen(basename)>=8){
+        int index; // position in filename
+        index=strlen(basename)-8;
+        if(!strcmp(basename+index, "_console")){
+            return NULL;
+        }
+    }
+    if(strstr(basename, "_console.gz") != NULL){
+        return NULL;
+    }
+
+    // reading log file
+    log = csv_read_file(filename, ';');
+    if(log==NULL){
+        return NULL;
+    }
+
+    if((log->nbCol < 2) || (log->nbLig < 1)){
+        log_warning("Incorrect file: %s\n%d column(s), %d line(s)", basename, log->nbCol, log->nbLig);
+        csv_show_table(log, stderr);
+        csv_destroy_table(log);
+        return NULL;
+    }
+
+    // view last log line
+    logline=log->lines;
+    last=NULL;
+    while(logline!=NULL){
+        if(!strcmp(logline->values[1], SKIPPED_RESULT)){
+            note = "up to date";
+        } else {
+            // a task not executed because of a dependency is shown as failed
+            note = strcmp(logline->values[1], DEPENDENCY_RESULT) ? NULL : "not run, dependency failed";
+            last=logline;
+            if(!strcmp(last->values[1], "OK")){
+                lastSuccessDate = last->values[0];
+            }
+        }
+        logline=logline->next;
+    }
+
+    if(last==NULL){
+        csv_destroy_table(log);
+        return NULL;
+    }
+
+    // result
+    entry = malloc(sizeof(yannkins_line_t));
+
+    entry->result = RESULT_OK;
+    entry->note = note;
+    strcpy(entry->date, "NC");
+    if(name == NULL) { name = basename; }
+    entry->name=malloc((strlen(name)+1)*sizeof(char));
+    strcpy(entry->name, name);
+    strcpy(entry->lastSuccessDate, "-");
+
+    if(strlen(last->values[0])>0){
+        strncpy(entry->date, last->values[0], 16);
+        entry->date[16]='\0';
+    }
+
+    if(!strcmp(last->values[1], "TIMEOUT")){
+        entry->result = RESULT_TIMEOUT;
+    } else if(!strcmp(last->values[1], "CANCELLED")){
+        entry->result = RESULT_CANCELLED;
+    } else if(strcmp(last->values[1], "OK")){
+        entry->result = RESULT_FAIL;
+    }
+
+    if((lastSuccessDate != NULL) && (strlen(lastSuccessDate)>0)){
+        strncpy(entry->lastSuccessDate, lastSuccessDate, 16);
+        entry->lastSuccessDate[16]='\0';
+    }
+
+    // resources used by the last execution
+    format_duration(entry->duration, get_field(log, last, "duration"));
+    strcpy(entry->cpu, "-");
+    if(get_field(log, last, "user") != NULL && get_field(log, last, "system") != NULL) {
+        char user[20];
+        char system[20];
+        format_duration(user, get_field(log, last, "user"));
+        format_duration(system, get_field(log, last, "system"));
+        snprintf(entry->cpu, sizeof(entry->cpu), "%s / %s", user, system);
+    }
+    format_memory(entry->memory, get_field(log, last, "maxrss"));
+    strcpy(entry->io, "-");
+    if(get_field(log, last, "inblock") != NULL && get_field(log, last, "oublock") != NULL) {
+        snprintf(entry->io, sizeof(entry->io), "%s / %s", get_field(log, last, "inblock"), get_field(log, last, "oublock"));
+    }
+
+    entry->console_file = malloc((strlen(filename)+1+11)*sizeof(char));
+    sprintf(entry->console_file, "%s_console.gz", filename);
+    if(access(entry->console_file, F_OK)) {
+        sprintf(entry->console_file, "%s_console", basename);
+    } else {
+        sprintf(entry->console_file, "%s_console.gz", basename);
+    }
+
+    // end
+    csv_destroy_table(log);
+
+    return entry;
+}
+
+
+/**
+ * Initialyze the lines for the table.
+ * \param project the project's definition
+ * \param yannkinsRep the directory where Yannkins is installed
+ * \return a table of yannkins_line_t with NULL at the end, or NULL if there
+ * are no elements.
+ */
+static yannkins_line_t **init_lines(yk_project *project, char *yannkinsRep){
+
+    char *logdir; // name of directory
+
+    yannkins_line_t **lines = NULL; // allocated table of *line
+    int i = 0; // counter : number of entries in lines
+    int allocatedSize = 0; // number of allocated entries in lines
+
+    yk_task *task = project->tasks;
+    int j;
+
+    char *tasks[3];
+    tasks[0]=REPOS_TASK;
+    tasks[1]=COMPILATION_TASK;
+    tasks[2]=TESTS_TASK;
+
+    logdir = malloc(strlen(yannkinsRep)+5);
+    sprintf(logdir, "%s/log", yannkinsRep);
+
+    // the three usual tasks, then the tasks declared by the project
+    for(j=0; j<3 || task!=NULL; j++){
+        yannkins_line_t *entry;
+        char *file; // name of a file
+        char *basename;
+        char *taskTag;
+        char *taskName = NULL;
+
+        switch(j) {
+        case 0:
+            taskName = REPOS_LABEL;
+            break;
+        case 1:
+            taskName = COMPILATION_LABEL;
+            break;
+        case 2:
+            taskName = TESTS_LABEL;
+            break;
+        default:
+            taskName = task->name;
+        }
+
+        if(j<3) {
+            taskTag = tasks[j];
+        } else {
+            int declared = (task->command != NULL);
+            taskTag = task->name;
+            task = task->next;
+            // only DEPENDS_<NAME> was given
+            if(!declared) {
+                continue;
+            }
+        }
+
+        basename=malloc(strlen(taskTag)+strlen(project->project_name)+2);
+        sprintf(basename, "%s_%s", taskTag, project->project_name);
+        file=malloc(strlen(logdir)+strlen(basename)+2);
+        sprintf(file, "%s/%s", logdir, basename);
+
+        entry = new_entry(file, basename, taskName);
+        free(basename);
+        free(file);
+
+        // add the entry
+        if(entry!=NULL){
+            // take in account the size for the last NULL pointer
+            if(i>=allocatedSize-2){
+                allocatedSize+=20;
+                lines = realloc(lines, allocatedSize*sizeof(yannkins_line_t *));
+            }
+            lines[i]=entry;
+            i++;
+        }
+    }
+
+    free(logdir);
+    if(i == 0) {
+      // We have no valid entry and "lines" was not allocated
+      return NULL;
+    }
+    lines[i]=NULL;
+    return lines;
+}
+
+
+/**
+ * \brief Write the last bisections of the tests' failures of a project, if
+ * there are some.
+ * \param page the HTML page where append the table
+ * \param project the project definition
+ * \param yannkinsRep the directory where Yannkins is installed
+ */
+static void write_bisections(htmlStream *page, yk_project *project, char *yannkinsRep) {
+
+    char *fichier;
+    csv_table_t *data;
+    csv_table_t *last;
+    csv_table_t *data_s;
+    char *elementsCherches[5];
+    int nb;
+
+    fichier = malloc(sizeof(char) * (strlen(yannkinsRep) + strlen(BISECT_TASK) + strlen(project->project_name) + 7));
+    sprintf(fichier, "%s/log/%s_%s", yannkinsRep, BISECT_TASK, project->project_name);
+    data = access(fichier, R_OK) ? NULL : csv_read_file(fichier, ';');
+    free(fichier);
+
+    if(data == NULL) {
+        return;
+    }
+
+    last = get_last_commits(data, "date", NB_BISECTIONS);
+
+    elementsCherches[0] = "date";
+    elementsCherches[1] = "first bad";
+    elementsCherches[2] = "author";
+    elementsCherches[3] = "commentaries";
+    elementsCherches[4] = "tested";
+    data_s = csv_select_columns(last, elementsCherches, 5, &nb);
+    csv_truncate_column(data_s, elementsCherches[1], 12);
+
+    html_stream_title_with_hr(page, 2, "Commits which broke the tests");
+    html_stream_table_from_data(page, data_s);
+
+    csv_destroy_table(data_s);
+    csv_destroy_table(last);
+    csv_destroy_table(data);
+}
+
+
+/**
+ * \brief Add to a table of commits the state of their tests, if it is
+ * known for some of them.
+ * \param commits the commits, with their short hash in the column "#"
+ * \param project the project definition
+ * \param yannkinsRep the directory where Yannkins is installed
+ * \return a new table with a column "tests", or NULL if no state is known
+ */
+static csv_table_t *add_commit_tests(csv_table_t *commits, yk_project *project, char *yannkinsRep) {
+
+    char *fichier;
+    csv_table_t *states;
+    csv_table_t *result;
+    csv_line_t *line;
+    char **headers;
+    char **values;
+    int hashColumn;
+    int i;
+
+    fichier = malloc(sizeof(char) * (strlen(yannkinsRep) + strlen(COMMIT_TESTS) + strlen(project->project_name) + 7));
+    sprintf(fichier, "%s/log/%s_%s", yannkinsRep, COMMIT_TESTS, project->project_name);
+    states = access(fichier, R_OK) ? NULL : csv_read_file(fichier, ';');
+    free(fichier);
+
+    if(states == NULL) {
+        return NULL;
+    }
+
+    for(hashColumn = 0; hashColumn < commits->nbCol && strcmp(commits->headers[hashColumn], "#"); hashColumn++);
+
+    headers = malloc((commits->nbCol + 1) * sizeof(char *));
+    values = malloc((commits->nbCol + 1) * sizeof(char *));
+    for(i = 0; i < commits->nbCol; i++) {
+        headers[i] = commits->headers[i];
+    }
+    headers[commits->nbCol] = "tests";
+    result = csv_create_table(headers, commits->nbCol + 1);
+
+    for(line = commits->lines; line != NULL; line = line->next) {
+
+        csv_line_t *state;
+
+        for(i = 0; i < commits->nbCol; i++) {
+            values[i] = line->values[i];
+        }
+        values[commits->nbCol] = "";
+
+        // the full hash begins with the short one, the last state is the good one
+        if(hashColumn < commits->nbCol && line->values[hashColumn] != NULL && line->values[hashColumn][0] != '\0') {
+            for(state = states->lines; state != NULL; state = state->next) {
+                if(state->values[0] != NULL && state->values[1] != NULL
+                        && !strncmp(state->values[0], line->values[hashColumn], strlen(line->values[hashColumn]))) {
+                    values[commits->nbCol] = state->values[1];
+                }
+            }
+        }
+
+        csv_add_line(result, values, commits->nbCol + 1);
+    }
+
+    free(headers);
+    free(values);
+    csv_destroy_table(states);
+    return result;
+}
+
+
+/**
+ * Write the HTML report page of a project.
+ * \param project the project definition
+ * \param yannkinsRep the directory where Yannkins is installed
+ * \param template the skeleton of the page
+ * \return an error code. Can be ERR_OPEN_FILE if an error occured while opening the file with write flag.
+ */
+static int write_yannkins_html(yk_project *project, char *yannkinsRep, const htmlTemplate *template){
+
+    yannkins_line_t **lines = init_lines(project, yannkinsRep);
+
+    char *fichier = NULL; // name of svn logs file
+    char *wwwdir; // directory where put the html outputs
+    char *filename; // name of the html file to create (without path)
+    char *report; // name of the html file to create (with path)
+    csv_table_t *data = NULL; // svn logs data
+    csv_table_t *data_s; // filtrated svn logs
+    char *elementsCherches[4];
+    int nb; // number of OK columns for svn logs
+    htmlStream *page;
+    char *content;
+    char *values[2];
+    size_t lengths[2];
+
+    page = html_stream_create();
+
+    content = malloc(sizeof(char) * (strlen(project->project_name) + 9));
+    sprintf(content, "Project %s", project->project_name);
+    html_stream_title(page, 1, content);
+    free(content);
+
+    html_stream_title_with_hr(page, 2, "Results of last analysis");
+
+    write_yannkins_table(page, lines);
+    write_bisections(page, project, yannkinsRep);
+
+    // freeing memory
+    if(lines != NULL){
+        int i = 0;
+        while(lines[i]!=NULL){
+            if(lines[i]->name!=NULL){
+                free(lines[i]->name);
+            }
+            if(lines[i]->console_file!=NULL) {
+                free(lines[i]->console_file);
+            }
+            free(lines[i]);
+            i++;
+        }
+        free(lines);
+    }
+
+    // logs' table
+    if(project->versioning_type == SVN) {
+        fichier=malloc(sizeof(char)*(strlen(yannkinsRep)+strlen(SVNLOG)+strlen(project->project_name)+7));
+        sprintf(fichier, "%s/log/%s_%s", yannkinsRep, SVNLOG, project->project_name);
+    } else if(project->versioning_type == GIT) {
+        fichier=malloc(sizeof(char)*(strlen(yannkinsRep)+strlen(GITLOG)+strlen(project->project_name)+7));
+        sprintf(fichier, "%s/log/%s_%s", yannkinsRep, GITLOG, project->project_name);
+    }
+
+    if(fichier != NULL) {
+        data=csv_read_file(fichier, ';');
+    }
+
+    if(data!=NULL) {
+        char subtitle[500];
+        csv_table_t *last; // the most recent commits
+        csv_table_t *months; // number of commits by month
+        csv_table_t *tested; // the commits with the state of their tests
+
+        last = get_last_commits(data, "date", NB_COMMITS);
+
+        elementsCherches[0]="#";
+        elementsCherches[1]="author";
+        elementsCherches[2]="date";
+        elementsCherches[3]="commentaries";
+        data_s=csv_select_columns(last, elementsCherches, 4, &nb);
+        csv_truncate_column(data_s, elementsCherches[2], 20);
+
+        sprintf(subtitle, "Last %d commits (by %d authors)", last->nbLig, get_authors_number(last));
+        html_stream_title_with_hr(page, 2, subtitle);
+
+        tested = add_commit_tests(data_s, project, yannkinsRep);
+        if(tested != NULL) {
+            html_stream_table_from_data(page, tested);
+            csv_destroy_table(tested);
+        } else {
+            html_stream_table_from_data(page, data_s);
+        }
+
+        // statistics on the whole history
+        months = nb_by_month(data, "date");
+        if(months != NULL) {
+            sprintf(subtitle, "History : %d commits by %d authors", data->nbLig, get_authors_number(data));
+            html_stream_title_with_hr(page, 2, subtitle);
+            html_stream_table_from_data(page, months);
+            csv_destroy_table(months);
+        }
+
+        csv_destroy_table(data_s);
+        csv_destroy_table(last);
+        csv_destroy_table(data);
+    }
+    free(fichier);
+
+    // write file
+    wwwdir = concat_path(yannkinsRep, "www");
+    if(wwwdir == NULL) {
+        html_stream_destroy(page);
+        return ERR_MEMORY;
+    }
+
+    filename=malloc(sizeof(char)*(strlen(project->project_name)+6));
+    sprintf(filename, "%s.html", project->project_name);
+
+    report = concat_path(wwwdir, filename);
+    free(wwwdir);
+    free(filename);
+
+    if(report == NULL) {
+        html_stream_destroy(page);
+        return ERR_MEMORY;
+    }
+
+    values[TITLE_SLOT] = TITLE;
+    lengths[TITLE_SLOT] = strlen(TITLE);
+    values[BODY_SLOT] = (char *) html_stream_content(page, &lengths[BODY_SLOT]);
+
+    if(html_template_write_to_file(template, values, lengths, report)) {
+        log_error("Can't write file %s", report);
+        html_stream_destroy(page);
+        free(report);
+        return ERR_OPEN_FILE;
+    }
+    html_stream_destroy(page);
+    free(report);
+
+    return ERR_OK;
+}
+
+
+/**
+ * \brief Add the name of a file in a list.
+ * \param list the list, reallocated
+ * \param nb the number of names in the list, incremented
+ * \param format the name's format, followed by its parameters
+ */
+static void add_input(char ***list, int *nb, const char *format, ...) {
+
+    va_list ap;
+    char *name;
+    int length;
+
+    va_start(ap, format);
+    length = vsnprintf(NULL, 0, format, ap);
+    va_end(ap);
+
+    name = malloc(length + 1);
+    va_start(ap, format);
+    vsnprintf(name, length + 1, format, ap);
+    va_end(ap);
+
+    *list = realloc(*list, (*nb + 1) * sizeof(char *));
+    (*list)[(*nb)++] = name;
+}
+
+
+/**
+ * \brief List the files read to create the page of a project.
+ * \param project the project definition
+ * \param definition the name of the project's file in the projects' directory
+ * \param template the skeleton of the page
+ * \param nb where to put the number of files
+ * \return the files, relative to Yannkins' directory, to free
+ */
+static char **page_inputs(yk_project *project, const char *definition, const htmlTemplate *template, int *nb) {
+
+    char **inputs = NULL;
+    char **includes;
+    char *name = project->project_name;
+    yk_task *task;
+    int nbIncludes;
+    int i;
+
+    *nb = 0;
+    add_input(&inputs, nb, "%s/%s", PROJECTS_DIR, definition);
+    add_input(&inputs, nb, "%s", TEMPLATE_FILE);
+    includes = html_template_includes(template, &nbIncludes);
+    for(i = 0; i < nbIncludes; i++) {
+        add_input(&inputs, nb, "%s/%s", WWW_DIR, includes[i]);
+    }
+    add_input(&inputs, nb, "log/%s_%s", REPOS_TASK, name);
+    add_input(&inputs, nb, "log/%s_%s", COMPILATION_TASK, name);
+    add_input(&inputs, nb, "log/%s_%s", TESTS_TASK, name);
+    for(task = project->tasks; task != NULL; task = task->next) {
+        if(task->command != NULL) {
+            add_input(&inputs, nb, "log/%s_%s", task->name, name);
+        }
+    }
+    add_input(&inputs, nb, "log/%s_%s", BISECT_TASK, name);
+    add_input(&inputs, nb, "log/%s_%s", COMMIT_TESTS, name);
+    if(project->versioning_type == SVN) {
+        add_input(&inputs, nb, "log/%s_%s", SVNLOG, name);
+    } else if(project->versioning_type == GIT) {
+        add_input(&inputs, nb, "log/%s_%s", GITLOG, name);
+    }
+
+    return inputs;
+}
+
+
+/**
+ * \brief A project's page to create.
+ */
+typedef struct {
+    yk_project *project; /**< \brief the project definition */
+    char *definition; /**< \brief name of the project's file in the projects' directory */
+    yk_page_state *state; /**< \brief the state of the page's inputs, NULL if the page couldn't be written */
+    int selected; /**< \brief 1 if the page is created again when its inputs changed, 0 to leave it as it is */
+    int written; /**< \brief 1 if the page was created again */
+} yk_page;
+
+
+/**
+ * \brief The pages shared by the threads creating them.
+ */
+typedef struct {
+    yk_page *pages; /**< \brief the pages, by project name */
+    int nbPages; /**< \brief number of pages */
+    int next; /**< \brief the next page to take */
+    pthread_mutex_t mutex; /**< \brief protects next */
+    const yk_manifest *previous; /**< \brief the inputs of the pages when they were created */
+    char *yannkinsDir; /**< \brief Yannkins' working directory */
+    int full; /**< \brief 1 to create all the pages again */
+    const htmlTemplate *template; /**< \brief skeleton of the pages */
+} yk_page_queue;
+
+
+/**
+ * Create the page of a project if its inputs changed.
+ * \param page the page, its state is set
+ * \param queue the pages
+ */
+static void create_page(yk_page *page, yk_page_queue *queue) {
+
+    char *project = page->project->project_name;
+    char **inputs;
+    char *html_file;
+    int nbInputs;
+    int changed;
+    int i;
+
+    inputs = page_inputs(page->project, page->definition, queue->template, &nbInputs);
+    page->state = manifest_check(queue->previous, project, queue->yannkinsDir, inputs, nbInputs, &changed);
+    for(i = 0; i < nbInputs; i++) {
+        free(inputs[i]);
+    }
+    free(inputs);
+
+    // a removed page is created again
+    html_file = malloc(strlen(queue->yannkinsDir) + strlen(project) + 11);
+    sprintf(html_file, "%s/www/%s.html", queue->yannkinsDir, project);
+    changed = changed || queue->full || access(html_file, F_OK);
+    free(html_file);
+
+    if(changed) {
+        log_info("Treatment of project %s.", project);
+        if(write_yannkins_html(page->project, queue->yannkinsDir, queue->template)) {
+            // not in the manifest : it will be created again
+            manifest_destroy_state(page->state);
+            page->state = NULL;
+        }
+        page->written = 1;
+    } else {
+        log_debug("Page of project %s is up to date", project);
+    }
+}
+
+
+/**
+ * Create the pages until there is none left. Run by each thread.
+ * \param data the yk_page_queue
+ * \return NULL
+ */
+static void *create_pages(void *data) {
+
+    yk_page_queue *queue = data;
+
+    for(;;) {
+        int i;
+
+        pthread_mutex_lock(&queue->mutex);
+        i = queue->next;
+        if(i < queue->nbPages) {
+            queue->next++;
+        }
+        pthread_mutex_unlock(&queue->mutex);
+
+        if(i >= queue->nbPages) {
+            return NULL;
+        }
+        if(queue->pages[i].selected) {
+            create_page(&queue->pages[i], queue);
+        }
+    }
+}
+
+
+/**
+ * Order the pages by project name, then by file.
+ */
+static int compare_pages(const void *a, const void *b) {
+
+    const yk_page *page1 = a;
+    const yk_page *page2 = b;
+    int cmp = strcmp(page1->project->project_name, page2->project->project_name);
+
+    return cmp ? cmp : strcmp(page1->definition, page2->definition);
+}
+
+
+/**
+ * Compile the skeleton of the pages, the default one if the file
+ * www/page.tpl is missing or wrong.
+ * \param yannkinsDir Yannkins' working directory
+ * \return the template
+ */
+static htmlTemplate *read_template(char *yannkinsDir) {
+
+    char *slots[2];
+    char *filename;
+    char *wwwdir;
+    htmlTemplate *template;
+
+    slots[TITLE_SLOT] = "TITLE";
+    slots[BODY_SLOT] = "BODY";
+
+    filename = concat_path(yannkinsDir, TEMPLATE_FILE);
+    template = html_template_read(filename, slots, 2);
+    if(template == NULL) {
+        log_warning("Can't use template %s, using the default one", filename);
+        wwwdir = concat_path(yannkinsDir, WWW_DIR);
+        template = html_template_create(DEFAULT_TEMPLATE, wwwdir, slots, 2);
+        free(wwwdir);
+    }
+    free(filename);
+
+    return template;
+}
+
+
+/**
+ * Look if a project is in a list.
+ * \param project the project's name
+ * \param projects the list, NULL for all the projects
+ * \param nbProjects the number of projects of the list
+ * \return 1 if the project is in the list
+ */
+static int is_selected(const char *project, char **projects, int nbProjects) {
+
+    int i;
+
+    if(projects == NULL) {
+        return 1;
+    }
+    for(i = 0; i < nbProjects; i++) {
+        if(!strcmp(projects[i], project)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * Create the pages of some projects, if their inputs changed, and the index.
+ * \param yannkinsDir Yannkins' working directory
+ * \param projects the names of the projects whose page may be created again, NULL for all
+ * \param nbProjects number of projects of the list
+ * \param full 1 to create these pages even if their inputs didn't change
+ * \param nbThreads number of pages created at the same time
+ * \return 0 in case of success
+ */
+static int write_report(char *yannkinsDir, char **projects, int nbProjects, int full, int nbThreads){
+
+    char projects_dir[1000];
+    struct dirent *lecture; // an entry of projects' directory
+    DIR *rep; //directory to cross
+    char *htmlFile; // index.html file
+    htmlStream *page;
+    htmlTemplate *template;
+    char *values[2];
+    size_t lengths[2];
+    char *manifestFile;
+    yk_manifest *previous;
+    yk_manifest *current;
+    yk_page_queue queue;
+    pthread_t *threads;
+    int nbSelected = 0;
+    int nbStarted = 0;
+    int nbWritten = 0;
+    int allocated = 0;
+    int i;
+
+
+    sprintf(projects_dir, "%s/%s", yannkinsDir, PROJECTS_DIR);
+
+    rep = opendir(projects_dir);
+    if(rep == NULL) {
+        log_error("Can't open directory %s", projects_dir);
+        return 1;
+    }
+
+    queue.pages = NULL;
+    queue.nbPages = 0;
+
+    while ((lecture = readdir(rep))) {
+
+        if(lecture->d_type==DT_REG && yk_is_project_file(lecture->d_name)){
+
+            char *project_def = malloc( (strlen(projects_dir)+strlen(lecture->d_name)+2) * sizeof(char) );
+            yk_project *project_struct;
+
+            sprintf(project_def, "%s/%s", projects_dir, lecture->d_name);
+            project_struct = yk_read_project_file(project_def);
+            free(project_def);
+
+            if(project_struct == NULL || project_struct->project_name == NULL) {
+                yk_destroy_project(project_struct);
+                continue;
+            }
+
+            if(queue.nbPages == allocated) {
+                allocated = allocated ? 2 * allocated : 16;
+                queue.pages = realloc(queue.pages, allocated * sizeof(yk_page));
+            }
+            queue.pages[queue.nbPages].project = project_struct;
+            queue.pages[queue.nbPages].definition = strdup(lecture->d_name);
+            queue.pages[queue.nbPages].state = NULL;
+            queue.pages[queue.nbPages].selected = is_selected(project_struct->project_name, projects, nbProjects);
+            queue.pages[queue.nbPages].written = 0;
+            nbSelected += queue.pages[queue.nbPages].selected;
+            queue.nbPages++;
+        }
+    }
+    closedir(rep);
+
+    // the order of the directory's entries is not the same everywhere
+    if(queue.nbPages > 0) {
+        qsort(queue.pages, queue.nbPages, sizeof(yk_page), compare_pages);
+    }
+
+    manifestFile = concat_path(yannkinsDir, MANIFEST_FILE);
+    previous = manifest_read(manifestFile, REPORT_FORMAT_VERSION);
+
+    queue.next = 0;
+    queue.previous = previous;
+    queue.yannkinsDir = yannkinsDir;
+    queue.full = full;
+    queue.template = template = read_template(yannkinsDir);
+    pthread_mutex_init(&queue.mutex, NULL);
+
+    // this thread creates pages too
+    if(nbThreads > nbSelected) {
+        nbThreads = nbSelected;
+    }
+    threads = malloc((nbThreads > 1 ? nbThreads - 1 : 1) * sizeof(pthread_t));
+    for(i = 0; i < nbThreads - 1; i++) {
+        if(pthread_create(&threads[nbStarted], NULL, create_pages, &queue)) {
+            log_warning("Can't start a thread, creating the pages with %d thread(s)", nbStarted + 1);
+            break;
+        }
+        nbStarted++;
+    }
+    create_pages(&queue);
+    for(i = 0; i < nbStarted; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&queue.mutex);
+
+    // the index and the manifest, in the order of the projects
+    page = html_stream_create();
+    html_stream_title(page, 1, "Projects list");
+    html_stream_open(page, "ul");
+
+    current = manifest_read("", REPORT_FORMAT_VERSION);
+    for(i = 0; i < queue.nbPages; i++) {
+
+        yk_page *projectPage = &queue.pages[i];
+        char *project = projectPage->project->project_name;
+        char *project_file;
+
+        // the other pages keep their inputs
+        if(!projectPage->selected) {
+            projectPage->state = manifest_take(previous, project);
+        }
+        if(projectPage->state != NULL) {
+            manifest_add(current, projectPage->state);
+        }
+        nbWritten += projectPage->written;
+
+        project_file=malloc(sizeof(char)*(strlen(project)+6));
+        sprintf(project_file, "%s.html", project);
+        html_stream_open(page, "li");
+        html_stream_link(page, project, project_file);
+        html_stream_close(page);
+        free(project_file);
+
+        free(projectPage->definition);
+        yk_destroy_project(projectPage->project);
+    }
+    free(queue.pages);
+    html_stream_close(page);
+
+    log_info("%d page(s) created, %d up to date", nbWritten, nbSelected - nbWritten);
+    manifest_write(current, manifestFile);
+    manifest_destroy(current);
+    manifest_destroy(previous);
+    free(manifestFile);
+
+
+    // write file
+
+    htmlFile=concat_path(yannkinsDir, HTML_FILE);
+
+    if(htmlFile==NULL){
+        log_error("Can't allocate memory");
+        html_stream_destroy(page);
+        html_template_destroy(template);
+        return ERR_MEMORY;
+    }
+
+    values[TITLE_SLOT] = TITLE;
+    lengths[TITLE_SLOT] = strlen(TITLE);
+    values[BODY_SLOT] = (char *) html_stream_content(page, &lengths[BODY_SLOT]);
+    html_template_write_to_file(template, values, lengths, htmlFile);
+    free(htmlFile);
+    html_stream_destroy(page);
+    html_template_destroy(template);
+
+    return 0;
+}
+
+
+int report_write(char *yannkinsDir, int full, int nbThreads) {
+    return write_report(yannkinsDir, NULL, 0, full, nbThreads);
+}
+
+
+int report_update(char *yannkinsDir, char **projects, int nbProjects, int full, int nbThreads) {
+    return write_report(yannkinsDir, projects, nbProjects, full, nbThreads);
+}
@@ -0,0 +1,51 @@
+/**
+ * \file report.h
+ * \brief Create the HTML pages.
+ */
+
+#ifndef YK_REPORT_H
+#define YK_REPORT_H 1
+
+// SUFFIXES FOR DIFFERENT TYPES OF TASK
+/** \brief svn checkout tag */
+#define REPOS_TASK "SVN_CHECKOUT"
+/** \brief compilation tag */
+#define COMPILATION_TASK "COMPILATION"
+/** \brief success of tests tag */
+#define TESTS_TASK "TESTS"
+/** \brief svn logs tag */
+#define SVNLOG "SVNLOG"
+/** \brief git logs tag */
+#define GITLOG "GITLOG"
+/** \brief bisections of the tests' failures tag */
+#define BISECT_TASK "BISECT"
+/** \brief tests' states by commit tag */
+#define COMMIT_TESTS "COMMIT_TESTS"
+
+
+/**
+ * \brief Create the index page with the links to the projects' resumes, sorted by name,
+ * and one page by project, from the results of the tasks. The pages are
+ * written in ${yannkinsDir}/www. The page of a project is only created
+ * again if the files it is created from changed.
+ * \param yannkinsDir Yannkins' working directory
+ * \param full 1 to create all the pages again
+ * \param nbThreads number of pages created at the same time
+ * \return 0 in case of success
+ */
+int report_write(char *yannkinsDir, int full, int nbThreads);
+
+/**
+ * \brief Create the pages of some projects, if the files they are created
+ * from changed, and the index. The pages of the other projects are left as
+ * they are.
+ * \param yannkinsDir Yannkins' working directory
+ * \param projects the names of the projects
+ * \param nbProjects number of projects
+ * \param full 1 to create the pages of these projects again anyway
+ * \param nbThreads number of pages created at the same time
+ * \return 0 in case of success
+ */
+int report_update(char *yannkinsDir, char **projects, int nbProjects, int full, int nbThreads);
+
+#endif
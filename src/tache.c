@@ -5,12 +5,57 @@
  *
  * You need put in parameters the name of the task and the command.
  * One line will be added in the log file ${LOGDIR}/${TASK} :
- *     ${date};FAIL (in case of failure)
- *     ${date};OK   (in case of success)
+ *     ${date};FAIL;${usage} (in case of failure)
+ *     ${date};OK;${usage}   (in case of success)
+ * where ${usage} are the resources used by the task : wall clock
+ * duration, user and system CPU time (in seconds), peak resident memory
+ * (in kB), and the number of blocks read and written.
+ * If the task exceeds its wall clock or CPU time limit, its process group
+ * is killed and the result is TIMEOUT.
+ * The last columns are the revision of the working copy and a hash of the
+ * command. If they are the same as for the last execution, the task is
+ * not run again and its result is "SKIPPED (up to date)".
  * The file ${LOGDIR}/${TASK}_console will content the last console
- * output.
+ * output. In capture mode, only the beginning and the end of a long
+ * output are kept, and the file may be compressed in
+ * ${LOGDIR}/${TASK}_console.gz.
+ *
+ * In batch mode ("--batch <jobfile>"), the tasks are read from a file
+ * and run by a pool of workers ("-j N"). Each line of the jobfile is :
+ *     ${CHAIN};${TASK};${WORKING_DIR};${OPTIONS};${COMMAND}
+ * where ${OPTIONS} is a comma separated list of "key=value", may be empty :
+ *     timeout=${SECONDS}   wall clock limit of the task
+ *     cpu=${SECONDS}       CPU time limit of the task
+ *     head=${SIZE}         bytes kept at the beginning of the console output
+ *     tail=${SIZE}         bytes kept at the end of the console output
+ *     compress=1           compress the console output with gzip
+ *     vcs=${git|svn}       skip the task if the revision of the working
+ *                          directory and the command have not changed
+ *     after=${TASKS}       space separated list of tasks of the same chain
+ *                          which must be ended before this one starts
+ *     depends=${TASKS}     tasks of the same chain which must succeed
+ *                          before this one starts
+ *     pool=${POOL}         resource pool of the task : fetch, build (the
+ *                          default) or test
+ * The jobs of a same chain (usually a project) without "after" nor
+ * "depends" option are executed in the order of the file, one after the
+ * other. Jobs declaring their dependencies are started as soon as these
+ * are ended. If a dependency fails, the job is not run and its result is
+ * "SKIPPED (dependency failed)". Different chains are run in parallel.
+ * Each pool has its own number of workers ("--pools fetch=4,test=2", 0
+ * for "-j N") ; the tasks of the build and test pools are also limited
+ * to "-j N" together, the fetch tasks are not.
+ *
+ * The tasks share a GNU make jobserver of "-m N" tokens, given to the
+ * commands through MAKEFLAGS. A task needs a token to start, and its
+ * "make" commands get the other ones for their parallel jobs.
+ *
+ * With "--agents ADDRESS", the agents ("yannkins-agent ADDRESS") connected
+ * to this Unix socket or "[HOST]:PORT" run the tasks of the build and
+ * test pools which would wait for a local worker.
  */
 
+
 #define IC "Yannkins"
 
 
@@ -20,260 +65,320 @@
  */
 #define YANNKINS_DIR "/var/yannkins"
 
-/** \brief where are created output files */
-#define LOG_DIR "log"
-
-#include <time.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <sys/wait.h>
 #include <stdio.h>
-#include <stdlib.h> //system()
+#include <stdlib.h>
 #include <unistd.h>
-#include <fcntl.h>
-#include <errno.h>
 #include <string.h>
+#include <getopt.h>
 #include "logger.h"
+#include "capture.h"
+#include "jobs.h"
+#include "agents.h"
+
+/** \brief max length of a line in a jobfile */
+#define JOB_LINE_SIZE 4096
+
 
 static void usage(char *prog) {
     fprintf(stderr, "Execute a %s task\n", IC);
-    fprintf(stderr, "Usage : %s <TASK_NAME> <COMMAND>\n", prog);
+    fprintf(stderr, "Usage : %s [OPTIONS] <TASK_NAME> <COMMAND>\n", prog);
+    fprintf(stderr, "        %s [OPTIONS] [-j <JOBS>] --batch <JOBFILE>\n", prog);
+    fprintf(stderr, "  -t, --timeout    wall clock limit of a task\n");
+    fprintf(stderr, "  -c, --cpu-limit  CPU time limit of a task\n");
+    fprintf(stderr, "  -j, --jobs       number of tasks executed at the same time\n");
+    fprintf(stderr, "  -m, --make-jobs  tokens of the make jobserver shared by the tasks, 0 for none\n");
+    fprintf(stderr, "  --memory <SIZE>  memory for the expected peaks of the running tasks\n");
+    fprintf(stderr, "  --pools <POOLS>  tasks executed at the same time by pool, like fetch=4,build=2,test=2\n");
+    fprintf(stderr, "  --head <SIZE>    bytes kept at the beginning of the console output\n");
+    fprintf(stderr, "  --tail <SIZE>    bytes kept at the end of the console output\n");
+    fprintf(stderr, "  -z, --compress   compress the console output\n");
+    fprintf(stderr, "  -f, --force      run the tasks even if their revision did not change\n");
+    fprintf(stderr, "  --agents <ADDR>  send the tasks waiting for a worker to the agents connected on this address\n");
+    fprintf(stderr, "  --agents-secret <FILE>  file whose first line the agents must give, required on TCP\n");
     exit(1);
 }
 
-static char stringDate[50];
-
 /**
- * Format a timestamp in a readable format (%d/%m/%Y %H:%M).
- * \date a timestamp
- * \return a char string representing the date. This is a pointer to a
- *         statically allocated memory zone : don't free it.
- */
-static char *printDate(time_t date) {
-    struct tm *sdate = localtime(&date);
-    // %d/%m/%Y %H:%M
-    sprintf(stringDate, "%02d/%02d/%04d %02d:%02d", sdate->tm_mday, sdate->tm_mon+1, sdate->tm_year+1900,
-            sdate->tm_hour, sdate->tm_min);
-    return stringDate;
-}
-
-/**
- * Save the task's result in the appropriate file.
+ * Read the options of a job.
  *
- * \param date the execution date
- * \param resultat task's return value (0==success)
- * \param tache the task's name
- * \param logdir directory where the logs are saved
- * \return 0 if the result was saved
+ * \param job the job to modify
+ * \param options comma separated list of "key=value"
+ * \return 0 if all the options were understood
  */
-static int save_result(time_t date, int resultat, const char *tache, char *logdir){
-
-    char *stringResult;
-    char *ficlog;
-    FILE *flog = NULL;
-
-    if(!resultat) {
-        stringResult = "OK";
-    } else {
-        stringResult = "FAIL";
-    }
-
-    ficlog = malloc(sizeof(char) * (strlen(logdir) + strlen(tache) + 2));
-    if(ficlog == NULL) {
-        log_error("Task %s could not allocate memory. Task's result won't be saved.", tache);
-        return 1;
-    }
-
-    sprintf(ficlog, "%s/%s", logdir, tache);
-    flog = fopen(ficlog, "a");
-    free(ficlog);
-    if(flog == NULL) {
-        log_error("Task %s could not create or modify the file %s. Task's result won't be saved.", tache, ficlog);
-        return 2;
-    }
-
-    fseek(flog, 0, SEEK_END);
-    if(!ftell(flog)) {
-        fprintf(flog, "date;result\n");
-    }
+static int read_job_options(yk_job *job, char *options) {
 
-    fprintf(flog, "%s;%s\n", printDate(date), stringResult);
-    fclose(flog);
-    return 0;
-}
+    char *option;
+    char *saveptr;
+    int err = 0;
 
+    for(option = strtok_r(options, ",", &saveptr); option != NULL; option = strtok_r(NULL, ",", &saveptr)) {
 
-/**
- * Run the "system" function to execute a command redirecting output in
- * a file.
- *
- * \param logfile the file to use for the command's output
- * \param command the command to execute in a shell
- * \return the exit status of the command
- */
-static int exec_command(char *logfile, const char *command) {
-
-    remove(logfile);
+        char *value = strchr(option, '=');
 
-    close(1);
-    if(open(logfile, O_WRONLY|O_CREAT|O_APPEND, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH) == -1) {
-        log_error("fail to write output on %s", logfile);
-    } else {
-        close(2);
-        dup2(1, 2);
+        if(value == NULL) {
+            err = 1;
+            continue;
+        }
+        *value = '\0';
+        value++;
+
+        if(!strcmp(option, "timeout")) {
+            job->timeout = atoi(value);
+        } else if(!strcmp(option, "cpu")) {
+            job->cpuLimit = atoi(value);
+        } else if(!strcmp(option, "head")) {
+            job->capture.head = capture_parse_size(value);
+        } else if(!strcmp(option, "tail")) {
+            job->capture.tail = capture_parse_size(value);
+        } else if(!strcmp(option, "compress")) {
+            job->capture.compress = atoi(value);
+        } else if(!strcmp(option, "after")) {
+            free(job->after);
+            job->after = strdup(value);
+        } else if(!strcmp(option, "depends")) {
+            free(job->depends);
+            job->depends = strdup(value);
+        } else if(!strcmp(option, "pool")) {
+            if(jobs_pool(value) == -1) {
+                err = 1;
+            } else {
+                job->pool = jobs_pool(value);
+            }
+        } else if(!strcmp(option, "vcs")) {
+            if(!strcmp(value, "git")) {
+                job->vcs = GIT;
+            } else if(!strcmp(value, "svn")) {
+                job->vcs = SVN;
+            } else {
+                err = 1;
+            }
+        } else {
+            err = 1;
+        }
     }
 
-    return system(command)/256;
+    return err;
 }
 
 
 /**
- * Run the "system" function to execute a command redirecting output in
- * a file. The run is done in a forked process to not lose the standard
- * outputs.
+ * Read a jobfile. Each line is "CHAIN;TASK;WORKING_DIR;OPTIONS;COMMAND".
+ * The command is the end of the line and may contain ';'. Empty lines and
+ * lines beginning with '#' are ignored.
  *
- * \param tache task's name
- * \param commande the command to execute in a shell
- * \param logdir directory of the ouptut files
- * \param resultat to store the return value of the command
- * \return 0 is the run was done
+ * \param filename the jobfile
+ * \param chains where to put the read chains
+ * \param defaults the job from which the default limits are copied
+ * \return 0 if the file was read
  */
-static int run_task(const char *tache, const char *commande, char *logdir, int *resultat) {
+static int read_jobfile(char *filename, yk_chain **chains, const yk_job *defaults) {
 
-    int err;
-    char *ficconsole;
-    FILE *fconsole = NULL;
-    pid_t pid;
+    FILE *fd;
+    char line[JOB_LINE_SIZE];
+    int numLine = 0;
 
-    ficconsole = malloc(sizeof(char) * (strlen(logdir) + strlen(tache) + 10));
-    if(ficconsole == NULL) {
-        log_error("Task %s could not allocate memory. Task aborted.", tache);
+    fd = fopen(filename, "r");
+    if(fd == NULL) {
+        log_error("Can't open jobfile %s", filename);
         return 1;
     }
 
-    sprintf(ficconsole, "%s/%s_console", logdir, tache);
-    fconsole = fopen(ficconsole, "w");
-    if(fconsole == NULL) {
-        log_error("Task %s could not create or modify the file %s. Task aborted", tache, ficconsole);
-        return 2;
-    }
-    fclose(fconsole);
-
-    pid = fork();
-    if(pid == -1) {
-        log_error("Fork failure : command \"%s\" not runned", commande);
-        return 1;
-    }
+    while(fgets(line, JOB_LINE_SIZE, fd) != NULL) {
 
-    if(pid == 0) {
-        int err = exec_command(ficconsole, commande);
-        free(ficconsole);
-        log_debug("forked process exits with status %d", err);
-        exit(err);
-    } else {
-        int wstatus;
-        waitpid(pid, &wstatus, 0);
-        if (!WIFEXITED(wstatus)) {
-            *resultat = 1;
-        } else {
-            *resultat = WEXITSTATUS(wstatus);
-            log_debug("parent process get status %d", *resultat);
-        }
-    }
+        char *fields[5];
+        int i;
+        yk_job *job;
 
-    free(ficconsole);
-    return 0;
-}
+        numLine++;
+        line[strcspn(line, "\r\n")] = '\0';
 
-
-/**
- * \return 0 in case of success
- */
-static int create_directory(char *dirname) {
-
-    struct stat buf;
-    int err = mkdir(dirname, 0750);
-
-    if(err == -1) {
-
-        if(errno != EEXIST) {
-            log_error("Could not create the directory %s. Exiting", dirname);
-            return err;
+        if(line[0] == '#' || line[0] == '\0') {
+            continue;
         }
 
-        err = stat(dirname, &buf);
-        if(err) {
-            log_error("Stat failed for file %s. Exiting", dirname);
-            return err;
+        fields[0] = line;
+        for(i = 1; i < 5; i++) {
+            fields[i] = strchr(fields[i-1], ';');
+            if(fields[i] == NULL) {
+                break;
+            }
+            *fields[i] = '\0';
+            fields[i]++;
         }
 
-        if(!S_ISDIR(buf.st_mode)) {
-            log_error("File %s exist but is not a directory. Exiting", dirname);
-            err = -1;
+        if(i < 5 || fields[1][0] == '\0') {
+            log_warning("Jobfile %s, line %d ignored : incorrect job", filename, numLine);
+            continue;
         }
-    }
-
-    return err;
-}
-
 
-static char *get_logdir() {
-
-    char *logdir;
-    char *yannkinsDir = getenv("YANNKINS_HOME");
-
-    if(yannkinsDir == NULL) {
-        // use default
-        yannkinsDir = YANNKINS_DIR;
-    }
-
-    logdir = malloc((strlen(yannkinsDir) + strlen(LOG_DIR) + 2) * sizeof(char));
-
-    if(logdir != NULL) {
-        sprintf(logdir, "%s/%s", yannkinsDir, LOG_DIR);
+        job = jobs_create(fields[1], fields[2], fields[4], defaults);
+        if(read_job_options(job, fields[3])) {
+            log_warning("Jobfile %s, line %d : unknown option ignored", filename, numLine);
+        }
+        jobs_add(chains, fields[0], job);
     }
 
-    return logdir;
+    fclose(fd);
+    return 0;
 }
 
 
 int main(int argc, char **argv) {
 
-    char *tache;
-    char *commande;
-    time_t date;
-    int resultat = 0;
+    char *jobfile = NULL;
+    char *agents = NULL;
+    char *secretFile = NULL;
+    yk_chain *chains = NULL;
+    yk_job defaults;
+    yk_schedule schedule;
     int err = 0;
     char *logdir;
+    char *yannkinsDir;
+    long size;
+    int c;
+    struct option options[] = {
+        { "batch", required_argument, NULL, 'b' },
+        { "jobs", required_argument, NULL, 'j' },
+        { "timeout", required_argument, NULL, 't' },
+        { "cpu-limit", required_argument, NULL, 'c' },
+        { "head", required_argument, NULL, 'H' },
+        { "tail", required_argument, NULL, 'T' },
+        { "compress", no_argument, NULL, 'z' },
+        { "make-jobs", required_argument, NULL, 'm' },
+        { "memory", required_argument, NULL, 'r' },
+        { "pools", required_argument, NULL, 'P' },
+        { "force", no_argument, NULL, 'f' },
+        { "agents", required_argument, NULL, 'A' },
+        { "agents-secret", required_argument, NULL, 'K' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    schedule.nbWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    if(schedule.nbWorkers < 1) {
+        schedule.nbWorkers = 1;
+    }
+    schedule.makeJobs = schedule.nbWorkers;
+    schedule.memory = 0;
+    schedule.pools[POOL_FETCH] = FETCH_WORKERS;
+    schedule.pools[POOL_BUILD] = 0;
+    schedule.pools[POOL_TEST] = 0;
+    schedule.force = 0;
+    schedule.watch = NULL;
+    schedule.ended = NULL;
+    schedule.reaped = NULL;
+    schedule.watchData = NULL;
+    schedule.agents = NULL;
+    defaults.timeout = 0;
+    defaults.cpuLimit = 0;
+    defaults.capture.head = -1;
+    defaults.capture.tail = 0;
+    defaults.capture.compress = 0;
+    defaults.vcs = NONE;
+    defaults.pool = POOL_BUILD;
+
+    while ((c = getopt_long(argc, argv, "+j:t:c:m:zf", options, NULL)) != -1) {
+        switch(c) {
+            case 'b':
+                jobfile = optarg;
+                break;
+            case 'j':
+                schedule.nbWorkers = atoi(optarg);
+                if(schedule.nbWorkers < 1) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'm':
+                schedule.makeJobs = atoi(optarg);
+                break;
+            case 'r':
+                size = capture_parse_size(optarg);
+                if(size < 0) {
+                    usage(argv[0]);
+                }
+                schedule.memory = size / 1024;
+                break;
+            case 'P':
+                if(jobs_parse_pools(schedule.pools, optarg)) {
+                    usage(argv[0]);
+                }
+                break;
+            case 't':
+                defaults.timeout = atoi(optarg);
+                break;
+            case 'c':
+                defaults.cpuLimit = atoi(optarg);
+                break;
+            case 'H':
+                defaults.capture.head = capture_parse_size(optarg);
+                if(defaults.capture.head < 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'T':
+                defaults.capture.tail = capture_parse_size(optarg);
+                if(defaults.capture.tail < 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'z':
+                defaults.capture.compress = 1;
+                break;
+            case 'f':
+                schedule.force = 1;
+                break;
+            case 'A':
+                agents = optarg;
+                break;
+            case 'K':
+                secretFile = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
 
-    if(argc != 3) {
+    if(jobfile == NULL && argc - optind != 2) {
+        usage(argv[0]);
+    }
+    if(jobfile != NULL && argc != optind) {
         usage(argv[0]);
     }
-
-    tache = argv[1];
-    commande = argv[2];
-    date = time(NULL);
 
     init_log(LOG_LEVEL_INFO);
 
-    logdir = get_logdir();
-
-    if(logdir != NULL) {
-        err = create_directory(logdir);
-    } else {
-        err = 1;
+    yannkinsDir = getenv("YANNKINS_HOME");
+    if(yannkinsDir == NULL) {
+        // use default
+        yannkinsDir = YANNKINS_DIR;
     }
 
+    logdir = jobs_logdir(yannkinsDir);
+    err = (logdir == NULL);
+
     if(!err) {
-        err = run_task(tache, commande, logdir, &resultat);
+        if(jobfile != NULL) {
+            err = read_jobfile(jobfile, &chains, &defaults);
+        } else {
+            jobs_add(&chains, argv[optind], jobs_create(argv[optind], NULL, argv[optind+1], &defaults));
+            schedule.nbWorkers = 1;
+        }
+    }
+
+    if(!err && agents != NULL) {
+        char *secret = secretFile != NULL ? agents_read_secret(secretFile) : NULL;
+        schedule.agents = (secretFile == NULL || secret != NULL) ? agents_listen(agents, secret) : NULL;
+        err = (schedule.agents == NULL);
+        free(secret);
     }
 
     if(!err) {
-        err = save_result(date, resultat, tache, logdir);
-    } else {
-        log_error("task %s was not executed", tache);
+        err = jobs_run(chains, &schedule, logdir);
     }
 
+    agents_close(schedule.agents);
+
+    jobs_destroy(chains);
+
     if(logdir != NULL) {
         free(logdir);
     }
@@ -0,0 +1,206 @@
+/**
+ * \file test_agents.c
+ * \brief Unit test of the messages between a scheduler and its agents
+ */
+
+#include "agents.h"
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/** \brief the Unix socket of the scheduler */
+#define SOCKET_FILE "agents.tmp"
+
+/** \brief the secret of the scheduler */
+#define SECRET "s3cret"
+
+
+/**
+ * Add received bytes to a connection.
+ */
+static void receive(yk_channel *channel, const char *bytes) {
+
+    size_t length = strlen(bytes);
+
+    channel->data = realloc(channel->data, channel->length + length);
+    memcpy(channel->data + channel->length, bytes, length);
+    channel->length += length;
+    channel->size = channel->length;
+}
+
+
+/**
+ * Take the next message of a connection and compare it with the expected one.
+ * \param step what is tested
+ * \param maxLength the max length of the data of the message
+ * \param expected the expected return of agents_message()
+ * \param expectedHeader the expected header, or NULL
+ * \param expectedData the expected data, or NULL
+ * \return 0 if the message is as expected
+ */
+static int test_message(const char *step, yk_channel *channel, size_t maxLength, int expected,
+        const char *expectedHeader, const char *expectedData) {
+
+    char header[AGENT_HEADER_SIZE];
+    char *data = NULL;
+    size_t length = 0;
+    int found = agents_message(channel, maxLength, header, &data, &length);
+    int err = found != expected;
+
+    fprintf(stdout, "%s : %d", step, found);
+    if(found == 1) {
+        fprintf(stdout, " \"%s\" %d byte(s)", header, (int) length);
+        err |= expectedHeader == NULL || strcmp(header, expectedHeader);
+        err |= expectedData == NULL || length != strlen(expectedData) || memcmp(data, expectedData, length);
+    }
+    fprintf(stdout, "%s\n", err ? " (unexpected)" : "");
+
+    free(data);
+    return err;
+}
+
+
+/**
+ * Test the reading of the messages of a connection.
+ * \return the number of errors
+ */
+static int test_messages() {
+
+    yk_channel channel = { -1, NULL, 0, 0 };
+    char tooLong[AGENT_HEADER_SIZE + 1];
+    char line[64];
+    int err = 0;
+
+    err += test_message("Nothing received", &channel, DATA_MAX_SIZE, 0, NULL, NULL);
+
+    receive(&channel, "OUT 1 ");
+    err += test_message("Split header", &channel, DATA_MAX_SIZE, 0, NULL, NULL);
+    receive(&channel, "3\nab");
+    err += test_message("Split data", &channel, DATA_MAX_SIZE, 0, NULL, NULL);
+    receive(&channel, "c");
+    err += test_message("Complete message", &channel, DATA_MAX_SIZE, 1, "OUT 1", "abc");
+    err += channel.length != 0;
+
+    receive(&channel, "OUT 1 2\nabEND 1 0 0.1 0 0 100 0 0 0\nOUT 2 0\n");
+    err += test_message("Two messages, first", &channel, DATA_MAX_SIZE, 1, "OUT 1", "ab");
+    err += test_message("Two messages, second", &channel, DATA_MAX_SIZE, 1, "END 1 0 0.1 0 0 100 0 0", "");
+    err += test_message("Two messages, third", &channel, DATA_MAX_SIZE, 1, "OUT 2", "");
+    err += test_message("Two messages, end", &channel, DATA_MAX_SIZE, 0, NULL, NULL);
+
+    channel.length = 0;
+    sprintf(line, "OUT 1 %lu\n", (unsigned long) DATA_MAX_SIZE + 1);
+    receive(&channel, line);
+    err += test_message("Length above DATA_MAX_SIZE", &channel, DATA_MAX_SIZE, -1, NULL, NULL);
+
+    channel.length = 0;
+    receive(&channel, "HELLO 2 0 agent 7\n");
+    err += test_message("Length above the max length", &channel, 6, -1, NULL, NULL);
+
+    channel.length = 0;
+    receive(&channel, "OUT 1 -1\n");
+    err += test_message("Negative length", &channel, DATA_MAX_SIZE, -1, NULL, NULL);
+
+    channel.length = 0;
+    receive(&channel, "CANCEL\n");
+    err += test_message("Header without a length", &channel, DATA_MAX_SIZE, -1, NULL, NULL);
+
+    channel.length = 0;
+    receive(&channel, "OUT 1 \n");
+    err += test_message("Empty length", &channel, DATA_MAX_SIZE, -1, NULL, NULL);
+
+    channel.length = 0;
+    receive(&channel, "OUT 1 2x\n");
+    err += test_message("Length not a number", &channel, DATA_MAX_SIZE, -1, NULL, NULL);
+
+    channel.length = 0;
+    memset(tooLong, 'a', AGENT_HEADER_SIZE);
+    tooLong[AGENT_HEADER_SIZE] = '\0';
+    receive(&channel, tooLong);
+    err += test_message("Header too long", &channel, DATA_MAX_SIZE, -1, NULL, NULL);
+
+    free(channel.data);
+    return err;
+}
+
+
+/**
+ * Called for each ended job : none is started by the tests.
+ */
+static void ended(yk_job *job, int result, const yk_usage *usage, void *data) {
+}
+
+
+/**
+ * Connect an agent, send its first message, and check whether the
+ * scheduler accepts it.
+ * \param step what is tested
+ * \param header the header of the first message
+ * \param secret the data of the first message, the secret
+ * \param expected 1 if the agent must be accepted
+ * \return 0 if the agent is accepted or refused as expected
+ */
+static int test_presentation(const char *step, yk_agents *agents, const char *header, const char *secret,
+        int expected) {
+
+    struct pollfd closed;
+    yk_job job;
+    char byte;
+    int accepted;
+    int fd = agents_connect(SOCKET_FILE);
+
+    if(fd == -1) {
+        return 1;
+    }
+    // on a Unix socket, the message is already received : no need to wait
+    agents_send(fd, header, secret, strlen(secret));
+    agents_wait(agents, -1, 0, ended, NULL);
+
+    memset(&job, 0, sizeof(job));
+    accepted = agents_idle(agents, &job) == 2;
+
+    // a refused agent's connection is closed
+    closed.fd = fd;
+    closed.events = POLLIN;
+    if(!accepted && (poll(&closed, 1, 1000) != 1 || recv(fd, &byte, 1, 0) != 0)) {
+        fprintf(stdout, "The connection of the refused agent is open\n");
+        accepted = 1;
+    }
+
+    fprintf(stdout, "%s : %s\n", step, accepted ? "accepted" : "refused");
+
+    // the scheduler loses the agent
+    close(fd);
+    agents_wait(agents, -1, 0, ended, NULL);
+    return accepted != expected;
+}
+
+
+/** Will return 0 on success */
+int main(int argc, char **argv) {
+
+    yk_agents *agents;
+    int err = 0;
+
+    err += test_messages();
+
+    fprintf(stdout, "Listening on %s\n", SOCKET_FILE);
+    agents = agents_listen(SOCKET_FILE, SECRET);
+    if(agents == NULL) {
+        return 1;
+    }
+
+    err += test_presentation("Right secret", agents, "HELLO 2 0 agent", SECRET, 1);
+    err += test_presentation("Wrong secret", agents, "HELLO 2 0 agent", "s3cres", 0);
+    err += test_presentation("Missing secret", agents, "HELLO 2 0 agent", "", 0);
+    err += test_presentation("Longer secret", agents, "HELLO 2 0 agent", SECRET "!", 0);
+    err += test_presentation("Output before HELLO", agents, "OUT 1", "abc", 0);
+    err += test_presentation("No worker", agents, "HELLO 0 0 agent", SECRET, 0);
+
+    agents_close(agents);
+
+    fprintf(stdout, "Agents tests completed, %d error(s)\n", err);
+    return err != 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * \file test_bisect.c
+ * \brief Unit test of the choice of the commits tested by a bisection
+ */
+
+#include "bisect.h"
+#include <stdio.h>
+
+
+/**
+ * Choose the commits to test and compare them with the expected ones.
+ * \param name what is tested
+ * \param split 1 to split the segments where the tests were fixed too
+ * \param expected the expected indexes, nbExpected of them
+ * \return 0 if the expected commits are chosen
+ */
+static int test_points(const char *name, const int *states, int nb, int nbWorkers, int split,
+        const int *expected, int nbExpected) {
+
+    int points[16];
+    int k = bisect_choose_points(states, nb, nbWorkers, split, points);
+    int err = k != nbExpected;
+    int i;
+
+    fprintf(stdout, "%s :", name);
+    for(i = 0; i < k; i++) {
+        fprintf(stdout, " %d", points[i]);
+        if(i < nbExpected && points[i] != expected[i]) {
+            err = 1;
+        }
+    }
+    fprintf(stdout, "%s\n", err ? " (unexpected)" : "");
+    return err;
+}
+
+
+/** Will return 0 on success */
+int main(int argc, char **argv) {
+
+    int batch[] = { 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0 };
+    int batchPoints[] = { 2, 5, 7 };
+    int twoChanges[] = { 1, -1, -1, -1, 0, -1, -1, -1, 1 };
+    int twoChangesPoints[] = { 1, 2, 6 };
+    int brokenPoints[] = { 1, 2, 3 };
+    int small[] = { 1, -1, 0 };
+    int smallPoints[] = { 1 };
+    int known[] = { 1, -1, 1, -1, 0 };
+    int knownPoints[] = { 3 };
+    int found[] = { 1, 1, 0, 0, 1 };
+    int same[] = { 0, -1, -1, 0 };
+    int fixed[] = { 0, -1, -1, 1 };
+    int fixedPoints[] = { 1, 2 };
+    int err = 0;
+
+    err += test_points("One batch, 3 workers", batch, 11, 3, 1, batchPoints, 3);
+    err += test_points("Two changes, 3 workers", twoChanges, 9, 3, 1, twoChangesPoints, 3);
+    err += test_points("Fewer commits than workers", small, 3, 5, 1, smallPoints, 1);
+    err += test_points("Segment with the same state", known, 5, 1, 1, knownPoints, 1);
+    err += test_points("Changes found", found, 5, 4, 1, NULL, 0);
+    err += test_points("No change", same, 4, 2, 1, NULL, 0);
+
+    // without the split of the batches, only the breakages are looked for
+    err += test_points("Two changes, breakage only", twoChanges, 9, 3, 0, brokenPoints, 3);
+    err += test_points("Fix only", fixed, 4, 2, 0, NULL, 0);
+    err += test_points("Fix only, split", fixed, 4, 2, 1, fixedPoints, 2);
+    err += test_points("Breakage found", found, 5, 4, 0, NULL, 0);
+
+    fprintf(stdout, "Bisection tests completed, %d error(s)\n", err);
+    return err != 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * \file test_capture.c
+ * \brief Unit test of the bounded capture of console outputs
+ */
+
+#include "capture.h"
+#include <stdio.h>
+#include <string.h>
+
+/** \brief output file */
+#define OUTPUT_FILE "capture.tmp"
+
+/** \brief the console output of the tests */
+#define OUTPUT "line1\nline2\nline3\nline4\nline5\n"
+
+/** \brief what is kept of OUTPUT with a head of 6 bytes and a tail of 8 bytes */
+#define BOUNDED "line1\n\n[... 18 bytes (3 lines) elided, output was 30 bytes (5 lines) ...]\nline5\n\nEND\n"
+
+
+/**
+ * Capture OUTPUT by pieces and compare the file with the expected content.
+ * \return 0 if the file is as expected
+ */
+static int test_capture(long head, long tail, size_t piece, const char *expected) {
+
+    yk_capture capture = { head, tail, 0 };
+    yk_console *console = capture_open(OUTPUT_FILE, &capture);
+    const char *output = OUTPUT;
+    size_t length = strlen(output);
+    size_t done;
+    char content[200];
+    FILE *fd;
+
+    fprintf(stdout, "Capture with head %ld, tail %ld, by %d bytes\n", head, tail, (int) piece);
+    if(console == NULL) {
+        return 1;
+    }
+    for(done = 0; done < length; done += piece) {
+        capture_write(console, output + done, done + piece < length ? piece : length - done);
+    }
+    capture_close(console, "END");
+
+    fd = fopen(OUTPUT_FILE, "r");
+    if(fd == NULL) {
+        return 1;
+    }
+    length = fread(content, 1, sizeof(content) - 1, fd);
+    content[length] = '\0';
+    fclose(fd);
+
+    if(strcmp(content, expected)) {
+        fprintf(stdout, "Unexpected capture :\n%s\n", content);
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * Read a size and compare it with the expected one.
+ * \return 0 if the size is as expected
+ */
+static int test_size(const char *value, long expected) {
+
+    long size = capture_parse_size(value);
+
+    fprintf(stdout, "Size \"%s\" -> %ld\n", value, size);
+    return size != expected;
+}
+
+
+/** Will return 0 on success */
+int main(int argc, char **argv) {
+
+    int err = 0;
+
+    // the ring wraps, or is filled by one write
+    err += test_capture(6, 8, 4, BOUNDED);
+    err += test_capture(6, 8, 30, BOUNDED);
+    err += test_capture(6, 8, 1, BOUNDED);
+    // nothing to elide
+    err += test_capture(-1, 8, 7, OUTPUT "\nEND\n");
+    err += test_capture(30, 8, 7, OUTPUT "\nEND\n");
+    // no tail
+    err += test_capture(6, 0, 5, "line1\n\n[... 24 bytes (4 lines) elided, output was 30 bytes (5 lines) ...]\n\nEND\n");
+
+    err += test_size("512", 512);
+    err += test_size("64k", 64 * 1024);
+    err += test_size("10M", 10 * 1024 * 1024);
+    err += test_size("1G", 1024L * 1024 * 1024);
+    err += test_size("", -1);
+    err += test_size("-3", -1);
+    err += test_size("12x", -1);
+    err += test_size("12kb", -1);
+
+    fprintf(stdout, "Capture tests completed, %d error(s)\n", err);
+    return err != 0;
+}
@@ -0,0 +1,447 @@
+/**
+ * \file test_jobs.c
+ * \brief Unit test of the scheduling and of the execution of the jobs
+ */
+
+// the static functions of the scheduler are tested too
+#include "jobs.c"
+#include <dirent.h>
+
+/** \brief the pattern of the temporary directory of the output files */
+#define LOGDIR_TEMPLATE "/tmp/test_jobs.XXXXXX"
+
+/** \brief the file where the jobs write their names when they start */
+#define ORDER_FILE "order"
+
+
+/** \brief directory of the output files of the tests */
+static char logdir[] = LOGDIR_TEMPLATE;
+
+
+/**
+ * Write the result file of a task with previous executions.
+ * \param task the task's name
+ * \param lines the executions, "result;duration;user;system;maxrss" each
+ */
+static void write_history(const char *task, const char **lines, int nbLines) {
+
+    char filename[100];
+    FILE *fd;
+    int i;
+
+    sprintf(filename, "%s/%s", logdir, task);
+    fd = fopen(filename, "w");
+    fprintf(fd, "%s\n", RESULT_HEADER);
+    for(i = 0; i < nbLines; i++) {
+        fprintf(fd, "2020-01-01 00:00:00;%s;0;0;;\n", lines[i]);
+    }
+    fclose(fd);
+}
+
+
+/**
+ * Read the result of the last execution of a task and compare it with the
+ * expected one.
+ * \param task the task's name
+ * \param expected the expected result, like "OK" or "TIMEOUT"
+ * \return 0 if the result is the expected one
+ */
+static int check_result(const char *task, const char *expected) {
+
+    char filename[100];
+    char line[RESULT_LINE_SIZE];
+    char *result = "(none)";
+    FILE *fd;
+
+    sprintf(filename, "%s/%s", logdir, task);
+    fd = fopen(filename, "r");
+    while(fd != NULL && fgets(line, sizeof(line), fd) != NULL);
+    if(fd != NULL) {
+        fclose(fd);
+        // the result is the second field of the last line
+        if(strchr(line, ';') != NULL) {
+            result = strchr(line, ';') + 1;
+            result[strcspn(result, ";\n")] = '\0';
+        }
+    }
+
+    fprintf(stdout, "Result of %s : %s%s\n", task, result, strcmp(result, expected) ? " (unexpected)" : "");
+    return strcmp(result, expected) != 0;
+}
+
+
+/**
+ * Remove the output files of the tests.
+ */
+static void clean_logdir() {
+
+    char filename[300];
+    struct dirent *entry;
+    DIR *dir = opendir(logdir);
+
+    while(dir != NULL && (entry = readdir(dir)) != NULL) {
+        if(entry->d_name[0] != '.') {
+            sprintf(filename, "%s/%s", logdir, entry->d_name);
+            remove(filename);
+        }
+    }
+    if(dir != NULL) {
+        closedir(dir);
+    }
+}
+
+
+/**
+ * Create a job of the build pool.
+ * \param after the tasks it waits for, or NULL
+ * \param depends the tasks which must succeed before it, or NULL
+ * \param expected its expected duration, or -1 to read it
+ * \return the new job
+ */
+static yk_job *create_job(const char *task, const char *command, const char *after, const char *depends,
+        double expected) {
+
+    yk_job defaults;
+    yk_job *job;
+
+    memset(&defaults, 0, sizeof(defaults));
+    defaults.vcs = NONE;
+    defaults.pool = POOL_BUILD;
+    job = jobs_create(task, NULL, command, &defaults);
+    job->after = after != NULL ? strdup(after) : NULL;
+    job->depends = depends != NULL ? strdup(depends) : NULL;
+    job->expected = expected;
+    job->rank = expected;
+    return job;
+}
+
+
+/**
+ * Test the expected durations, peaks of memory and ranks of the jobs.
+ * \return the number of errors
+ */
+static int test_rank() {
+
+    const char *historyA[] = { "OK;2.00;1.00;0.00;100", "FAIL;4.00;1.00;0.00;300" };
+    const char *historyC[] = { "SKIPPED (up to date);;;;", "OK;6.00;1.00;0.00;50", "CANCELLED;;;;" };
+    yk_chain *chains = NULL;
+    yk_job *a, *b, *c;
+    int known;
+    int err = 0;
+
+    write_history("a", historyA, 2);
+    write_history("c", historyC, 3);
+
+    // b after a, c depends on a
+    jobs_add(&chains, "x", a = create_job("a", "true", NULL, NULL, -1));
+    jobs_add(&chains, "x", b = create_job("b", "true", NULL, NULL, -1));
+    jobs_add(&chains, "x", c = create_job("c", "true", NULL, "a", -1));
+
+    fprintf(stdout, "Ranking the jobs\n");
+    known = rank_jobs(chains, logdir);
+    err += known != 2;
+    err += a->expected != 3 || a->expectedRss != 300;
+    err += c->expected != 6 || c->expectedRss != 50;
+    // an unknown task lasts the mean of the known ones
+    err += b->expected != 4.5 || b->expectedRss != 0;
+    err += c->rank != 6 || b->rank != 4.5 || a->rank != 9;
+    fprintf(stdout, "Ranks : a %.1f, b %.1f, c %.1f\n", a->rank, b->rank, c->rank);
+
+    jobs_destroy(chains);
+    clean_logdir();
+    return err;
+}
+
+
+/**
+ * Test the order of the ready jobs : the highest rank first, increased
+ * while they wait.
+ * \return the number of errors
+ */
+static int test_priorities() {
+
+    yk_job *jobs[3];
+    yk_job *sorted[3];
+    int err = 0;
+    int i;
+
+    jobs[0] = create_job("five", "true", NULL, NULL, 5);
+    jobs[1] = create_job("ten", "true", NULL, NULL, 10);
+    jobs[2] = create_job("two", "true", NULL, NULL, 2);
+    jobs[0]->readyDate = 100;
+    jobs[1]->readyDate = 100;
+    // ready for 10 s
+    jobs[2]->readyDate = 90;
+
+    fprintf(stdout, "Sorting the ready jobs :");
+    memcpy(sorted, jobs, sizeof(jobs));
+    agingDate = 100;
+    qsort(sorted, 3, sizeof(yk_job *), compare_priorities);
+    for(i = 0; i < 3; i++) {
+        fprintf(stdout, " %s", sorted[i]->task);
+    }
+    fprintf(stdout, "\n");
+    err += sorted[0] != jobs[2] || sorted[1] != jobs[1] || sorted[2] != jobs[0];
+
+    for(i = 0; i < 3; i++) {
+        destroy_job(jobs[i]);
+    }
+    return err;
+}
+
+
+/**
+ * Test the free workers of the pools, and the memory for a new job.
+ * \return the number of errors
+ */
+static int test_resources() {
+
+    yk_schedule schedule;
+    yk_run run;
+    yk_job *job = create_job("job", "true", NULL, NULL, 1);
+    int none[NB_POOLS] = { 0, 0, 0 };
+    int fetching[NB_POOLS] = { 1, 0, 0 };
+    int building[NB_POOLS] = { 0, 1, 1 };
+    int testing[NB_POOLS] = { 0, 0, 1 };
+    int err = 0;
+
+    memset(&schedule, 0, sizeof(schedule));
+    schedule.nbWorkers = 2;
+    schedule.pools[POOL_FETCH] = 1;
+    schedule.pools[POOL_TEST] = 1;
+
+    fprintf(stdout, "Looking for free workers\n");
+    err += has_free_worker(&schedule, 2, none, POOL_FETCH) != 1;
+    err += has_free_worker(&schedule, 2, fetching, POOL_FETCH) != 0;
+    err += has_free_worker(&schedule, 2, fetching, POOL_BUILD) != 1;
+    // the fetch jobs don't take the workers of the build and test pools
+    err += has_free_worker(&schedule, 2, building, POOL_BUILD) != 0;
+    err += has_free_worker(&schedule, 2, building, POOL_FETCH) != 1;
+    err += has_free_worker(&schedule, 2, testing, POOL_TEST) != 0;
+    err += has_free_worker(&schedule, 2, testing, POOL_BUILD) != 1;
+
+    fprintf(stdout, "Looking for memory\n");
+    schedule.memory = 1000;
+    run.schedule = &schedule;
+    run.running = 1;
+    run.reserved = 600;
+    job->expectedRss = 300;
+    err += fits_memory(&run, job, -1, -1) != 1;
+    job->expectedRss = 500;
+    err += fits_memory(&run, job, -1, -1) != 0;
+    // a job alone runs anyway
+    run.running = 0;
+    err += fits_memory(&run, job, -1, -1) != 1;
+    // MEMORY_RESERVE percent of the system stays available
+    run.running = 1;
+    schedule.memory = 0;
+    err += fits_memory(&run, job, 10000, 2000) != 1;
+    job->expectedRss = 1500;
+    err += fits_memory(&run, job, 10000, 2000) != 0;
+
+    destroy_job(job);
+    return err;
+}
+
+
+/**
+ * Predict the makespan of some jobs and compare it with the expected one.
+ * \param step what is tested
+ * \param memory the memory of the schedule
+ * \param rss the expected peak of memory of each job
+ * \param expected the expected makespan
+ * \return 0 if the makespan is the expected one
+ */
+static int test_makespan(const char *step, long memory, long rss, double expected) {
+
+    yk_schedule schedule;
+    yk_chain *chains = NULL;
+    yk_chain *chain;
+    yk_job *job;
+    double makespan;
+
+    memset(&schedule, 0, sizeof(schedule));
+    schedule.nbWorkers = 2;
+    schedule.memory = memory;
+
+    jobs_add(&chains, "x", create_job("four", "true", NULL, NULL, 4));
+    jobs_add(&chains, "x", create_job("three", "true", NULL, NULL, 3));
+    jobs_add(&chains, "y", create_job("two", "true", NULL, NULL, 2));
+    jobs_add(&chains, "z", create_job("one", "true", NULL, NULL, 1));
+    for(chain = chains; chain != NULL; chain = chain->next) {
+        for(job = chain->jobs; job != NULL; job = job->next) {
+            job->expectedRss = rss;
+        }
+    }
+    // the chain of four then three is the longest path
+    chains->jobs->rank = 7;
+
+    makespan = predict_makespan(chains, &schedule, schedule.nbWorkers);
+    fprintf(stdout, "%s : predicted makespan %.0f s%s\n", step, makespan, makespan != expected ? " (unexpected)" : "");
+
+    jobs_destroy(chains);
+    return makespan != expected;
+}
+
+
+/**
+ * Run some jobs with jobs_run().
+ * \param step what is tested
+ * \param chains the jobs, freed by this function
+ * \param nbWorkers the workers of the schedule
+ * \return 0 if the jobs were run
+ */
+static int run_jobs(const char *step, yk_chain *chains, int nbWorkers) {
+
+    yk_schedule schedule;
+    int err;
+
+    memset(&schedule, 0, sizeof(schedule));
+    schedule.nbWorkers = nbWorkers;
+
+    fprintf(stdout, "%s\n", step);
+    err = jobs_run(chains, &schedule, logdir);
+    jobs_destroy(chains);
+    return err;
+}
+
+
+/**
+ * Test the results of the jobs, with their dependencies and their limits.
+ * \return the number of errors
+ */
+static int test_results() {
+
+    yk_chain *chains = NULL;
+    yk_job *job;
+    int err = 0;
+
+    jobs_add(&chains, "x", create_job("true", "true", NULL, NULL, -1));
+    jobs_add(&chains, "x", create_job("false", "false", NULL, NULL, -1));
+    // after only waits for the end, depends needs a success
+    jobs_add(&chains, "x", create_job("after", "true", "false", NULL, -1));
+    jobs_add(&chains, "x", create_job("depends", "true", NULL, "false", -1));
+    jobs_add(&chains, "x", create_job("skipped", "true", NULL, "depends", -1));
+    jobs_add(&chains, "y", job = create_job("sleep", "sleep 10", NULL, NULL, -1));
+    job->timeout = 1;
+
+    err += run_jobs("Running jobs with dependencies and a timeout", chains, 2);
+    err += check_result("true", "OK");
+    err += check_result("false", "FAIL");
+    err += check_result("after", "OK");
+    err += check_result("depends", DEPENDENCY_STRING);
+    err += check_result("skipped", DEPENDENCY_STRING);
+    err += check_result("sleep", "TIMEOUT");
+
+    clean_logdir();
+    return err;
+}
+
+
+/**
+ * Test the order in which the jobs start with a single worker.
+ * \return the number of errors
+ */
+static int test_order() {
+
+    const char *oneSecond[] = { "OK;1.00;0.00;0.00;0" };
+    const char *fiveSeconds[] = { "OK;5.00;0.00;0.00;0" };
+    const char *tenSeconds[] = { "OK;10.00;0.00;0.00;0" };
+    char *names[] = { "short", "long", "first", "next" };
+    char command[300];
+    char filename[100];
+    char order[100] = "";
+    char line[100];
+    yk_chain *chains = NULL;
+    FILE *fd;
+    int err = 0;
+    int i;
+
+    write_history("short", oneSecond, 1);
+    write_history("long", fiveSeconds, 1);
+    write_history("first", oneSecond, 1);
+    write_history("next", tenSeconds, 1);
+
+    sprintf(filename, "%s/%s", logdir, ORDER_FILE);
+    for(i = 0; i < 4; i++) {
+        sprintf(command, "echo %s >> %s", names[i], filename);
+        jobs_add(&chains, i < 2 ? names[i] : "chain", create_job(names[i], command, NULL, NULL, -1));
+    }
+
+    // first is short, but next waits for it
+    err += run_jobs("Running jobs ordered by rank", chains, 1);
+
+    fd = fopen(filename, "r");
+    while(fd != NULL && fgets(line, sizeof(line), fd) != NULL) {
+        line[strcspn(line, "\n")] = ' ';
+        strcat(order, line);
+    }
+    if(fd != NULL) {
+        fclose(fd);
+    }
+    fprintf(stdout, "Start order : %s\n", order);
+    err += strcmp(order, "first next long short ") != 0;
+
+    clean_logdir();
+    return err;
+}
+
+
+/**
+ * Test that the jobs known to be up to date are not run.
+ * \return the number of errors
+ */
+static int test_up_to_date() {
+
+    const char *success[] = { "OK;1.00;0.00;0.00;0" };
+    const char *failure[] = { "FAIL;1.00;0.00;0.00;0" };
+    yk_chain *chains = NULL;
+    yk_job *job;
+    int err = 0;
+
+    write_history("fetch", success, 1);
+    write_history("broken", failure, 1);
+
+    jobs_add(&chains, "x", job = create_job("fetch", "false", NULL, NULL, -1));
+    job->upToDate = 1;
+    jobs_add(&chains, "x", create_job("build", "true", NULL, "fetch", -1));
+    jobs_add(&chains, "y", job = create_job("broken", "true", NULL, NULL, -1));
+    job->upToDate = 1;
+    // the last execution of an up to date job gives its success
+    jobs_add(&chains, "y", create_job("test", "true", NULL, "broken", -1));
+
+    err += run_jobs("Running jobs which are up to date", chains, 2);
+    err += check_result("fetch", SKIPPED_STRING);
+    err += check_result("build", "OK");
+    err += check_result("broken", SKIPPED_STRING);
+    err += check_result("test", DEPENDENCY_STRING);
+
+    clean_logdir();
+    return err;
+}
+
+
+/** Will return 0 on success */
+int main(int argc, char **argv) {
+
+    int err = 0;
+
+    if(mkdtemp(logdir) == NULL) {
+        fprintf(stdout, "Can't create %s\n", logdir);
+        return 1;
+    }
+
+    err += test_rank();
+    err += test_priorities();
+    err += test_resources();
+    err += test_makespan("Two workers", 0, 0, 7);
+    err += test_makespan("Memory for one job", 1000, 600, 10);
+    err += test_results();
+    err += test_order();
+    err += test_up_to_date();
+
+    rmdir(logdir);
+
+    fprintf(stdout, "Jobs tests completed, %d error(s)\n", err);
+    return err != 0;
+}
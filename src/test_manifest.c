@@ -0,0 +1,107 @@
+/**
+ * \file test_manifest.c
+ * \brief Unit test of the manifest of the inputs of the pages
+ */
+
+#include "manifest.h"
+#include <stdio.h>
+#include <sys/time.h>
+
+/** \brief the manifest's file */
+#define MANIFEST_FILE "manifest.tmp"
+
+/** \brief the version of the format of the pages */
+#define VERSION 3
+
+
+/**
+ * Write a file.
+ */
+static void write_file(const char *filename, const char *content) {
+
+    FILE *fd = fopen(filename, "w");
+
+    fputs(content, fd);
+    fclose(fd);
+}
+
+
+/**
+ * Check the inputs of a page with the manifest, then write the next
+ * manifest, as the creation of the pages does.
+ * \param step what is tested
+ * \param version the version of the format of the pages
+ * \param expected 1 if the page must be created again
+ * \return 0 if the page is found changed as expected
+ */
+static int test_check(const char *step, int version, int expected) {
+
+    char *inputs[] = { "a.tmp", "b.tmp", "c;d.tmp" };
+    yk_manifest *manifest = manifest_read(MANIFEST_FILE, version);
+    yk_manifest *next = manifest_read("missing.tmp", version);
+    yk_page_state *state;
+    int changed;
+
+    state = manifest_check(manifest, "page.html", ".", inputs, 3, &changed);
+    manifest_add(next, state);
+    state = manifest_take(manifest, "other.html");
+    if(state != NULL) {
+        manifest_add(next, state);
+    }
+    manifest_write(next, MANIFEST_FILE);
+    manifest_destroy(manifest);
+    manifest_destroy(next);
+
+    fprintf(stdout, "%s : %s\n", step, changed ? "changed" : "unchanged");
+    return changed != expected;
+}
+
+
+/** Will return 0 on success */
+int main(int argc, char **argv) {
+
+    struct timeval times[2] = { { 1000000000, 0 }, { 1000000000, 0 } };
+    char *otherInputs[] = { "c;d.tmp" };
+    yk_manifest *manifest;
+    int err = 0;
+    int changed;
+
+    write_file("a.tmp", "first");
+    write_file("c;d.tmp", "third");
+    remove("b.tmp");
+    remove(MANIFEST_FILE);
+
+    // another page, kept from one manifest to the next
+    manifest = manifest_read(MANIFEST_FILE, VERSION);
+    manifest_add(manifest, manifest_check(manifest, "other.html", ".", otherInputs, 1, &changed));
+    manifest_write(manifest, MANIFEST_FILE);
+    manifest_destroy(manifest);
+
+    err += test_check("New page", VERSION, 1);
+    err += test_check("Same inputs", VERSION, 0);
+
+    write_file("a.tmp", "first");
+    utimes("a.tmp", times);
+    err += test_check("Same content, other date", VERSION, 0);
+
+    write_file("a.tmp", "FIRST");
+    err += test_check("Other content, same size", VERSION, 1);
+
+    write_file("b.tmp", "second");
+    err += test_check("Missing input created", VERSION, 1);
+    err += test_check("Same inputs", VERSION, 0);
+
+    manifest = manifest_read(MANIFEST_FILE, VERSION);
+    manifest_destroy_state(manifest_check(manifest, "other.html", ".", otherInputs, 1, &changed));
+    fprintf(stdout, "Kept page : %s\n", changed ? "changed" : "unchanged");
+    err += changed;
+    manifest_destroy(manifest);
+
+    err += test_check("Other version", VERSION + 1, 1);
+
+    remove("b.tmp");
+    err += test_check("Input removed", VERSION + 1, 1);
+
+    fprintf(stdout, "Manifest tests completed, %d error(s)\n", err);
+    return err != 0;
+}
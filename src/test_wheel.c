@@ -0,0 +1,79 @@
+/**
+ * \file test_wheel.c
+ * \brief Unit test of the timer wheel
+ */
+
+#include "wheel.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/** \brief the date of the beginning of the tests */
+#define NOW 1000000
+
+
+/**
+ * Expire the timers at a date and compare them with the expected ones.
+ * \param expected the data of the expected timers, as a bit mask
+ * \return 0 if the expected timers, and only them, expired
+ */
+static int test_expire(yk_wheel *wheel, time_t date, long expected) {
+
+    yk_timer *timer = wheel_expire(wheel, date);
+    long found = 0;
+
+    while(timer != NULL) {
+        yk_timer *next = timer->next;
+        found |= (long) timer->data;
+        free(timer);
+        timer = next;
+    }
+
+    fprintf(stdout, "Expiry at NOW+%ld : %lx\n", (long) (date - NOW), found);
+    return found != expected;
+}
+
+
+/** Will return 0 on success */
+int main(int argc, char **argv) {
+
+    yk_wheel *wheel = wheel_create(NOW);
+    int err = 0;
+
+    fprintf(stdout, "Adding timers\n");
+    wheel_add(wheel, NOW + 10, (void *) 0x1);
+    wheel_add(wheel, NOW + 5, (void *) 0x2);
+    // the next turn of the wheel, in the slot of NOW+88
+    wheel_add(wheel, NOW + WHEEL_SLOTS + 88, (void *) 0x4);
+    wheel_add(wheel, NOW + 88, (void *) 0x8);
+    // in the past
+    wheel_add(wheel, NOW - 3, (void *) 0x10);
+    err += wheel->nbTimers != 5;
+    err += wheel_next(wheel) != NOW - 3;
+
+    fprintf(stdout, "Removing a timer\n");
+    err += wheel_remove(wheel, NOW + 5, (void *) 0x2) != 0;
+    err += wheel_remove(wheel, NOW + 5, (void *) 0x2) != 1;
+    err += wheel_remove(wheel, NOW + 10, (void *) 0x2) != 1;
+
+    // a date in the past expires at the next tick
+    err += test_expire(wheel, NOW, 0);
+    err += test_expire(wheel, NOW + 1, 0x10);
+    err += wheel_next(wheel) != NOW + 10;
+    err += test_expire(wheel, NOW + 9, 0);
+    // the timer of the next turn stays in its slot
+    err += test_expire(wheel, NOW + 100, 0x1 | 0x8);
+    err += wheel->nbTimers != 1;
+    err += wheel_next(wheel) != NOW + WHEEL_SLOTS + 88;
+
+    // after a long sleep
+    err += test_expire(wheel, NOW + 10 * WHEEL_SLOTS, 0x4);
+    err += wheel->nbTimers != 0;
+    err += wheel_next(wheel) != 0;
+
+    fprintf(stdout, "Freeing memory\n");
+    wheel_add(wheel, NOW + 20 * WHEEL_SLOTS, (void *) 0x1);
+    wheel_destroy(wheel);
+
+    fprintf(stdout, "Wheel tests completed, %d error(s)\n", err);
+    return err != 0;
+}
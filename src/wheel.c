@@ -0,0 +1,173 @@
+/**
+ * \file wheel.c
+ * \brief a timer wheel, to wake things up at given dates
+ */
+
+#include <stdlib.h>
+#include "wheel.h"
+
+
+/**
+ * Find the slot of a tick.
+ */
+static int slot_of(time_t tick) {
+    return (int) (tick % WHEEL_SLOTS);
+}
+
+
+yk_wheel *wheel_create(time_t now) {
+
+    yk_wheel *wheel = malloc(sizeof(yk_wheel));
+    int i;
+
+    for(i = 0; i < WHEEL_SLOTS; i++) {
+        wheel->slots[i] = NULL;
+    }
+    wheel->tick = now / WHEEL_TICK;
+    wheel->nbTimers = 0;
+
+    return wheel;
+}
+
+
+void wheel_add(yk_wheel *wheel, time_t date, void *data) {
+
+    yk_timer *timer = malloc(sizeof(yk_timer));
+    time_t tick = date / WHEEL_TICK;
+    int slot;
+
+    // the slots of the past ticks won't be looked at again
+    if(tick <= wheel->tick) {
+        tick = wheel->tick + 1;
+    }
+    slot = slot_of(tick);
+
+    timer->date = date;
+    timer->data = data;
+    timer->next = wheel->slots[slot];
+    wheel->slots[slot] = timer;
+    wheel->nbTimers++;
+}
+
+
+int wheel_remove(yk_wheel *wheel, time_t date, const void *data) {
+
+    time_t tick = date / WHEEL_TICK;
+    yk_timer **timer;
+
+    if(tick <= wheel->tick) {
+        tick = wheel->tick + 1;
+    }
+
+    // a date in the past was put at the tick following the addition
+    for(timer = &(wheel->slots[slot_of(tick)]); *timer != NULL; timer = &((*timer)->next)) {
+        if((*timer)->data == data && (*timer)->date == date) {
+            yk_timer *found = *timer;
+            *timer = found->next;
+            free(found);
+            wheel->nbTimers--;
+            return 0;
+        }
+    }
+
+    // not found in its slot : it may have been added before the last ticks
+    for(tick = 0; tick < WHEEL_SLOTS; tick++) {
+        for(timer = &(wheel->slots[tick]); *timer != NULL; timer = &((*timer)->next)) {
+            if((*timer)->data == data && (*timer)->date == date) {
+                yk_timer *found = *timer;
+                *timer = found->next;
+                free(found);
+                wheel->nbTimers--;
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+
+yk_timer *wheel_expire(yk_wheel *wheel, time_t now) {
+
+    yk_timer *expired = NULL;
+    time_t last = now / WHEEL_TICK;
+    time_t tick;
+
+    // after a long sleep, a turn of the wheel is enough
+    if(last - wheel->tick > WHEEL_SLOTS) {
+        wheel->tick = last - WHEEL_SLOTS;
+    }
+
+    for(tick = wheel->tick + 1; tick <= last; tick++) {
+
+        yk_timer **timer = &(wheel->slots[slot_of(tick)]);
+
+        while(*timer != NULL) {
+            if((*timer)->date <= now) {
+                yk_timer *found = *timer;
+                *timer = found->next;
+                found->next = expired;
+                expired = found;
+                wheel->nbTimers--;
+            } else {
+                timer = &((*timer)->next);
+            }
+        }
+    }
+
+    if(last > wheel->tick) {
+        wheel->tick = last;
+    }
+
+    return expired;
+}
+
+
+time_t wheel_next(const yk_wheel *wheel) {
+
+    time_t first = 0;
+    int i;
+
+    if(wheel->nbTimers == 0) {
+        return 0;
+    }
+
+    for(i = 1; i <= WHEEL_SLOTS; i++) {
+
+        time_t tick = wheel->tick + i;
+        const yk_timer *timer;
+
+        for(timer = wheel->slots[slot_of(tick)]; timer != NULL; timer = timer->next) {
+            if(first == 0 || timer->date < first) {
+                first = timer->date;
+            }
+        }
+
+        // the timers of this turn are found in the order of the ticks
+        if(first != 0 && first / WHEEL_TICK <= tick) {
+            break;
+        }
+    }
+
+    return first;
+}
+
+
+void wheel_destroy(yk_wheel *wheel) {
+
+    int i;
+
+    if(wheel == NULL) {
+        return;
+    }
+
+    for(i = 0; i < WHEEL_SLOTS; i++) {
+        while(wheel->slots[i] != NULL) {
+            yk_timer *next = wheel->slots[i]->next;
+            free(wheel->slots[i]);
+            wheel->slots[i] = next;
+        }
+    }
+
+    free(wheel);
+}
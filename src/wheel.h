@@ -0,0 +1,94 @@
+/**
+ * \file wheel.h
+ * \brief a timer wheel, to wake things up at given dates
+ *
+ * The timers are put in a circular table of slots : the slot of a timer
+ * is its expiry tick, modulo the number of slots. Adding or removing a
+ * timer doesn't depend on the number of timers, and the expiry only looks
+ * at the slots of the elapsed ticks. A slot may hold timers of the next
+ * turns of the wheel, they stay in place until their date.
+ */
+
+#ifndef YK_WHEEL_H
+#define YK_WHEEL_H 1
+
+#include <time.h>
+
+/** \brief number of slots of the wheel */
+#define WHEEL_SLOTS 512
+
+/** \brief duration of a tick, in seconds */
+#define WHEEL_TICK 1
+
+
+/**
+ * \brief A timer.
+ */
+typedef struct yk_timer_ {
+    time_t date; /**< \brief when the timer expires */
+    void *data; /**< \brief what the timer is for */
+    struct yk_timer_ *next; /**< \brief the next timer of the same slot, or of the expired ones */
+} yk_timer;
+
+
+/**
+ * \brief The timer wheel.
+ */
+typedef struct {
+    yk_timer *slots[WHEEL_SLOTS]; /**< \brief the timers, by expiry tick */
+    time_t tick; /**< \brief the last tick whose slot was processed */
+    int nbTimers; /**< \brief number of timers in the wheel */
+} yk_wheel;
+
+
+/**
+ * \brief Create an empty timer wheel.
+ * \param now the current date
+ * \return the new wheel
+ */
+yk_wheel *wheel_create(time_t now);
+
+
+/**
+ * \brief Add a timer. A date in the past expires at the next tick.
+ * \param wheel the wheel
+ * \param date when the timer expires
+ * \param data what the timer is for
+ */
+void wheel_add(yk_wheel *wheel, time_t date, void *data);
+
+
+/**
+ * \brief Remove a timer before its expiry.
+ * \param wheel the wheel
+ * \param date the date given to wheel_add
+ * \param data the data given to wheel_add
+ * \return 0 if the timer was found
+ */
+int wheel_remove(yk_wheel *wheel, time_t date, const void *data);
+
+
+/**
+ * \brief Take the timers expired at a date out of the wheel.
+ * \param wheel the wheel
+ * \param now the current date
+ * \return the list of the expired timers, to free, or NULL
+ */
+yk_timer *wheel_expire(yk_wheel *wheel, time_t now);
+
+
+/**
+ * \brief Find the date of the next expiry.
+ * \param wheel the wheel
+ * \return the date of the first timer, or 0 if the wheel is empty
+ */
+time_t wheel_next(const yk_wheel *wheel);
+
+
+/**
+ * \brief Free a wheel and its timers.
+ * \param wheel the wheel
+ */
+void wheel_destroy(yk_wheel *wheel);
+
+#endif
@@ -0,0 +1,2438 @@
+/**
+ * \file yannkins_run.c
+ * \brief Analyse all the projects : run their tasks, then create the
+ * HTML pages.
+ *
+ * The projects defined in ${YANNKINS_HOME}/projects are read, and the
+ * tasks of all the projects (checkout, compilation, tests, and the tasks
+ * declared with TASK_<NAME>) are run concurrently by a pool of workers
+ * ("-j N"). The tasks of a project wait for the checkout, and for the
+ * tasks listed in their DEPENDS_<NAME> variable. Then the new commits of
+ * each project are appended to its history, the commit which broke the
+ * tests of a git project is searched if they just began to fail, and the
+ * report is created. With "--split-batches", the state of the tests of
+ * each new commit is found.
+ *
+ * In daemon mode ("--daemon"), each project is analysed again after its
+ * POLL_INTERVAL, or after the default interval ("-i DURATION"). The
+ * projects' directory is watched with inotify : the added, modified and
+ * removed projects' files are taken into account without restarting.
+ * Writing "run <PROJECT>" in the FIFO ${YANNKINS_HOME}/trigger, for
+ * example from a post-receive hook, starts the analysis of the project
+ * without waiting for its interval. The analyses of all the projects
+ * share one scheduler, which runs until the daemon stops : a due project
+ * adds its tasks to the running ones, and only the pages of the analysed
+ * projects are created again. The histories and the pages are written by
+ * children of the daemon, and the git commands of a bisection are jobs,
+ * so that the scheduler never waits for them.
+ *
+ * With "--agents ADDRESS", the agents ("yannkins-agent ADDRESS") connected
+ * to this Unix socket or "[HOST]:PORT" run the compilations and the tests
+ * which would wait for a local worker. They stay connected between the
+ * analyses.
+ */
+
+#define IC "Yannkins"
+
+/**
+ * \brief default working directory can be overriden by environment variable
+ * "YANNKINS_HOME"
+ */
+#define YANNKINS_DIR "/var/yannkins"
+
+/** \brief where are the projects defined */
+#define PROJECTS_DIR "projects"
+
+/** \brief where are the repos local copy */
+#define REPOS_DIR "repos"
+
+/** \brief where are the shared mirrors of the git repositories */
+#define MIRRORS_DIR "mirrors"
+
+/** \brief FIFO where the daemon receives the "run <PROJECT>" commands */
+#define TRIGGER_FIFO "trigger"
+
+/** \brief max length of a command received on the trigger FIFO */
+#define TRIGGER_LINE_SIZE 256
+
+/** \brief in daemon mode, default seconds between two analyses of a project */
+#define DEFAULT_INTERVAL 3600
+
+/** \brief suffix of the file keeping the last revision of a commits' history */
+#define LAST_REVISION_SUFFIX ".last"
+
+/** \brief first line of a commits' history */
+#define HISTORY_HEADER "#;author;date;commentaries\n"
+
+/** \brief max length of a line of "git log" */
+#define GIT_LOG_LINE_SIZE 4096
+
+/** \brief separator of the fields in the output of "git log" */
+#define GIT_LOG_SEPARATOR "\x1f"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/select.h>
+#include <sys/inotify.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include "logger.h"
+#include "capture.h"
+#include "jobs.h"
+#include "agents.h"
+#include "project.h"
+#include "report.h"
+#include "data/data.h"
+#include "wheel.h"
+#include "bisect.h"
+
+
+static void usage(char *prog) {
+    fprintf(stderr, "Analyse all the %s projects\n", IC);
+    fprintf(stderr, "Usage : %s [OPTIONS]\n", prog);
+    fprintf(stderr, "  -t, --timeout    default wall clock limit of a task\n");
+    fprintf(stderr, "  -c, --cpu-limit  default CPU time limit of a task\n");
+    fprintf(stderr, "  -j, --jobs       number of tasks executed at the same time\n");
+    fprintf(stderr, "  -m, --make-jobs  tokens of the make jobserver shared by the tasks, 0 for none\n");
+    fprintf(stderr, "  --memory <SIZE>  memory for the expected peaks of the running tasks\n");
+    fprintf(stderr, "  --pools <POOLS>  tasks executed at the same time by pool, like fetch=4,build=2,test=2\n");
+    fprintf(stderr, "  --head <SIZE>    bytes kept at the beginning of the console output\n");
+    fprintf(stderr, "  --tail <SIZE>    bytes kept at the end of the console output\n");
+    fprintf(stderr, "  -z, --compress   compress the console output\n");
+    fprintf(stderr, "  -f, --force      run the tasks and create the pages even if their revision did not change\n");
+    fprintf(stderr, "  --git-mirrors    clone the git repositories from shared mirrors\n");
+    fprintf(stderr, "  --split-batches  find the state of the tests of each new commit of the git projects\n");
+    fprintf(stderr, "  --agents <ADDR>  send the tasks waiting for a worker to the agents connected on this address\n");
+    fprintf(stderr, "  --agents-secret <FILE>  file whose first line the agents must give, required on TCP\n");
+    fprintf(stderr, "  -d, --daemon     analyse each project periodically, following the changes of the projects\n");
+    fprintf(stderr, "  -i, --interval   in daemon mode, default duration between two analyses of a project (1h)\n");
+    exit(1);
+}
+
+
+/**
+ * Read a project's file, and check the project is complete.
+ *
+ * \param projectsDir the projects' directory
+ * \param name the file's name in this directory
+ * \return the project, or NULL if it can't be analysed
+ */
+static yk_project *read_project(const char *projectsDir, const char *name) {
+
+    char *filename = malloc(strlen(projectsDir) + strlen(name) + 2);
+    yk_project *project;
+
+    sprintf(filename, "%s/%s", projectsDir, name);
+    project = yk_read_project_file(filename);
+
+    if(project != NULL && project->project_name == NULL) {
+        log_warning("File %s : Project name missing", filename);
+        yk_destroy_project(project);
+        project = NULL;
+    }
+    if(project != NULL && project->versioning_type == NONE) {
+        log_warning("Project %s : Repository not specified", project->project_name);
+        yk_destroy_project(project);
+        project = NULL;
+    }
+
+    free(filename);
+    return project;
+}
+
+
+/**
+ * Read all the projects' files.
+ *
+ * \param yannkinsDir Yannkins' working directory
+ * \param nb set to the number of projects
+ * \return an allocated table of the projects, or NULL if there is none
+ */
+static yk_project **read_projects(char *yannkinsDir, int *nb) {
+
+    char *projectsDir;
+    DIR *rep;
+    struct dirent *lecture;
+    yk_project **projects = NULL;
+    int allocatedSize = 0;
+
+    *nb = 0;
+
+    projectsDir = malloc(strlen(yannkinsDir) + strlen(PROJECTS_DIR) + 2);
+    sprintf(projectsDir, "%s/%s", yannkinsDir, PROJECTS_DIR);
+
+    rep = opendir(projectsDir);
+    if(rep == NULL) {
+        log_error("Can't open directory %s", projectsDir);
+        free(projectsDir);
+        return NULL;
+    }
+
+    while((lecture = readdir(rep))) {
+
+        yk_project *project;
+
+        if(lecture->d_type != DT_REG || !yk_is_project_file(lecture->d_name)) {
+            continue;
+        }
+
+        project = read_project(projectsDir, lecture->d_name);
+
+        if(project != NULL) {
+            if(*nb >= allocatedSize) {
+                allocatedSize += 20;
+                projects = realloc(projects, allocatedSize * sizeof(yk_project *));
+            }
+            projects[*nb] = project;
+            (*nb)++;
+        }
+    }
+
+    closedir(rep);
+    free(projectsDir);
+    return projects;
+}
+
+
+/**
+ * Build the name of a task's result file : ${TASK}_${PROJECT}.
+ *
+ * \return an allocated string
+ */
+static char *task_name(const char *task, yk_project *project) {
+
+    char *name = malloc(strlen(task) + strlen(project->project_name) + 2);
+    sprintf(name, "%s_%s", task, project->project_name);
+    return name;
+}
+
+
+/**
+ * Build the list of the tasks listed in a DEPENDS_<NAME> variable, as
+ * names of jobs.
+ *
+ * \param project the project
+ * \param task the name of the task, without the project's name
+ * \return an allocated string, or NULL if the task has no dependency
+ */
+static char *task_depends(yk_project *project, const char *task) {
+
+    yk_task *entry;
+    char *depends;
+    char *copy;
+    char *dep;
+    char *saveptr;
+
+    for(entry = project->tasks; entry != NULL; entry = entry->next) {
+        if(!strcmp(entry->name, task)) {
+            break;
+        }
+    }
+
+    if(entry == NULL || entry->depends == NULL) {
+        return NULL;
+    }
+
+    // each name gets "_${PROJECT}"
+    depends = malloc((strlen(entry->depends) + 1) * (strlen(project->project_name) + 2));
+    depends[0] = '\0';
+    copy = strdup(entry->depends);
+
+    for(dep = strtok_r(copy, " \t", &saveptr); dep != NULL; dep = strtok_r(NULL, " \t", &saveptr)) {
+        if(depends[0] != '\0') {
+            strcat(depends, " ");
+        }
+        sprintf(depends + strlen(depends), "%s_%s", dep, project->project_name);
+    }
+
+    free(copy);
+    return depends;
+}
+
+
+/**
+ * Build the beginning of the svn commands of a project, with the
+ * authentication options.
+ *
+ * \param project the project
+ * \param length room to keep for the rest of the command
+ * \return the allocated command
+ */
+static char *svn_command(yk_project *project, size_t length) {
+
+    char *command;
+
+    length += 50;
+    if(project->repos_user != NULL) {
+        length += strlen(project->repos_user);
+    }
+    if(project->repos_password != NULL) {
+        length += strlen(project->repos_password);
+    }
+    command = malloc(length);
+
+    strcpy(command, "svn");
+    if(project->repos_user != NULL && project->repos_user[0] != '\0') {
+        sprintf(command + strlen(command), " --username '%s'", project->repos_user);
+    }
+    if(project->repos_password != NULL && project->repos_password[0] != '\0') {
+        sprintf(command + strlen(command), " --password '%s'", project->repos_password);
+    }
+
+    return command;
+}
+
+
+/**
+ * Build the command of the checkout, or of the update, of a project.
+ *
+ * \param project the project
+ * \param reposDir directory of the local copies
+ * \param mirror the shared mirror of the repository, or NULL
+ * \param workdir set to where to run the command, to free
+ * \return the allocated command
+ */
+static char *checkout_command(yk_project *project, const char *reposDir, const char *mirror, char **workdir) {
+
+    char *command;
+    char *localCopy = malloc(strlen(reposDir) + strlen(project->project_name) + 2);
+    size_t length = strlen(project->repository) + strlen(project->project_name) + 50;
+    int exists;
+
+    if(mirror != NULL) {
+        length += strlen(mirror) + 100;
+    }
+
+    sprintf(localCopy, "%s/%s", reposDir, project->project_name);
+    exists = !access(localCopy, F_OK);
+
+    if(exists) {
+        *workdir = localCopy;
+    } else {
+        *workdir = strdup(reposDir);
+        free(localCopy);
+    }
+
+    if(project->versioning_type == GIT) {
+        command = malloc(length);
+        if(exists && mirror != NULL && project->upstream == NULL && !access(mirror, F_OK)) {
+            // the mirror was just updated : its branches are the ones of the repository
+            sprintf(command, "git fetch --tags %s '+refs/heads/*:refs/remotes/origin/*' && git merge --ff-only @{u} "
+                    "&& git submodule update", mirror);
+        } else if(exists) {
+            // a fork has its own branches, but the objects of the mirror are not downloaded again
+            strcpy(command, "git pull && git submodule update");
+        } else if(mirror != NULL && !access(mirror, F_OK)) {
+            // the objects of the mirror are not copied, it must never lose them
+            sprintf(command, "git clone --recursive --reference %s %s %s", mirror, project->repository,
+                    project->project_name);
+        } else {
+            sprintf(command, "git clone --recursive %s %s", project->repository, project->project_name);
+        }
+        return command;
+    }
+
+    command = svn_command(project, length);
+    if(exists) {
+        strcat(command, " update");
+    } else {
+        sprintf(command + strlen(command), " co %s %s", project->repository, project->project_name);
+    }
+
+    return command;
+}
+
+
+/**
+ * Start a command in a shell, in the background.
+ *
+ * \param workdir where to execute the command
+ * \param command the command
+ * \param fd if not NULL, set to the reading end of the output of the
+ *        command, otherwise the output is lost
+ * \return the pid of the process, or -1 in case of error
+ */
+static pid_t spawn(const char *workdir, const char *command, int *fd) {
+
+    int fds[2] = { -1, -1 };
+    pid_t pid;
+
+    if(fd != NULL && pipe(fds)) {
+        log_error("Can't create a pipe to run %s", command);
+        return -1;
+    }
+
+    pid = fork();
+
+    if(pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        sigset_t sigchld;
+        // started while the scheduler blocks SIGCHLD
+        sigemptyset(&sigchld);
+        sigaddset(&sigchld, SIGCHLD);
+        sigprocmask(SIG_UNBLOCK, &sigchld, NULL);
+        if(fd != NULL) {
+            close(fds[0]);
+            dup2(fds[1], STDOUT_FILENO);
+        } else {
+            dup2(devnull, STDOUT_FILENO);
+        }
+        dup2(devnull, STDERR_FILENO);
+        if(chdir(workdir)) {
+            _exit(127);
+        }
+        execl("/bin/sh", "sh", "-c", command, (char *) NULL);
+        _exit(127);
+    }
+
+    if(fd != NULL) {
+        close(fds[1]);
+        *fd = fds[0];
+    }
+
+    if(pid == -1) {
+        log_error("Can't fork to run %s", command);
+        if(fd != NULL) {
+            close(fds[0]);
+        }
+    }
+
+    return pid;
+}
+
+
+/**
+ * Start a process printing the head revision of the remote repository of
+ * a project, then the revision of its local copy.
+ *
+ * \param project the project
+ * \param reposDir directory of the local copies
+ * \param fd set to the reading end of the output of the process
+ * \return the pid of the process, or -1 if the project has no local copy
+ */
+static pid_t start_remote_check(yk_project *project, const char *reposDir, int *fd) {
+
+    char *localCopy = malloc(strlen(reposDir) + strlen(project->project_name) + 2);
+    char *command;
+    pid_t pid;
+
+    sprintf(localCopy, "%s/%s", reposDir, project->project_name);
+    if(access(localCopy, F_OK)) {
+        free(localCopy);
+        return -1;
+    }
+
+    if(project->versioning_type == GIT) {
+        command = malloc(strlen(project->repository) + 150);
+        sprintf(command, "git ls-remote %s \"$(git symbolic-ref -q HEAD || echo HEAD)\" | cut -f1 && git rev-parse HEAD",
+                project->repository);
+    } else {
+        char *svn = svn_command(project, 0);
+        command = malloc(2 * strlen(svn) + strlen(project->repository) + 150);
+        sprintf(command, "%s info --show-item last-changed-revision %s && %s info --show-item last-changed-revision",
+                svn, project->repository, svn);
+        free(svn);
+    }
+
+    pid = spawn(localCopy, command, fd);
+
+    free(command);
+    free(localCopy);
+    return pid;
+}
+
+
+/**
+ * Read the output of a process started by start_remote_check() : the
+ * remote's head revision, then the local one, a line each.
+ *
+ * \param project the project
+ * \param fd the output of the process, closed
+ * \param wstatus the status of the terminated process
+ * \param output filled with the output
+ * \param size size of output
+ * \return 0 if the process succeeded
+ */
+static int read_check_output(yk_project *project, int fd, int wstatus, char *output, size_t size) {
+
+    ssize_t length = 0;
+    ssize_t nb;
+
+    // the output is small enough to be in the pipe's buffer
+    while(length < (ssize_t) size - 1 && (nb = read(fd, output + length, size - 1 - length)) > 0) {
+        length += nb;
+    }
+    close(fd);
+    output[length] = '\0';
+
+    if(!WIFEXITED(wstatus) || WEXITSTATUS(wstatus)) {
+        log_warning("Project %s : can't get the revision of the repository", project->project_name);
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * Read the output of a process started by start_remote_check().
+ *
+ * \param project the project
+ * \param fd the output of the process
+ * \param wstatus the status of the terminated process
+ * \return the allocated revision if the local copy is at the remote's
+ *         head, NULL otherwise
+ */
+static char *read_remote_check(yk_project *project, int fd, int wstatus) {
+
+    char output[2 * REVISION_SIZE + 2];
+    char *local;
+
+    if(read_check_output(project, fd, wstatus, output, sizeof(output))) {
+        return NULL;
+    }
+
+    local = strchr(output, '\n');
+    if(local == NULL || local == output) {
+        return NULL;
+    }
+    *local = '\0';
+    local++;
+    local[strcspn(local, "\n")] = '\0';
+
+    if(strcmp(output, local)) {
+        log_info("Project %s : new revision %s in the repository", project->project_name, output);
+        return NULL;
+    }
+
+    log_info("Project %s : no change in the repository (revision %s)", project->project_name, output);
+    return strdup(output);
+}
+
+
+/**
+ * Ask the remote repositories of the projects for their head revision,
+ * several at the same time. A project is unchanged when its local copy is
+ * at this revision : there is nothing to update.
+ *
+ * \param projects the projects
+ * \param nb the number of projects
+ * \param reposDir directory of the local copies
+ * \param nbWorkers the maximum number of concurrent requests
+ * \return an allocated table with the revision of each unchanged
+ *         project, NULL for the others
+ */
+static char **check_remotes(yk_project **projects, int nb, const char *reposDir, int nbWorkers) {
+
+    char **unchanged = calloc(nb, sizeof(char *));
+    pid_t *pids = malloc(nb * sizeof(pid_t));
+    int *fds = malloc(nb * sizeof(int));
+    int running = 0;
+    int i = 0;
+
+    while(i < nb || running > 0) {
+
+        int wstatus;
+        pid_t pid;
+        int j;
+
+        if(i < nb && running < nbWorkers) {
+            pids[i] = start_remote_check(projects[i], reposDir, &fds[i]);
+            if(pids[i] > 0) {
+                running++;
+            }
+            i++;
+            continue;
+        }
+
+        pid = waitpid(-1, &wstatus, 0);
+        if(pid == -1) {
+            break;
+        }
+
+        for(j = 0; j < i && pids[j] != pid; j++);
+        if(j < i) {
+            running--;
+            unchanged[j] = read_remote_check(projects[j], fds[j], wstatus);
+        }
+    }
+
+    free(pids);
+    free(fds);
+    return unchanged;
+}
+
+
+/**
+ * Find the mirror of the git repository of a project.
+ *
+ * \param project the project
+ * \param yannkinsDir Yannkins' working directory
+ * \param url set to the url of the mirrored repository
+ * \return the allocated path of the mirror : the url where each character
+ *         other than a letter, a digit, '-' or '.' is replaced by '_'
+ */
+static char *mirror_path(yk_project *project, const char *yannkinsDir, const char **url) {
+
+    char *path;
+    char *c;
+
+    *url = project->upstream != NULL ? project->upstream : project->repository;
+
+    path = malloc(strlen(yannkinsDir) + strlen(MIRRORS_DIR) + strlen(*url) + 7);
+    sprintf(path, "%s/%s/", yannkinsDir, MIRRORS_DIR);
+    c = path + strlen(path);
+    strcat(path, *url);
+    for(; *c != '\0'; c++) {
+        if(!isalnum((unsigned char) *c) && *c != '-' && *c != '.') {
+            *c = '_';
+        }
+    }
+    strcat(path, ".git");
+
+    return path;
+}
+
+
+/**
+ * Start the creation, or the update, of the shared mirror of a git
+ * repository.
+ *
+ * \param path the mirror
+ * \param url the mirrored repository
+ * \param mirrorsDir directory of the mirrors
+ * \return the pid of the process, or -1 in case of error
+ */
+static pid_t start_mirror_update(const char *path, const char *url, const char *mirrorsDir) {
+
+    char *command;
+    pid_t pid;
+
+    // the clones borrow the objects of the mirror : they are never pruned nor collected
+    if(access(path, F_OK)) {
+        log_info("Creating the mirror of %s", url);
+        command = malloc(strlen(url) + 3 * strlen(path) + 100);
+        sprintf(command, "git clone --mirror %s %s && git -C %s config gc.auto 0 "
+                "&& git -C %s config gc.pruneExpire never", url, path, path, path);
+        pid = spawn(mirrorsDir, command, NULL);
+        free(command);
+    } else {
+        log_info("Updating the mirror of %s", url);
+        pid = spawn(path, "git config gc.auto 0 && git config gc.pruneExpire never && git remote update", NULL);
+    }
+
+    return pid;
+}
+
+
+/**
+ * Create or update the shared mirrors of the git repositories of the
+ * projects which will be updated, several at the same time.
+ *
+ * \param projects the projects
+ * \param nb the number of projects
+ * \param unchanged the revision of the projects which won't be updated
+ * \param yannkinsDir Yannkins' working directory
+ * \param nbWorkers the maximum number of concurrent updates
+ */
+static void update_mirrors(yk_project **projects, int nb, char **unchanged, const char *yannkinsDir, int nbWorkers) {
+
+    char **paths = calloc(nb, sizeof(char *));
+    pid_t *pids = malloc(nb * sizeof(pid_t));
+    char *mirrorsDir = malloc(strlen(yannkinsDir) + strlen(MIRRORS_DIR) + 2);
+    int running = 0;
+    int i = 0;
+    int j;
+
+    sprintf(mirrorsDir, "%s/%s", yannkinsDir, MIRRORS_DIR);
+    mkdir(mirrorsDir, 0750);
+
+    while(i < nb || running > 0) {
+
+        int wstatus;
+        pid_t pid;
+
+        if(i < nb && running < nbWorkers) {
+
+            const char *url;
+
+            pids[i] = -1;
+            if(projects[i]->versioning_type != GIT || (unchanged != NULL && unchanged[i] != NULL)) {
+                i++;
+                continue;
+            }
+
+            // each mirror is updated once
+            paths[i] = mirror_path(projects[i], yannkinsDir, &url);
+            for(j = 0; j < i && (paths[j] == NULL || strcmp(paths[j], paths[i])); j++);
+            if(j < i) {
+                i++;
+                continue;
+            }
+
+            pids[i] = start_mirror_update(paths[i], url, mirrorsDir);
+            if(pids[i] > 0) {
+                running++;
+            }
+            i++;
+            continue;
+        }
+
+        pid = waitpid(-1, &wstatus, 0);
+        if(pid == -1) {
+            break;
+        }
+
+        for(j = 0; j < i && pids[j] != pid; j++);
+        if(j < i) {
+            running--;
+            if(!WIFEXITED(wstatus) || WEXITSTATUS(wstatus)) {
+                log_warning("Can't update the mirror %s", paths[j]);
+            }
+        }
+    }
+
+    for(i = 0; i < nb; i++) {
+        free(paths[i]);
+    }
+    free(paths);
+    free(pids);
+    free(mirrorsDir);
+}
+
+
+/**
+ * Add a task of a project in its chain. The task starts after the
+ * checkout.
+ *
+ * \param chains the list of the chains
+ * \param project the project
+ * \param task the name of the task, without the project's name
+ * \param command the command of the task
+ * \param workdir where to run the command
+ * \param after other tasks to wait for, even if they fail, may be NULL
+ * \param defaults the default limits of the tasks
+ */
+static void add_task(yk_chain **chains, yk_project *project, const char *task, const char *command,
+        const char *workdir, const char *after, const yk_job *defaults) {
+
+    char *name = task_name(task, project);
+    yk_job *job = jobs_create(name, workdir, command, defaults);
+
+    job->vcs = project->versioning_type;
+    if(!strcmp(task, TESTS_TASK)) {
+        job->pool = POOL_TEST;
+    }
+    job->after = task_name(REPOS_TASK, project);
+    if(after != NULL) {
+        char *afterTask = task_name(after, project);
+        job->after = realloc(job->after, strlen(job->after) + strlen(afterTask) + 2);
+        strcat(job->after, " ");
+        strcat(job->after, afterTask);
+        free(afterTask);
+    }
+    job->depends = task_depends(project, task);
+
+    jobs_add(chains, project->project_name, job);
+    free(name);
+}
+
+
+/**
+ * Add the tasks of a project.
+ *
+ * \param chains the list of the chains
+ * \param project the project
+ * \param reposDir directory of the local copies
+ * \param revision the revision of the local copy if it is the last one of
+ *        the repository, NULL if it must be updated
+ * \param mirror the shared mirror of the repository, or NULL
+ * \param defaults the default limits of the tasks
+ */
+static void add_project(yk_chain **chains, yk_project *project, const char *reposDir, const char *revision,
+        const char *mirror, const yk_job *defaults) {
+
+    yk_job limits = *defaults;
+    yk_task *task;
+    yk_job *checkout;
+    char *workdir;
+    char *command;
+    char *name;
+
+    log_info("Analysis of project %s", project->project_name);
+
+    if(project->timeout > 0) {
+        limits.timeout = project->timeout;
+    }
+    if(project->cpu_limit > 0) {
+        limits.cpuLimit = project->cpu_limit;
+    }
+
+    // checkout or update
+    command = checkout_command(project, reposDir, mirror, &workdir);
+    name = task_name(REPOS_TASK, project);
+    checkout = jobs_create(name, workdir, command, &limits);
+    checkout->pool = POOL_FETCH;
+    if(revision != NULL) {
+        // the compilation and the tests will find they are up to date too
+        checkout->upToDate = 1;
+        snprintf(checkout->revision, REVISION_SIZE, "%s", revision);
+    }
+    jobs_add(chains, project->project_name, checkout);
+    free(name);
+    free(command);
+    free(workdir);
+
+    workdir = malloc(strlen(reposDir) + strlen(project->project_name) + 2);
+    sprintf(workdir, "%s/%s", reposDir, project->project_name);
+
+    if(project->compil_cmd != NULL && project->compil_cmd[0] != '\0') {
+        add_task(chains, project, COMPILATION_TASK, project->compil_cmd, workdir, NULL, &limits);
+    }
+
+    // the tests wait for the compilation, even if it failed
+    if(project->tests_cmd != NULL && project->tests_cmd[0] != '\0') {
+        add_task(chains, project, TESTS_TASK, project->tests_cmd, workdir, COMPILATION_TASK, &limits);
+    }
+
+    for(task = project->tasks; task != NULL; task = task->next) {
+        if(task->command != NULL && task->command[0] != '\0') {
+            add_task(chains, project, task->name, task->command, workdir, NULL, &limits);
+        }
+    }
+
+    free(workdir);
+}
+
+
+/**
+ * Execute a command in a shell, writing its standard output in a file.
+ *
+ * \param workdir where to execute the command
+ * \param command the command
+ * \param filename where to write the output
+ * \param flags O_TRUNC or O_APPEND
+ * \return 0 if the command succeeded
+ */
+static int run_to_file(const char *workdir, const char *command, const char *filename, int flags) {
+
+    int wstatus;
+    pid_t pid = fork();
+
+    if(pid == -1) {
+        log_error("Can't fork to run %s", command);
+        return 1;
+    }
+
+    if(pid == 0) {
+        int fd = open(filename, O_WRONLY | O_CREAT | flags, 0644);
+        if(fd == -1 || chdir(workdir)) {
+            _exit(127);
+        }
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+        execl("/bin/sh", "sh", "-c", command, (char *) NULL);
+        _exit(127);
+    }
+
+    if(waitpid(pid, &wstatus, 0) == -1) {
+        return 1;
+    }
+
+    return !WIFEXITED(wstatus) || WEXITSTATUS(wstatus);
+}
+
+
+/**
+ * Read the last revision of a commits' history.
+ *
+ * \param marker the file containing the revision
+ * \param revision where to put the revision, empty if it is not known
+ */
+static void read_last_revision(const char *marker, char revision[REVISION_SIZE]) {
+
+    FILE *fd = fopen(marker, "r");
+
+    revision[0] = '\0';
+    if(fd == NULL) {
+        return;
+    }
+    if(fgets(revision, REVISION_SIZE, fd) == NULL) {
+        revision[0] = '\0';
+    }
+    revision[strcspn(revision, "\r\n")] = '\0';
+    fclose(fd);
+}
+
+
+/**
+ * Save the last revision of a commits' history.
+ *
+ * \param marker the file containing the revision
+ * \param revision the revision
+ * \return 0 in case of success
+ */
+static int write_last_revision(const char *marker, const char *revision) {
+
+    FILE *fd = fopen(marker, "w");
+
+    if(fd == NULL) {
+        log_error("Can't create file %s", marker);
+        return 1;
+    }
+    fprintf(fd, "%s\n", revision);
+    fclose(fd);
+    return 0;
+}
+
+
+/**
+ * Open a commits' history to add commits at its end.
+ *
+ * \param filename the history
+ * \param create 1 to replace the history by an empty one
+ * \return the opened file, or NULL in case of error
+ */
+static FILE *open_history(const char *filename, int create) {
+
+    FILE *fd = fopen(filename, create ? "w" : "a");
+
+    if(fd == NULL) {
+        log_error("Can't open file %s", filename);
+    } else if(create) {
+        fprintf(fd, HISTORY_HEADER);
+    }
+    return fd;
+}
+
+
+/**
+ * Write a field of a commits' history, between quotes if it contains the
+ * delimiter. The quotes and the ends of line of the field are replaced by
+ * spaces.
+ *
+ * \param fd the history
+ * \param field the field, may be NULL
+ * \param end the character written after the field
+ */
+static void write_history_field(FILE *fd, const char *field, char end) {
+
+    int quotes;
+
+    if(field == NULL) {
+        field = "";
+    }
+
+    quotes = (strchr(field, ';') != NULL);
+    if(quotes) {
+        fputc('"', fd);
+    }
+    for(; *field != '\0'; field++) {
+        fputc(*field == '"' || *field == '\n' || *field == '\r' ? ' ' : *field, fd);
+    }
+    if(quotes) {
+        fputc('"', fd);
+    }
+    fputc(end, fd);
+}
+
+
+/**
+ * Append the commits of a git project which follow a revision to its
+ * history.
+ *
+ * \param project the project
+ * \param yannkinsDir Yannkins' working directory
+ * \param logdir directory of the output files
+ * \param filename the history
+ * \param last the last revision of the history, empty to create it ; is
+ * set to the new last revision
+ * \return 0 in case of success
+ */
+static int append_git_commits(yk_project *project, const char *yannkinsDir, const char *logdir, const char *filename, char last[REVISION_SIZE]) {
+
+    char *workdir = malloc(strlen(yannkinsDir) + strlen(REPOS_DIR) + strlen(project->project_name) + 3);
+    char *output = malloc(strlen(logdir) + strlen(project->project_name) + 13);
+    char command[REVISION_SIZE + 100];
+    char line[GIT_LOG_LINE_SIZE];
+    FILE *in;
+    FILE *out = NULL;
+    int err;
+
+    sprintf(workdir, "%s/%s/%s", yannkinsDir, REPOS_DIR, project->project_name);
+    sprintf(output, "%s/gitlog_%s.txt", logdir, project->project_name);
+
+    // oldest first, to be appended in the chronological order
+    sprintf(command, "git log --reverse --pretty=tformat:%%H%%x1f%%h%%x1f%%an%%x1f%%ci%%x1f%%s %s%s",
+        last, last[0] != '\0' ? "..HEAD" : "HEAD");
+
+    err = run_to_file(workdir, command, output, O_TRUNC);
+    free(workdir);
+
+    in = err ? NULL : fopen(output, "r");
+    if(in != NULL) {
+        out = open_history(filename, last[0] == '\0');
+    }
+    err = (out == NULL);
+
+    while(!err && fgets(line, GIT_LOG_LINE_SIZE, in) != NULL) {
+
+        char *fields[5];
+        int eol = (strchr(line, '\n') != NULL);
+        int i;
+
+        line[strcspn(line, "\n")] = '\0';
+
+        fields[0] = line;
+        for(i = 1; i < 5; i++) {
+            fields[i] = strstr(fields[i-1], GIT_LOG_SEPARATOR);
+            if(fields[i] == NULL) {
+                break;
+            }
+            *fields[i] = '\0';
+            fields[i]++;
+        }
+
+        if(i == 5) {
+            for(i = 1; i < 5; i++) {
+                write_history_field(out, fields[i], i < 4 ? ';' : '\n');
+            }
+            strncpy(last, fields[0], REVISION_SIZE - 1);
+            last[REVISION_SIZE - 1] = '\0';
+        }
+
+        // the end of a too long line is ignored
+        while(!eol && fgets(line, GIT_LOG_LINE_SIZE, in) != NULL) {
+            eol = (strchr(line, '\n') != NULL);
+        }
+    }
+
+    if(in != NULL) {
+        fclose(in);
+    }
+    if(out != NULL) {
+        fclose(out);
+    }
+    remove(output);
+    free(output);
+    return err;
+}
+
+
+/**
+ * Append the commits of a svn project which follow a revision to its
+ * history.
+ *
+ * \param project the project
+ * \param yannkinsDir Yannkins' working directory
+ * \param logdir directory of the output files
+ * \param filename the history
+ * \param last the last revision of the history, empty to create it ; is
+ * set to the new last revision
+ * \return 0 in case of success
+ */
+static int append_svn_commits(yk_project *project, const char *yannkinsDir, const char *logdir, const char *filename, char last[REVISION_SIZE]) {
+
+    char *xmlFile = malloc(strlen(logdir) + strlen(project->project_name) + 20);
+    char *command = svn_command(project, strlen(project->repository) + REVISION_SIZE + 30);
+    xmlNode *document;
+    csv_table_t *table;
+    csv_line_t *commit;
+    FILE *out;
+    int err;
+
+    // the last revision is asked again : "LAST+1" may not exist yet
+    sprintf(command + strlen(command), " log -r %s:HEAD --xml %s", last[0] != '\0' ? last : "1", project->repository);
+
+    sprintf(xmlFile, "%s/svnlog_%s.xml", logdir, project->project_name);
+    err = run_to_file(yannkinsDir, command, xmlFile, O_TRUNC);
+    free(command);
+
+    document = err ? NULL : xml_read_file(xmlFile);
+    remove(xmlFile);
+    free(xmlFile);
+
+    if(document == NULL) {
+        return 1;
+    }
+
+    table = present_svn_log(document);
+    xml_destroy_node(document);
+
+    out = open_history(filename, last[0] == '\0');
+    err = (out == NULL);
+
+    for(commit = table->lines; !err && commit != NULL; commit = commit->next) {
+
+        int i;
+
+        if(commit->values[0] == NULL || !strcmp(commit->values[0], last)) {
+            continue;
+        }
+
+        for(i = 0; i < table->nbCol; i++) {
+            write_history_field(out, commit->values[i], i < table->nbCol - 1 ? ';' : '\n');
+        }
+        strncpy(last, commit->values[0], REVISION_SIZE - 1);
+        last[REVISION_SIZE - 1] = '\0';
+    }
+
+    if(out != NULL) {
+        fclose(out);
+    }
+    csv_destroy_table(table);
+    return err;
+}
+
+
+/**
+ * Append the new commits of a project to its history, in
+ * ${LOGDIR}/SVNLOG_${PROJECT} or ${LOGDIR}/GITLOG_${PROJECT}. The last
+ * revision of the history is kept in the same file name with the suffix
+ * ".last" : without it, the whole history is extracted again.
+ *
+ * \param project the project
+ * \param yannkinsDir Yannkins' working directory
+ * \param logdir directory of the output files
+ * \return 0 in case of success
+ */
+static int write_commits(yk_project *project, const char *yannkinsDir, const char *logdir) {
+
+    const char *tag = (project->versioning_type == GIT) ? GITLOG : SVNLOG;
+    char *filename = malloc(strlen(logdir) + strlen(tag) + strlen(project->project_name) + 3);
+    char *marker;
+    char last[REVISION_SIZE];
+    int err;
+
+    sprintf(filename, "%s/%s_%s", logdir, tag, project->project_name);
+    marker = malloc(strlen(filename) + strlen(LAST_REVISION_SUFFIX) + 1);
+    sprintf(marker, "%s%s", filename, LAST_REVISION_SUFFIX);
+
+    read_last_revision(marker, last);
+
+    if(last[0] == '\0') {
+        log_info("Extracting the history of project %s", project->project_name);
+    } else {
+        log_info("Adding the commits of project %s since revision %s", project->project_name, last);
+    }
+
+    if(project->versioning_type == GIT) {
+        err = append_git_commits(project, yannkinsDir, logdir, filename, last);
+        if(err && last[0] != '\0') {
+            // the last revision may have been removed from the history
+            log_warning("Revision %s not found, extracting the history of project %s again", last, project->project_name);
+            last[0] = '\0';
+            err = append_git_commits(project, yannkinsDir, logdir, filename, last);
+        }
+    } else {
+        err = append_svn_commits(project, yannkinsDir, logdir, filename, last);
+    }
+
+    if(!err && last[0] != '\0') {
+        err = write_last_revision(marker, last);
+    }
+
+    if(err) {
+        log_warning("Can't get the repository logs of project %s", project->project_name);
+    }
+
+    free(marker);
+    free(filename);
+    return err;
+}
+
+
+/**
+ * \brief How to analyse the projects, from the command line.
+ */
+typedef struct {
+    char *yannkinsDir; /**< \brief Yannkins' working directory */
+    char *reposDir; /**< \brief directory of the local copies */
+    char *logdir; /**< \brief directory of the output files */
+    int gitMirrors; /**< \brief 1 to clone the git repositories from shared mirrors */
+    int splitBatches; /**< \brief 1 to find the state of the tests of each new commit */
+    yk_job defaults; /**< \brief default limits of the tasks */
+    yk_schedule schedule; /**< \brief how to run the tasks */
+} yk_settings;
+
+
+/**
+ * Analyse some projects : update them, run their tasks, add their new
+ * commits to their history, bisect the tests which began to fail, then
+ * create the pages.
+ *
+ * \param settings how to analyse the projects
+ * \param projects the projects to analyse
+ * \param nbProjects number of projects
+ * \return 0 if all the tasks were executed and the pages created
+ */
+static int analyse(yk_settings *settings, yk_project **projects, int nbProjects) {
+
+    yk_chain *chains = NULL;
+    char **unchanged = NULL;
+    int err;
+    int i;
+
+    if(!settings->schedule.force && nbProjects > 0) {
+        log_info("Checking the repositories");
+        unchanged = check_remotes(projects, nbProjects, settings->reposDir, settings->schedule.nbWorkers);
+    }
+
+    if(settings->gitMirrors && nbProjects > 0) {
+        update_mirrors(projects, nbProjects, unchanged, settings->yannkinsDir, settings->schedule.nbWorkers);
+    }
+
+    for(i = 0; i < nbProjects; i++) {
+        char *mirror = NULL;
+        const char *url;
+        if(settings->gitMirrors && projects[i]->versioning_type == GIT) {
+            mirror = mirror_path(projects[i], settings->yannkinsDir, &url);
+        }
+        add_project(&chains, projects[i], settings->reposDir, unchanged != NULL ? unchanged[i] : NULL, mirror, &(settings->defaults));
+        free(mirror);
+        if(unchanged != NULL) {
+            free(unchanged[i]);
+        }
+    }
+    free(unchanged);
+
+    log_info("Running tasks");
+    err = jobs_run(chains, &(settings->schedule), settings->logdir);
+    jobs_destroy(chains);
+
+    for(i = 0; i < nbProjects; i++) {
+        write_commits(projects[i], settings->yannkinsDir, settings->logdir);
+    }
+
+    // the tests which just began to fail, or every new batch of commits
+    for(i = 0; i < nbProjects; i++) {
+        bisect_tests(projects[i], settings->reposDir, settings->logdir, &(settings->schedule), &(settings->defaults),
+            settings->splitBatches);
+    }
+
+    log_info("Creating projects' pages");
+    if(report_write(settings->yannkinsDir, settings->schedule.force, settings->schedule.nbWorkers)) {
+        err = 1;
+    }
+
+    return err;
+}
+
+
+/**
+ * \brief Step of the analysis of a project followed by the daemon.
+ */
+typedef enum {
+    STEP_IDLE, /**< \brief waiting for its next analysis */
+    STEP_CHECKING, /**< \brief asking the repository for its head revision */
+    STEP_MIRRORING, /**< \brief updating the shared mirror of the repository */
+    STEP_RUNNING, /**< \brief running its tasks */
+    STEP_HISTORY, /**< \brief adding its new commits to its history */
+    STEP_BISECTING /**< \brief bisecting its tests */
+} analysis_step_t;
+
+
+/**
+ * \brief A project followed by the daemon.
+ */
+typedef struct yk_watched_ {
+    char *file; /**< \brief name of the project's file in the projects' directory */
+    yk_project *project; /**< \brief the project's definition */
+    time_t date; /**< \brief date of the next analysis of the project, or during it of the next check of its repository */
+    time_t start; /**< \brief start date of the current analysis */
+    analysis_step_t step; /**< \brief where the analysis is */
+    int triggered; /**< \brief 1 if the project was triggered during its analysis */
+    pid_t pid; /**< \brief process checking the repository, updating the mirror or the history, -1 for none */
+    int fd; /**< \brief output of the check of the repository, -1 for none */
+    pid_t checkPid; /**< \brief process checking if the revision being built was superseded, -1 for none */
+    int checkFd; /**< \brief output of this check, -1 for none */
+    char *revision; /**< \brief revision of the local copy if it is the repository's head, or NULL */
+    char *mirror; /**< \brief the shared mirror of the repository, or NULL */
+    yk_bisection *bisection; /**< \brief the bisection of the tests, or NULL */
+    yk_chain *chain; /**< \brief the chain running the tasks or the round of the bisection, or NULL */
+    yk_project *reloaded; /**< \brief the definition read again during the analysis, or NULL */
+    int removed; /**< \brief 1 if the project's file was removed during the analysis */
+    struct yk_watched_ *next; /**< \brief the next followed project */
+} yk_watched;
+
+
+/** \brief set when the daemon must stop */
+static volatile sig_atomic_t stopping = 0;
+
+
+/**
+ * Ask the daemon to stop after the current analyses.
+ */
+static void on_stop(int signum) {
+    (void) signum;
+    stopping = 1;
+}
+
+
+/**
+ * Free a followed project. Its analysis must be done.
+ */
+static void destroy_watched(yk_watched *watched) {
+    if(watched->checkFd != -1) {
+        close(watched->checkFd);
+    }
+    yk_destroy_project(watched->project);
+    yk_destroy_project(watched->reloaded);
+    free(watched->revision);
+    free(watched->mirror);
+    free(watched->file);
+    free(watched);
+}
+
+
+/**
+ * Stop following a project. A project being analysed is only removed at
+ * the end of its analysis.
+ *
+ * \param watched the followed projects
+ * \param wheel the timers of the projects
+ * \param file the project's file
+ * \return 1 if the project was followed
+ */
+static int unwatch_project(yk_watched **watched, yk_wheel *wheel, const char *file) {
+
+    yk_watched **current;
+
+    for(current = watched; *current != NULL; current = &((*current)->next)) {
+        if(!strcmp((*current)->file, file)) {
+            yk_watched *found = *current;
+            if(found->step != STEP_IDLE) {
+                yk_destroy_project(found->reloaded);
+                found->reloaded = NULL;
+                found->removed = 1;
+                return 1;
+            }
+            *current = found->next;
+            wheel_remove(wheel, found->date, found);
+            destroy_watched(found);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * Read a project's file, and follow the project. Its first analysis is
+ * due immediately. A project being analysed takes its new definition at
+ * the end of its analysis.
+ *
+ * \param watched the followed projects
+ * \param wheel the timers of the projects
+ * \param projectsDir the projects' directory
+ * \param file the project's file
+ * \param now the current date
+ */
+static void watch_project(yk_watched **watched, yk_wheel *wheel, const char *projectsDir, const char *file, time_t now) {
+
+    yk_watched *project;
+    yk_project *definition;
+    int reloaded;
+
+    for(project = *watched; project != NULL && strcmp(project->file, file); project = project->next);
+    if(project != NULL && project->step != STEP_IDLE) {
+        yk_destroy_project(project->reloaded);
+        project->reloaded = read_project(projectsDir, file);
+        project->removed = (project->reloaded == NULL);
+        log_info("Project %s will be reloaded after its analysis", project->project->project_name);
+        return;
+    }
+
+    reloaded = unwatch_project(watched, wheel, file);
+    definition = read_project(projectsDir, file);
+    if(definition == NULL) {
+        return;
+    }
+
+    log_info("Project %s %s", definition->project_name, reloaded ? "reloaded" : "added");
+
+    project = malloc(sizeof(yk_watched));
+    project->file = strdup(file);
+    project->project = definition;
+    project->date = now;
+    project->start = 0;
+    project->step = STEP_IDLE;
+    project->triggered = 0;
+    project->pid = -1;
+    project->fd = -1;
+    project->checkPid = -1;
+    project->checkFd = -1;
+    project->revision = NULL;
+    project->mirror = NULL;
+    project->bisection = NULL;
+    project->chain = NULL;
+    project->reloaded = NULL;
+    project->removed = 0;
+    project->next = *watched;
+    *watched = project;
+    wheel_add(wheel, project->date, project);
+}
+
+
+/**
+ * Follow all the projects of the projects' directory.
+ *
+ * \param watched the followed projects
+ * \param wheel the timers of the projects
+ * \param projectsDir the projects' directory
+ * \return 0 if the directory was read
+ */
+static int watch_projects(yk_watched **watched, yk_wheel *wheel, const char *projectsDir) {
+
+    DIR *rep = opendir(projectsDir);
+    struct dirent *lecture;
+    time_t now = time(NULL);
+
+    if(rep == NULL) {
+        log_error("Can't open directory %s", projectsDir);
+        return 1;
+    }
+
+    while((lecture = readdir(rep))) {
+        if(lecture->d_type == DT_REG && yk_is_project_file(lecture->d_name)) {
+            watch_project(watched, wheel, projectsDir, lecture->d_name, now);
+        }
+    }
+
+    closedir(rep);
+    return 0;
+}
+
+
+/**
+ * Apply the changes of the projects' directory notified by inotify.
+ *
+ * \param fd the inotify descriptor
+ * \param watched the followed projects
+ * \param wheel the timers of the projects
+ * \param projectsDir the projects' directory
+ */
+static void read_events(int fd, yk_watched **watched, yk_wheel *wheel, const char *projectsDir) {
+
+    char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t length;
+
+    while((length = read(fd, buffer, sizeof(buffer))) > 0) {
+
+        char *position;
+
+        for(position = buffer; position < buffer + length; position += sizeof(struct inotify_event) + ((struct inotify_event *) position)->len) {
+
+            const struct inotify_event *event = (const struct inotify_event *) position;
+            yk_watched *project;
+            yk_watched *next;
+
+            if(event->mask & IN_Q_OVERFLOW) {
+                // events were lost : the directory is read again
+                log_warning("Too many changes in %s, reloading all the projects", projectsDir);
+                for(project = *watched; project != NULL; project = next) {
+                    next = project->next;
+                    unwatch_project(watched, wheel, project->file);
+                }
+                watch_projects(watched, wheel, projectsDir);
+                continue;
+            }
+
+            if(event->len == 0 || !yk_is_project_file(event->name)) {
+                continue;
+            }
+
+            if(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                watch_project(watched, wheel, projectsDir, event->name, time(NULL));
+            } else if(event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                if(unwatch_project(watched, wheel, event->name)) {
+                    log_info("Project file %s removed", event->name);
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * \brief A command being received on the trigger FIFO.
+ */
+typedef struct {
+    char line[TRIGGER_LINE_SIZE]; /**< \brief the beginning of the command */
+    size_t length; /**< \brief number of characters in line */
+} yk_trigger;
+
+
+/**
+ * \brief State of the daemon.
+ */
+typedef struct {
+    yk_settings *settings; /**< \brief how to analyse the projects */
+    yk_watched *watched; /**< \brief the followed projects */
+    yk_wheel *wheel; /**< \brief the timers of the projects */
+    char *projectsDir; /**< \brief the projects' directory */
+    int inotifyFd; /**< \brief inotify descriptor of the projects' directory */
+    int interval; /**< \brief seconds between two analyses of a project without POLL_INTERVAL */
+    int triggerFd; /**< \brief reading end of the trigger FIFO */
+    yk_trigger trigger; /**< \brief the command being received on the FIFO */
+    int busy; /**< \brief number of projects being analysed */
+    pid_t reportPid; /**< \brief process creating the pages, -1 for none */
+    char **analysed; /**< \brief the projects analysed since their pages were created */
+    int nbAnalysed; /**< \brief number of analysed projects */
+} yk_daemon;
+
+
+
+/**
+ * Create the trigger FIFO if needed, and open it.
+ *
+ * \param path the FIFO
+ * \param keeper set to a writing descriptor, kept open so that the reading
+ * end doesn't see the end of file when the writers close it
+ * \return the reading descriptor, or -1 in case of error
+ */
+static int open_trigger(const char *path, int *keeper) {
+
+    struct stat info;
+    int fd;
+
+    if(mkfifo(path, 0620) && errno != EEXIST) {
+        log_error("Can't create FIFO %s : %s", path, strerror(errno));
+        return -1;
+    }
+    if(stat(path, &info) || !S_ISFIFO(info.st_mode)) {
+        log_error("%s is not a FIFO", path);
+        return -1;
+    }
+
+    fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if(fd == -1) {
+        log_error("Can't open FIFO %s : %s", path, strerror(errno));
+        return -1;
+    }
+    *keeper = open(path, O_WRONLY | O_CLOEXEC);
+
+    return fd;
+}
+
+
+/**
+ * Give the revision the running tasks of a project work on.
+ *
+ * \param chain the chain of the project
+ * \return the revision, or NULL if it is not known yet
+ */
+static const char *building_revision(yk_chain *chain) {
+
+    const char *building = NULL;
+    yk_job *job;
+
+    // the revision is known once the checkout is done
+    for(job = chain != NULL ? chain->jobs : NULL; job != NULL; job = job->next) {
+        if(job->state == JOB_RUNNING && job->vcs != NONE && job->revision[0] != '\0') {
+            building = job->revision;
+        }
+    }
+    return building;
+}
+
+
+/**
+ * Ask the remote repository of a project being analysed for its head
+ * revision, without waiting for the answer : a newer revision cancels
+ * the running tasks, see end_superseded_check().
+ *
+ * \param daemon the state of the daemon
+ * \param watched the project
+ */
+static void start_superseded_check(yk_daemon *daemon, yk_watched *watched) {
+
+    if(watched->step != STEP_RUNNING || watched->checkPid > 0 || building_revision(watched->chain) == NULL) {
+        return;
+    }
+
+    watched->checkPid = start_remote_check(watched->project, daemon->settings->reposDir, &(watched->checkFd));
+    if(watched->checkPid <= 0) {
+        watched->checkPid = -1;
+        watched->checkFd = -1;
+    }
+}
+
+
+/**
+ * Cancel the tasks of a project being analysed if the revision they work
+ * on is no longer the head of the repository. The project is analysed
+ * again at once.
+ *
+ * \param watched the project
+ * \param wstatus the status of the check started by start_superseded_check()
+ */
+static void end_superseded_check(yk_watched *watched, int wstatus) {
+
+    yk_project *project = watched->project;
+    char output[2 * REVISION_SIZE + 2];
+    const char *building;
+    int superseded;
+    int err = read_check_output(project, watched->checkFd, wstatus, output, sizeof(output));
+
+    watched->checkPid = -1;
+    watched->checkFd = -1;
+
+    // the tasks may have ended meanwhile
+    building = watched->step == STEP_RUNNING ? building_revision(watched->chain) : NULL;
+    output[strcspn(output, "\n")] = '\0';
+    if(err || building == NULL || output[0] == '\0') {
+        return;
+    }
+
+    // svn gives the last changed revision of the url, maybe older than the working copy's one
+    if(project->versioning_type == SVN) {
+        superseded = atol(output) > atol(building);
+    } else {
+        superseded = strcmp(output, building) != 0;
+    }
+
+    if(superseded) {
+        log_info("Project %s : revision %s superseded by %s", project->project_name, building, output);
+        watched->triggered = 1;
+        jobs_cancel(watched->chain);
+    }
+}
+
+
+/**
+ * Give the duration between two analyses of a project.
+ *
+ * \param daemon the state of the daemon
+ * \param project the project
+ * \return the duration in seconds
+ */
+static int poll_interval(yk_daemon *daemon, yk_project *project) {
+    return project->poll_interval > 0 ? project->poll_interval : daemon->interval;
+}
+
+
+/**
+ * Fork a child doing a long work of the daemon, such as the creation of
+ * the pages, so that the scheduler goes on meanwhile. The child is reaped
+ * by reap_child().
+ *
+ * \param what the work, for the error message
+ * \return 0 in the child, its pid in the daemon, or -1 in case of error
+ */
+static pid_t fork_child(const char *what) {
+
+    pid_t pid;
+
+    // the messages not written yet would be written twice
+    fflush(NULL);
+    pid = fork();
+
+    if(pid == 0) {
+        sigset_t sigchld;
+        sigemptyset(&sigchld);
+        sigaddset(&sigchld, SIGCHLD);
+        sigprocmask(SIG_UNBLOCK, &sigchld, NULL);
+    } else if(pid == -1) {
+        log_error("Can't fork to %s : %s", what, strerror(errno));
+    }
+
+    return pid;
+}
+
+
+/**
+ * End the analysis of a project : its page will be created again, and its
+ * next analysis is planned. The project is removed, or takes its new
+ * definition, if its file changed during the analysis.
+ *
+ * \param daemon the state of the daemon
+ * \param watched the project
+ * \param analysed 1 if the tasks of the project were run
+ */
+static void end_analysis(yk_daemon *daemon, yk_watched *watched, int analysed) {
+
+    time_t now = time(NULL);
+    int delay = poll_interval(daemon, watched->project);
+
+    // the timer of the checks during the analysis
+    wheel_remove(daemon->wheel, watched->date, watched);
+
+    // a removed project leaves the index
+    if(analysed || watched->removed) {
+        daemon->analysed = realloc(daemon->analysed, (daemon->nbAnalysed + 1) * sizeof(char *));
+        daemon->analysed[daemon->nbAnalysed++] = strdup(watched->project->project_name);
+    }
+
+    watched->step = STEP_IDLE;
+    daemon->busy--;
+    free(watched->revision);
+    watched->revision = NULL;
+    free(watched->mirror);
+    watched->mirror = NULL;
+
+    if(watched->removed) {
+        yk_watched **current;
+        log_info("Project file %s removed", watched->file);
+        for(current = &(daemon->watched); *current != watched; current = &((*current)->next));
+        *current = watched->next;
+        destroy_watched(watched);
+        return;
+    }
+
+    if(watched->reloaded != NULL) {
+        log_info("Project %s reloaded", watched->reloaded->project_name);
+        yk_destroy_project(watched->project);
+        watched->project = watched->reloaded;
+        watched->reloaded = NULL;
+        watched->date = now;
+    } else {
+        // the interval is counted from the beginning of the analysis
+        watched->date = watched->triggered ? now : watched->start + delay;
+    }
+    wheel_add(daemon->wheel, watched->date, watched);
+}
+
+
+/**
+ * Add the tasks of a project to the running ones.
+ *
+ * \param daemon the state of the daemon
+ * \param watched the project
+ * \param chains the chains of the scheduler
+ */
+static void run_tasks(yk_daemon *daemon, yk_watched *watched, yk_chain **chains) {
+
+    yk_settings *settings = daemon->settings;
+    yk_chain *chain = NULL;
+    yk_chain **last;
+
+    if(stopping) {
+        end_analysis(daemon, watched, 0);
+        return;
+    }
+
+    // a chain of its own : two files may define projects of the same name
+    watched->step = STEP_RUNNING;
+    add_project(&chain, watched->project, settings->reposDir, watched->revision, watched->mirror, &(settings->defaults));
+    for(last = chains; *last != NULL; last = &((*last)->next));
+    *last = chain;
+    watched->chain = chain;
+}
+
+
+/**
+ * Update the shared mirror of the repository of a project, then run its
+ * tasks. A mirror already being updated for another project is waited for.
+ *
+ * \param daemon the state of the daemon
+ * \param watched the project
+ * \param chains the chains of the scheduler
+ */
+static void update_mirror(yk_daemon *daemon, yk_watched *watched, yk_chain **chains) {
+
+    yk_settings *settings = daemon->settings;
+    yk_watched *other;
+    const char *url;
+    char *mirrorsDir;
+
+    if(!settings->gitMirrors || watched->project->versioning_type != GIT) {
+        run_tasks(daemon, watched, chains);
+        return;
+    }
+
+    watched->mirror = mirror_path(watched->project, settings->yannkinsDir, &url);
+    if(watched->revision != NULL) {
+        run_tasks(daemon, watched, chains);
+        return;
+    }
+
+    watched->step = STEP_MIRRORING;
+    for(other = daemon->watched; other != NULL; other = other->next) {
+        if(other != watched && other->step == STEP_MIRRORING && other->pid > 0 && !strcmp(other->mirror, watched->mirror)) {
+            return;
+        }
+    }
+
+    mirrorsDir = malloc(strlen(settings->yannkinsDir) + strlen(MIRRORS_DIR) + 2);
+    sprintf(mirrorsDir, "%s/%s", settings->yannkinsDir, MIRRORS_DIR);
+    watched->pid = start_mirror_update(watched->mirror, url, mirrorsDir);
+    free(mirrorsDir);
+
+    if(watched->pid <= 0) {
+        watched->pid = -1;
+        run_tasks(daemon, watched, chains);
+    }
+}
+
+
+/**
+ * Begin the analysis of a project : ask its repository for its head
+ * revision, unless the tasks are forced. The project stays on the wheel :
+ * if its interval passes during the analysis, its repository is asked
+ * whether the revision being built was superseded.
+ *
+ * \param daemon the state of the daemon
+ * \param watched the project
+ * \param chains the chains of the scheduler
+ */
+static void start_analysis(yk_daemon *daemon, yk_watched *watched, yk_chain **chains) {
+
+    yk_settings *settings = daemon->settings;
+
+    watched->step = STEP_CHECKING;
+    watched->start = time(NULL);
+    watched->triggered = 0;
+    watched->date = watched->start + poll_interval(daemon, watched->project);
+    wheel_add(daemon->wheel, watched->date, watched);
+    daemon->busy++;
+
+    if(!settings->schedule.force) {
+        watched->pid = start_remote_check(watched->project, settings->reposDir, &(watched->fd));
+        if(watched->pid > 0) {
+            return;
+        }
+        watched->pid = -1;
+        watched->fd = -1;
+    }
+
+    update_mirror(daemon, watched, chains);
+}
+
+
+/**
+ * Execute a command received on the trigger FIFO. "run <PROJECT>" starts
+ * the analysis of the project at once, its tasks joining the running
+ * ones. The triggers received while the project is analysed only give one
+ * more analysis, and its running tasks are cancelled if their revision
+ * was superseded.
+ *
+ * \param daemon the state of the daemon
+ * \param command the command
+ * \param chains the chains of the scheduler
+ */
+static void execute_trigger(yk_daemon *daemon, char *command, yk_chain **chains) {
+
+    yk_watched *watched;
+    char *name;
+
+    command[strcspn(command, "\r")] = '\0';
+
+    if(strncmp(command, "run ", 4)) {
+        if(command[0] != '\0') {
+            log_warning("Unknown trigger command \"%s\"", command);
+        }
+        return;
+    }
+
+    for(name = command + 4; *name == ' '; name++);
+
+    for(watched = daemon->watched; watched != NULL; watched = watched->next) {
+        if(!strcmp(watched->project->project_name, name)) {
+            break;
+        }
+    }
+
+    if(watched == NULL) {
+        log_warning("Trigger for unknown project %s", name);
+    } else if(watched->step != STEP_IDLE) {
+        log_info("Project %s triggered during its analysis", name);
+        watched->triggered = 1;
+        start_superseded_check(daemon, watched);
+    } else if(stopping) {
+        log_debug("Project %s triggered while stopping", name);
+    } else {
+        log_info("Project %s triggered", name);
+        wheel_remove(daemon->wheel, watched->date, watched);
+        start_analysis(daemon, watched, chains);
+    }
+}
+
+
+/**
+ * Read the commands received on the trigger FIFO.
+ *
+ * \param daemon the state of the daemon
+ * \param chains the chains of the scheduler
+ */
+static void read_triggers(yk_daemon *daemon, yk_chain **chains) {
+
+    yk_trigger *trigger = &(daemon->trigger);
+    char buffer[512];
+    ssize_t length;
+
+    while((length = read(daemon->triggerFd, buffer, sizeof(buffer))) > 0) {
+
+        ssize_t i;
+
+        for(i = 0; i < length; i++) {
+            if(buffer[i] == '\n') {
+                trigger->line[trigger->length] = '\0';
+                execute_trigger(daemon, trigger->line, chains);
+                trigger->length = 0;
+            } else if(trigger->length < TRIGGER_LINE_SIZE - 1) {
+                trigger->line[trigger->length++] = buffer[i];
+            }
+        }
+    }
+}
+
+
+/**
+ * Start the next round of the bisection of a project, or end its analysis
+ * once the bisection is done.
+ *
+ * \param daemon the state of the daemon
+ * \param watched the project
+ * \param chains the chains of the scheduler
+ */
+static void next_round(yk_daemon *daemon, yk_watched *watched, yk_chain **chains) {
+
+    if(watched->bisection != NULL) {
+        yk_chain *round = stopping ? NULL : bisect_next_round(watched->bisection);
+        if(round != NULL) {
+            yk_chain **last;
+            for(last = chains; *last != NULL; last = &((*last)->next));
+            *last = round;
+            watched->chain = round;
+            return;
+        }
+        bisect_end(watched->bisection);
+        watched->bisection = NULL;
+    }
+
+    end_analysis(daemon, watched, 1);
+}
+
+
+/**
+ * Bisect the tests of a project whose history was updated.
+ *
+ * \param daemon the state of the daemon
+ * \param watched the project
+ * \param chains the chains of the scheduler
+ */
+static void start_bisection(yk_daemon *daemon, yk_watched *watched, yk_chain **chains) {
+
+    yk_settings *settings = daemon->settings;
+
+    // the tests which just began to fail, or every new batch of commits
+    watched->step = STEP_BISECTING;
+    if(!stopping) {
+        watched->bisection = bisect_start(watched->project, settings->reposDir, settings->logdir,
+            &(settings->schedule), &(settings->defaults), settings->splitBatches);
+    }
+    next_round(daemon, watched, chains);
+}
+
+
+/**
+ * Add the new commits of a project to its history, in a child, then
+ * bisect its tests.
+ *
+ * \param daemon the state of the daemon
+ * \param watched the project
+ * \param chains the chains of the scheduler
+ */
+static void update_history(yk_daemon *daemon, yk_watched *watched, yk_chain **chains) {
+
+    yk_settings *settings = daemon->settings;
+
+    watched->step = STEP_HISTORY;
+    watched->pid = fork_child("update the history");
+
+    if(watched->pid == 0) {
+        int err = write_commits(watched->project, settings->yannkinsDir, settings->logdir);
+        fflush(NULL);
+        _exit(err != 0);
+    }
+
+    if(watched->pid == -1) {
+        write_commits(watched->project, settings->yannkinsDir, settings->logdir);
+        start_bisection(daemon, watched, chains);
+    }
+}
+
+
+/**
+ * Reaped function of the scheduler in daemon mode : go on with the
+ * analysis of a project once its repository was checked, its mirror or
+ * its history updated, and cancel its tasks if their revision was
+ * superseded.
+ *
+ * \param chains the chains of the scheduler
+ * \param pid the terminated child
+ * \param wstatus its status
+ * \param data the state of the daemon
+ */
+static void reap_child(yk_chain **chains, pid_t pid, int wstatus, void *data) {
+
+    yk_daemon *daemon = data;
+    yk_watched *watched;
+    yk_watched *next;
+    char *mirror;
+
+    if(pid == daemon->reportPid) {
+        daemon->reportPid = -1;
+        if(!WIFEXITED(wstatus) || WEXITSTATUS(wstatus)) {
+            log_warning("Can't create the pages");
+        }
+        return;
+    }
+
+    for(watched = daemon->watched; watched != NULL && watched->checkPid != pid; watched = watched->next);
+    if(watched != NULL) {
+        end_superseded_check(watched, wstatus);
+        return;
+    }
+
+    for(watched = daemon->watched; watched != NULL && watched->pid != pid; watched = watched->next);
+    if(watched == NULL) {
+        return;
+    }
+    watched->pid = -1;
+
+    if(watched->step == STEP_CHECKING) {
+        watched->revision = read_remote_check(watched->project, watched->fd, wstatus);
+        watched->fd = -1;
+        if(stopping) {
+            end_analysis(daemon, watched, 0);
+        } else {
+            update_mirror(daemon, watched, chains);
+        }
+        return;
+    }
+
+    if(watched->step == STEP_HISTORY) {
+        start_bisection(daemon, watched, chains);
+        return;
+    }
+
+    if(!WIFEXITED(wstatus) || WEXITSTATUS(wstatus)) {
+        log_warning("Can't update the mirror %s", watched->mirror);
+    }
+
+    // the projects waiting for the same mirror go on too
+    mirror = strdup(watched->mirror);
+    for(watched = daemon->watched; watched != NULL; watched = next) {
+        next = watched->next;
+        if(watched->step == STEP_MIRRORING && watched->pid == -1 && !strcmp(watched->mirror, mirror)) {
+            run_tasks(daemon, watched, chains);
+        }
+    }
+    free(mirror);
+}
+
+
+/**
+ * Ended function of the scheduler in daemon mode : once the tasks of a
+ * project are done, add its new commits to its history and bisect its
+ * tests, a round after the other, then end its analysis.
+ *
+ * \param chains the chains of the scheduler
+ * \param chain the ended chain
+ * \param data the state of the daemon
+ */
+static void end_chain(yk_chain **chains, yk_chain *chain, void *data) {
+
+    yk_daemon *daemon = data;
+    yk_watched *watched;
+
+    for(watched = daemon->watched; watched != NULL && watched->chain != chain; watched = watched->next);
+    if(watched == NULL) {
+        jobs_destroy(chain);
+        return;
+    }
+    watched->chain = NULL;
+
+    if(watched->step == STEP_RUNNING) {
+        jobs_destroy(chain);
+        update_history(daemon, watched, chains);
+        return;
+    }
+
+    bisect_read_round(watched->bisection, chain);
+    jobs_destroy(chain);
+    next_round(daemon, watched, chains);
+}
+
+
+/**
+ * Watch function of the scheduler in daemon mode : follow the changes of
+ * the projects' directory and the triggers, start the analyses which are
+ * due, and create in a child the pages of the projects analysed since the
+ * last creation, once it is done.
+ *
+ * \param chains the chains of the scheduler
+ * \param data the state of the daemon
+ * \return 1 while the daemon runs, or still analyses projects or creates pages
+ */
+static int watch_daemon(yk_chain **chains, void *data) {
+
+    yk_daemon *daemon = data;
+    yk_settings *settings = daemon->settings;
+    int i;
+
+    read_events(daemon->inotifyFd, &(daemon->watched), daemon->wheel, daemon->projectsDir);
+    read_triggers(daemon, chains);
+
+    if(!stopping) {
+        yk_timer *expired = wheel_expire(daemon->wheel, time(NULL));
+        while(expired != NULL) {
+            yk_timer *next = expired->next;
+            yk_watched *watched = expired->data;
+            if(watched->step == STEP_IDLE) {
+                start_analysis(daemon, watched, chains);
+            } else {
+                // a poll during the analysis
+                start_superseded_check(daemon, watched);
+                watched->date += poll_interval(daemon, watched->project);
+                wheel_add(daemon->wheel, watched->date, watched);
+            }
+            free(expired);
+            expired = next;
+        }
+    }
+
+    // one creation at a time : the manifest is rewritten by each of them
+    if(daemon->nbAnalysed > 0 && daemon->reportPid == -1) {
+        log_info("Creating the pages of %d project(s)", daemon->nbAnalysed);
+        daemon->reportPid = fork_child("create the pages");
+        if(daemon->reportPid == 0) {
+            int err = report_update(settings->yannkinsDir, daemon->analysed, daemon->nbAnalysed, settings->schedule.force,
+                settings->schedule.nbWorkers);
+            fflush(NULL);
+            _exit(err != 0);
+        }
+        if(daemon->reportPid == -1) {
+            report_update(settings->yannkinsDir, daemon->analysed, daemon->nbAnalysed, settings->schedule.force,
+                settings->schedule.nbWorkers);
+        }
+        for(i = 0; i < daemon->nbAnalysed; i++) {
+            free(daemon->analysed[i]);
+        }
+        free(daemon->analysed);
+        daemon->analysed = NULL;
+        daemon->nbAnalysed = 0;
+    }
+
+    return !stopping || daemon->busy > 0 || daemon->reportPid > 0 || daemon->nbAnalysed > 0;
+}
+
+
+/**
+ * Analyse the projects periodically, each one at its own interval, until
+ * SIGTERM or SIGINT. The projects' directory is watched to follow the
+ * added, modified and removed projects, and the commands written in the
+ * FIFO ${YANNKINS_HOME}/trigger start the analysis of a project at once.
+ *
+ * All the analyses share one scheduler, which runs all the time : the
+ * tasks of a project due while others run are added at once, and the
+ * pages of a project are created again once its analysis is done.
+ *
+ * \param settings how to analyse the projects
+ * \param interval seconds between two analyses of a project without
+ * POLL_INTERVAL
+ * \return 0 if the daemon stopped normally
+ */
+static int run_daemon(yk_settings *settings, int interval) {
+
+    char *triggerPath;
+    char *mirrorsDir;
+    yk_daemon daemon;
+    struct sigaction action;
+    int keeper = -1;
+    int err;
+
+    daemon.projectsDir = malloc(strlen(settings->yannkinsDir) + strlen(PROJECTS_DIR) + 2);
+    sprintf(daemon.projectsDir, "%s/%s", settings->yannkinsDir, PROJECTS_DIR);
+
+    daemon.inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(daemon.inotifyFd == -1 || inotify_add_watch(daemon.inotifyFd, daemon.projectsDir,
+                IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE) == -1) {
+        log_error("Can't watch directory %s : %s", daemon.projectsDir, strerror(errno));
+        if(daemon.inotifyFd != -1) {
+            close(daemon.inotifyFd);
+        }
+        free(daemon.projectsDir);
+        return 1;
+    }
+
+    triggerPath = malloc(strlen(settings->yannkinsDir) + strlen(TRIGGER_FIFO) + 2);
+    sprintf(triggerPath, "%s/%s", settings->yannkinsDir, TRIGGER_FIFO);
+    daemon.triggerFd = open_trigger(triggerPath, &keeper);
+    daemon.trigger.length = 0;
+    if(daemon.triggerFd == -1) {
+        close(daemon.inotifyFd);
+        free(triggerPath);
+        free(daemon.projectsDir);
+        return 1;
+    }
+
+    if(settings->gitMirrors) {
+        mirrorsDir = malloc(strlen(settings->yannkinsDir) + strlen(MIRRORS_DIR) + 2);
+        sprintf(mirrorsDir, "%s/%s", settings->yannkinsDir, MIRRORS_DIR);
+        mkdir(mirrorsDir, 0750);
+        free(mirrorsDir);
+    }
+
+    // no SA_RESTART : the wait is interrupted
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_stop;
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGINT, &action, NULL);
+
+    daemon.settings = settings;
+    daemon.watched = NULL;
+    daemon.wheel = wheel_create(time(NULL));
+    daemon.interval = interval;
+    daemon.busy = 0;
+    daemon.reportPid = -1;
+    daemon.analysed = NULL;
+    daemon.nbAnalysed = 0;
+    watch_projects(&daemon.watched, daemon.wheel, daemon.projectsDir);
+    log_info("Daemon started, %d projects", daemon.wheel->nbTimers);
+
+    settings->schedule.watch = watch_daemon;
+    settings->schedule.ended = end_chain;
+    settings->schedule.reaped = reap_child;
+    settings->schedule.watchData = &daemon;
+
+    err = jobs_run(NULL, &(settings->schedule), settings->logdir);
+
+    log_info("Daemon stopped");
+
+    if(daemon.reportPid > 0) {
+        waitpid(daemon.reportPid, NULL, 0);
+    }
+
+    // the analyses are all ended, unless the scheduler failed
+    while(daemon.watched != NULL) {
+        yk_watched *watched = daemon.watched;
+        daemon.watched = watched->next;
+        if(watched->pid > 0) {
+            kill(watched->pid, SIGTERM);
+            waitpid(watched->pid, NULL, 0);
+        }
+        if(watched->fd != -1) {
+            close(watched->fd);
+        }
+        if(watched->checkPid > 0) {
+            kill(watched->checkPid, SIGTERM);
+            waitpid(watched->checkPid, NULL, 0);
+        }
+        if(watched->bisection != NULL) {
+            bisect_end(watched->bisection);
+        }
+        destroy_watched(watched);
+    }
+    wheel_destroy(daemon.wheel);
+    close(daemon.inotifyFd);
+    close(daemon.triggerFd);
+    if(keeper != -1) {
+        close(keeper);
+    }
+    free(daemon.analysed);
+    free(triggerPath);
+    free(daemon.projectsDir);
+    return err;
+}
+
+
+int main(int argc, char **argv) {
+
+    yk_project **projects;
+    yk_settings settings;
+    char *agents = NULL;
+    char *secretFile = NULL;
+    int daemon = 0;
+    int interval = DEFAULT_INTERVAL;
+    int nbProjects;
+    int err = 0;
+    int i;
+    long size;
+    int c;
+    struct option options[] = {
+        { "jobs", required_argument, NULL, 'j' },
+        { "timeout", required_argument, NULL, 't' },
+        { "cpu-limit", required_argument, NULL, 'c' },
+        { "head", required_argument, NULL, 'H' },
+        { "tail", required_argument, NULL, 'T' },
+        { "compress", no_argument, NULL, 'z' },
+        { "make-jobs", required_argument, NULL, 'm' },
+        { "memory", required_argument, NULL, 'r' },
+        { "pools", required_argument, NULL, 'P' },
+        { "git-mirrors", no_argument, NULL, 'M' },
+        { "split-batches", no_argument, NULL, 'S' },
+        { "agents", required_argument, NULL, 'A' },
+        { "agents-secret", required_argument, NULL, 'K' },
+        { "force", no_argument, NULL, 'f' },
+        { "daemon", no_argument, NULL, 'd' },
+        { "interval", required_argument, NULL, 'i' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    settings.schedule.nbWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    if(settings.schedule.nbWorkers < 1) {
+        settings.schedule.nbWorkers = 1;
+    }
+    settings.schedule.makeJobs = settings.schedule.nbWorkers;
+    settings.schedule.memory = 0;
+    settings.schedule.pools[POOL_FETCH] = FETCH_WORKERS;
+    settings.schedule.pools[POOL_BUILD] = 0;
+    settings.schedule.pools[POOL_TEST] = 0;
+    settings.schedule.force = 0;
+    settings.schedule.watch = NULL;
+    settings.schedule.ended = NULL;
+    settings.schedule.reaped = NULL;
+    settings.schedule.watchData = NULL;
+    settings.schedule.agents = NULL;
+    settings.defaults.timeout = 0;
+    settings.defaults.cpuLimit = 0;
+    settings.defaults.capture.head = -1;
+    settings.defaults.capture.tail = 0;
+    settings.defaults.capture.compress = 0;
+    settings.defaults.vcs = NONE;
+    settings.defaults.pool = POOL_BUILD;
+    settings.gitMirrors = 0;
+    settings.splitBatches = 0;
+
+    while ((c = getopt_long(argc, argv, "j:t:c:m:zfdi:", options, NULL)) != -1) {
+        switch(c) {
+            case 'j':
+                settings.schedule.nbWorkers = atoi(optarg);
+                if(settings.schedule.nbWorkers < 1) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'm':
+                settings.schedule.makeJobs = atoi(optarg);
+                break;
+            case 'r':
+                size = capture_parse_size(optarg);
+                if(size < 0) {
+                    usage(argv[0]);
+                }
+                settings.schedule.memory = size / 1024;
+                break;
+            case 'P':
+                if(jobs_parse_pools(settings.schedule.pools, optarg)) {
+                    usage(argv[0]);
+                }
+                break;
+            case 't':
+                settings.defaults.timeout = atoi(optarg);
+                break;
+            case 'c':
+                settings.defaults.cpuLimit = atoi(optarg);
+                break;
+            case 'H':
+                settings.defaults.capture.head = capture_parse_size(optarg);
+                if(settings.defaults.capture.head < 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'T':
+                settings.defaults.capture.tail = capture_parse_size(optarg);
+                if(settings.defaults.capture.tail < 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'z':
+                settings.defaults.capture.compress = 1;
+                break;
+            case 'f':
+                settings.schedule.force = 1;
+                break;
+            case 'M':
+                settings.gitMirrors = 1;
+                break;
+            case 'S':
+                settings.splitBatches = 1;
+                break;
+            case 'A':
+                agents = optarg;
+                break;
+            case 'K':
+                secretFile = optarg;
+                break;
+            case 'd':
+                daemon = 1;
+                break;
+            case 'i':
+                interval = yk_parse_duration(optarg);
+                if(interval <= 0) {
+                    usage(argv[0]);
+                }
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if(argc != optind) {
+        usage(argv[0]);
+    }
+
+    settings.yannkinsDir = getenv("YANNKINS_HOME");
+    if(settings.yannkinsDir == NULL) {
+        fprintf(stderr, "Warning : Environment variable YANNKINS_HOME not found. Using %s.\n", YANNKINS_DIR);
+        settings.yannkinsDir = YANNKINS_DIR;
+    }
+
+    // the report reads its templates in ${YANNKINS_HOME}/www
+    if(chdir(settings.yannkinsDir)) {
+        fprintf(stderr, "Can't go in directory %s\n", settings.yannkinsDir);
+        return 1;
+    }
+
+    init_log(LOG_LEVEL_INFO);
+
+    settings.logdir = jobs_logdir(settings.yannkinsDir);
+    if(settings.logdir == NULL) {
+        close_log();
+        return 1;
+    }
+
+    if(agents != NULL) {
+        char *secret = secretFile != NULL ? agents_read_secret(secretFile) : NULL;
+        settings.schedule.agents = (secretFile == NULL || secret != NULL) ? agents_listen(agents, secret) : NULL;
+        free(secret);
+        if(settings.schedule.agents == NULL) {
+            free(settings.logdir);
+            close_log();
+            return 1;
+        }
+    }
+
+    settings.reposDir = malloc(strlen(settings.yannkinsDir) + strlen(REPOS_DIR) + 2);
+    sprintf(settings.reposDir, "%s/%s", settings.yannkinsDir, REPOS_DIR);
+    mkdir(settings.reposDir, 0750);
+
+    if(daemon) {
+        err = run_daemon(&settings, interval);
+    } else {
+        projects = read_projects(settings.yannkinsDir, &nbProjects);
+        err = analyse(&settings, projects, nbProjects);
+        for(i = 0; i < nbProjects; i++) {
+            yk_destroy_project(projects[i]);
+        }
+        free(projects);
+    }
+
+    agents_close(settings.schedule.agents);
+    free(settings.reposDir);
+    free(settings.logdir);
+    close_log();
+    return err;
+}
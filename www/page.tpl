@@ -0,0 +1,12 @@
+<!DOCTYPE html>
+<html>
+    <head>
+        <title>${TITLE}</title>
+        <meta charset="utf-8">
+        <link rel="stylesheet" href="style/style.css">
+    </head>
+    <body>
+${include bandeau.html}
+${BODY}
+    </body>
+</html>